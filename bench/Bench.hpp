@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef BENCH_HPP
+#define BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Timing helpers of the benchmark executables. Each benchmark is a single translation unit
+ * including this header once, and prints its results as a table.
+ */
+
+/** Read by the logging macros of the code under test; only errors are printed. */
+uint8_t verbosity = 1;
+
+namespace ob::bench
+{
+    /**
+     * @brief Keeps the compiler from discarding @p value as unused.
+     */
+    template <typename T>
+    inline void keep(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /**
+     * @brief Runs @p f until it has taken at least @p min_ms, after a warm-up call.
+     * @return The average time of one call, in nanoseconds.
+     */
+    template <typename F>
+    double nsPerCall(F &&f, unsigned min_ms = 200)
+    {
+        using clock = std::chrono::steady_clock;
+        f();
+        uint64_t calls = 0;
+        const auto start = clock::now();
+        auto elapsed = clock::duration::zero();
+        do
+        {
+            for (unsigned i = 0; i < 64; i++)
+                f();
+            calls += 64;
+            elapsed = clock::now() - start;
+        } while (elapsed < std::chrono::milliseconds(min_ms));
+        return std::chrono::duration<double, std::nano>(elapsed).count() / static_cast<double>(calls);
+    }
+}
+
+#endif // BENCH_HPP
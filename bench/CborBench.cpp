@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cstdio>
+
+#include "Bench.hpp"
+#include "ReportBatch.hpp"
+#include "SystemInfo.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * Encodes a report of this machine with toJson() and toCbor(), alone and as a batch, and
+ * prints the time and size of each encoding.
+ */
+
+namespace
+{
+    constexpr size_t batch_samples = 10;
+}
+
+static void report(const char *name, size_t json_size, double json_ns, size_t cbor_size, double cbor_ns)
+{
+    printf("%-8s %10zu %10zu %7.2fx %11.1f %11.1f %8.2fx\n", name, json_size, cbor_size,
+           static_cast<double>(json_size) / cbor_size, json_ns / 1000, cbor_ns / 1000, json_ns / cbor_ns);
+}
+
+/**
+ * @brief Times the encoding of a batch of @p sysinfo, repeated, in @p format.
+ * @return The time of one batch, in nanoseconds; its size in @p size.
+ */
+static double batchNs(SystemInfo &sysinfo, ReportFormat format, size_t &size)
+{
+    ReportBatch batch(batch_samples, 0, false, format);
+    return bench::nsPerCall([&]
+    {
+        batch.clear();
+        for (size_t i = 0; i < batch_samples; i++)
+            batch.add(sysinfo);
+        size = batch.finish().size();
+    });
+}
+
+int main()
+{
+    SystemInfo sysinfo;
+    sysinfo.readSysInfo();
+
+    printf("%-8s %10s %10s %8s %11s %11s %9s\n", "report", "json B", "cbor B", "smaller", "json us", "cbor us",
+           "faster");
+
+    const size_t json_size = sysinfo.toJson().size();
+    const size_t cbor_size = sysinfo.toCbor().size();
+    report("sample", json_size, bench::nsPerCall([&] { bench::keep(sysinfo.toJson()); }), cbor_size,
+           bench::nsPerCall([&] { bench::keep(sysinfo.toCbor()); }));
+
+    size_t json_batch = 0, cbor_batch = 0;
+    const double json_batch_ns = batchNs(sysinfo, ReportFormat::json, json_batch);
+    const double cbor_batch_ns = batchNs(sysinfo, ReportFormat::cbor, cbor_batch);
+    report("batch-10", json_batch, json_batch_ns, cbor_batch, cbor_batch_ns);
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Bench.hpp"
+#include "Compressor.hpp"
+#include "ReportBatch.hpp"
+#include "SystemInfo.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * Compresses reports of this machine, single and batched, with every algorithm the build
+ * supports, and prints the bytes saved against the CPU time spent.
+ */
+
+struct Payload
+{
+    const char *name;
+    string body;
+};
+
+struct Algorithm
+{
+    const char *name;
+    Compression compression;
+    int level;
+};
+
+/**
+ * @brief Returns a batch of @p samples reports, taken a few milliseconds apart so they differ.
+ */
+static string batchOf(SystemInfo &sysinfo, size_t samples, bool pretty)
+{
+    ReportBatch batch(samples, 0, pretty);
+    for (size_t i = 0; i < samples; i++)
+    {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        sysinfo.readSysInfo();
+        batch.add(sysinfo);
+    }
+    return string(batch.finish());
+}
+
+int main()
+{
+    SystemInfo sysinfo;
+    SystemInfo pretty_sysinfo({.pretty_json = true});
+    sysinfo.readSysInfo();
+    pretty_sysinfo.readSysInfo();
+
+    const vector<Payload> payloads = {
+        {"sample", string(sysinfo.toJson())},
+        {"sample-pretty", string(pretty_sysinfo.toJson())},
+        {"batch-10", batchOf(sysinfo, 10, false)},
+        {"batch-60", batchOf(sysinfo, 60, false)},
+    };
+
+    vector<Algorithm> algorithms = {
+        {"gzip:1", Compression::gzip, 1},
+        {"gzip", Compression::gzip, 0},
+        {"gzip:9", Compression::gzip, 9},
+    };
+#ifdef HAVE_ZSTD
+    algorithms.push_back({"zstd:1", Compression::zstd, 1});
+    algorithms.push_back({"zstd", Compression::zstd, 0});
+    algorithms.push_back({"zstd:19", Compression::zstd, 19});
+    algorithms.push_back({"zstd-dict", Compression::zstd_dictionary, 0});
+#endif
+
+    printf("%-14s %-10s %9s %9s %7s %11s %9s\n", "payload", "algorithm", "bytes", "out", "ratio", "us/call",
+           "MB/s");
+    for (const auto &payload : payloads)
+    {
+        for (const auto &algorithm : algorithms)
+        {
+            Compressor compressor(algorithm.compression, algorithm.level);
+            string out;
+            if (!compressor.compress(payload.body, out))
+            {
+                fprintf(stderr, "%s failed on %s\n", algorithm.name, payload.name);
+                return 1;
+            }
+            const double ns = bench::nsPerCall([&] { compressor.compress(payload.body, out); });
+            printf("%-14s %-10s %9zu %9zu %6.2fx %11.1f %9.1f\n", payload.name, algorithm.name, payload.body.size(),
+                   out.size(), static_cast<double>(payload.body.size()) / out.size(), ns / 1000,
+                   payload.body.size() / ns * 1000);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cstdio>
+#include <string>
+#include <json-c/json.h>
+
+#include "Bench.hpp"
+#include "JsonWriter.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * Serializes the report of the json-c version of SystemInfo::toJson() both ways: a json-c
+ * object tree printed and copied into a string, as it used to, and JsonWriter reusing its
+ * buffer. The two outputs must be identical.
+ */
+
+struct Report
+{
+    string hostname = "remarkable-3f2a";
+    int64_t uptime = 1234567;
+    struct
+    {
+        int64_t total = 7188228, free = 1843304, used = 4978712, available = 2209516;
+        double usage_percentage = 69.26238148428922;
+    } disk;
+    struct
+    {
+        int64_t total = 2016732, used = 612540, free = 134220, shared = 9812, cached = 1269972, available = 1297708;
+    } memory;
+};
+
+static string jsonc(const Report &r, int flags)
+{
+    json_object *root = json_object_new_object();
+    json_object *disk = json_object_new_object();
+    json_object *mem = json_object_new_object();
+
+    json_object_object_add(root, "hostname", json_object_new_string(r.hostname.c_str()));
+    json_object_object_add(root, "uptime", json_object_new_int64(r.uptime));
+
+    json_object_object_add(disk, "total", json_object_new_int64(r.disk.total));
+    json_object_object_add(disk, "free", json_object_new_int64(r.disk.free));
+    json_object_object_add(disk, "used", json_object_new_int64(r.disk.used));
+    json_object_object_add(disk, "available", json_object_new_int64(r.disk.available));
+    json_object_object_add(disk, "usage_percentage", json_object_new_double(r.disk.usage_percentage));
+    json_object_object_add(root, "disk", disk);
+
+    json_object_object_add(mem, "total", json_object_new_int64(r.memory.total));
+    json_object_object_add(mem, "used", json_object_new_int64(r.memory.used));
+    json_object_object_add(mem, "free", json_object_new_int64(r.memory.free));
+    json_object_object_add(mem, "shared", json_object_new_int64(r.memory.shared));
+    json_object_object_add(mem, "cached", json_object_new_int64(r.memory.cached));
+    json_object_object_add(mem, "available", json_object_new_int64(r.memory.available));
+    json_object_object_add(root, "memory", mem);
+
+    string out(json_object_to_json_string_ext(root, flags));
+    json_object_put(root);
+    return out;
+}
+
+static string_view writer(JsonWriter &json, const Report &r)
+{
+    json.reset();
+    json.beginObject();
+    json.member("hostname", r.hostname);
+    json.member("uptime", r.uptime);
+
+    json.key("disk");
+    json.beginObject();
+    json.member("total", r.disk.total);
+    json.member("free", r.disk.free);
+    json.member("used", r.disk.used);
+    json.member("available", r.disk.available);
+    json.member("usage_percentage", r.disk.usage_percentage);
+    json.endObject();
+
+    json.key("memory");
+    json.beginObject();
+    json.member("total", r.memory.total);
+    json.member("used", r.memory.used);
+    json.member("free", r.memory.free);
+    json.member("shared", r.memory.shared);
+    json.member("cached", r.memory.cached);
+    json.member("available", r.memory.available);
+    json.endObject();
+
+    json.endObject();
+    return json.view();
+}
+
+int main()
+{
+    const Report report;
+    printf("%-8s %12s %12s %10s\n", "output", "json-c ns", "writer ns", "speedup");
+
+    for (const bool pretty : {false, true})
+    {
+        const int flags = pretty ? JSON_C_TO_STRING_PRETTY : JSON_C_TO_STRING_PLAIN;
+        JsonWriter json(pretty);
+        if (jsonc(report, flags) != writer(json, report))
+        {
+            fprintf(stderr, "json-c and JsonWriter disagree:\n%s\n%.*s\n", jsonc(report, flags).c_str(),
+                    static_cast<int>(json.view().size()), json.view().data());
+            return 1;
+        }
+
+        const double jsonc_ns = bench::nsPerCall([&] { bench::keep(jsonc(report, flags)); });
+        const double writer_ns = bench::nsPerCall([&] { bench::keep(writer(json, report)); });
+        printf("%-8s %12.1f %12.1f %9.1fx\n", pretty ? "pretty" : "plain", jsonc_ns, writer_ns, jsonc_ns / writer_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "Bench.hpp"
+#include "Procfs.hpp"
+#include "ProcfsFixtures.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * Parses the same fixtures with sscanf(), as the collectors did before procfs::Scanner, and
+ * with the tokenizer, reading the same fields both ways.
+ */
+
+struct Meminfo
+{
+    uint64_t total, available, cached, shmem;
+};
+
+static Meminfo meminfoSscanf(const string &text)
+{
+    Meminfo m{};
+    const char *p = text.c_str();
+    while (*p)
+    {
+        sscanf(p, "MemTotal: %" SCNu64, &m.total);
+        sscanf(p, "MemAvailable: %" SCNu64, &m.available);
+        sscanf(p, "Cached: %" SCNu64, &m.cached);
+        sscanf(p, "Shmem: %" SCNu64, &m.shmem);
+        const char *nl = strchr(p, '\n');
+        p = nl ? nl + 1 : p + strlen(p);
+    }
+    return m;
+}
+
+static Meminfo meminfoScanner(string_view text)
+{
+    static constexpr auto keys = procfs::makeKeySet("MemTotal", "MemAvailable", "Cached", "Shmem");
+    Meminfo m{};
+    uint64_t *const fields[] = {&m.total, &m.available, &m.cached, &m.shmem};
+    procfs::Scanner scanner(text);
+    procfs::Line line;
+    while (scanner.next(line))
+    {
+        const int idx = keys.find(line.key());
+        if (idx >= 0)
+            line.u64(*fields[idx]);
+    }
+    return m;
+}
+
+static uint64_t diskstatsSscanf(const string &text)
+{
+    uint64_t sum = 0;
+    const char *p = text.c_str();
+    while (*p)
+    {
+        unsigned major, minor;
+        char name[32];
+        uint64_t reads, merged, sectors, ms, writes;
+        if (sscanf(p, "%u %u %31s %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64, &major, &minor, name,
+                   &reads, &merged, &sectors, &ms, &writes) == 8)
+            sum += reads + sectors + writes;
+        const char *nl = strchr(p, '\n');
+        p = nl ? nl + 1 : p + strlen(p);
+    }
+    return sum;
+}
+
+static uint64_t diskstatsScanner(string_view text)
+{
+    uint64_t sum = 0;
+    procfs::Scanner scanner(text);
+    procfs::Line line;
+    while (scanner.next(line))
+    {
+        uint64_t major, minor;
+        if (!line.u64(major) || !line.u64(minor))
+            continue;
+        line.token();
+        const uint64_t reads = line.u64();
+        line.skip(1);
+        const uint64_t sectors = line.u64();
+        line.skip(1);
+        sum += reads + sectors + line.u64();
+    }
+    return sum;
+}
+
+static void report(const char *name, double sscanf_ns, double scanner_ns)
+{
+    printf("%-10s %12.1f %12.1f %9.1fx\n", name, sscanf_ns, scanner_ns, sscanf_ns / scanner_ns);
+}
+
+int main()
+{
+    const string meminfo(fixtures::meminfo);
+    const string diskstats(fixtures::diskstats);
+
+    if (meminfoSscanf(meminfo).total != meminfoScanner(meminfo).total ||
+        diskstatsSscanf(diskstats) != diskstatsScanner(diskstats))
+    {
+        fprintf(stderr, "sscanf and the tokenizer disagree\n");
+        return 1;
+    }
+
+    printf("%-10s %12s %12s %10s\n", "file", "sscanf ns", "scanner ns", "speedup");
+    report("meminfo", bench::nsPerCall([&] { bench::keep(meminfoSscanf(meminfo)); }),
+           bench::nsPerCall([&] { bench::keep(meminfoScanner(meminfo)); }));
+    report("diskstats", bench::nsPerCall([&] { bench::keep(diskstatsSscanf(diskstats)); }),
+           bench::nsPerCall([&] { bench::keep(diskstatsScanner(diskstats)); }));
+    return 0;
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "MetricSchema.hpp"
+
+namespace ob
+{
+    /**
+     * @class Arena
+     * @brief Fixed-size memory region serving every C++ heap allocation of the daemon.
+     *
+     * Built with -DENABLE_ARENA=ON, the global operator new and delete are replaced: once
+     * Arena::create() has been called, allocations are carved from a single mapping
+     * reserved at startup instead of the C heap, so the daemon's memory cannot grow past
+     * the arena. An allocation that does not fit throws std::bad_alloc, which the daemon
+     * handles by shedding optional collectors (see SystemInfo::shed()).
+     *
+     * Blocks are rounded up to a power of two and freed blocks are kept on one free list
+     * per size, so the steady-state cycle, which keeps allocating the same sizes, reuses
+     * them instead of carving new memory. Allocations made before create() and by C
+     * libraries (libcurl) still come from malloc().
+     */
+    class Arena
+    {
+    public:
+        /**
+         * @struct Stats
+         * @brief Arena usage, in bytes.
+         */
+        struct Stats
+        {
+            size_t capacity;
+            size_t carved;      ///< High-water mark of the arena: memory ever handed out to blocks.
+            size_t in_use;      ///< Size of the blocks currently allocated.
+            size_t in_use_peak; ///< High-water mark of in_use.
+            uint64_t failed;    ///< Allocations refused because the arena was full.
+        };
+
+        /**
+         * @brief Maps an arena of @p capacity bytes and routes operator new to it.
+         * @return The arena, or nullptr if the mapping failed or an arena already exists.
+         */
+        static Arena *create(size_t capacity);
+
+        /**
+         * @brief The arena created by create(), or nullptr.
+         */
+        static Arena *get() noexcept;
+
+        /**
+         * @return A block of at least @p size bytes aligned to @p alignment, or nullptr if
+         *         the arena is full.
+         */
+        void *allocate(size_t size, size_t alignment) noexcept;
+
+        /**
+         * @brief Returns a block obtained from allocate() to its free list.
+         */
+        void deallocate(void *ptr) noexcept;
+
+        /**
+         * @brief Whether @p ptr points into the arena.
+         */
+        bool owns(const void *ptr) const noexcept
+        {
+            return ptr >= base && ptr < base + capacity;
+        }
+
+        Stats stats() noexcept;
+
+    private:
+        static constexpr size_t min_block_shift = 5; ///< Smallest block: 32 bytes, header included.
+        static constexpr size_t num_classes = 64 - min_block_shift;
+        static constexpr size_t max_alignment = 4096;
+
+        /** Precedes every block handed out; sized to keep the payload 16-byte aligned. */
+        struct alignas(16) Header
+        {
+            uint32_t size_class;
+            uint32_t offset;    ///< Distance from the start of the block to the payload.
+            size_t requested;   ///< Bytes accounted in in_use.
+        };
+
+        struct FreeBlock
+        {
+            FreeBlock *next;
+        };
+
+        Arena(char *base, size_t capacity);
+
+        static size_t blockSize(size_t size_class)
+        {
+            return size_t(1) << (size_class + min_block_shift);
+        }
+
+        std::mutex lock;
+        char *const base;
+        const size_t capacity;
+        size_t carved = 0;
+        size_t in_use = 0;
+        size_t in_use_peak = 0;
+        uint64_t failed = 0;
+        FreeBlock *free_lists[num_classes] = {};
+    };
+
+    template <>
+    struct Schema<Arena::Stats>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&Arena::Stats::capacity>("capacity", Unit::bytes),
+            field<&Arena::Stats::carved>("carved", Unit::bytes),
+            field<&Arena::Stats::in_use>("in_use", Unit::bytes),
+            field<&Arena::Stats::in_use_peak>("in_use_peak", Unit::bytes),
+            field<&Arena::Stats::failed>("failed"));
+    };
+}
+
+#endif // ARENA_HPP
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef BLOCKDEVICECOLLECTOR_HPP
+#define BLOCKDEVICECOLLECTOR_HPP
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "MetricSchema.hpp"
+#include "Procfs.hpp"
+
+namespace ob
+{
+    /**
+     * @struct BlockDeviceStats
+     * @brief I/O activity of one block device since the previous sample.
+     *
+     * Activity on partitions is included in the device they belong to.
+     */
+    struct BlockDeviceStats
+    {
+        char name[32];               ///< Kernel device name (DISK_NAME_LEN).
+        double read_iops;
+        double write_iops;
+        double read_bytes_per_s;
+        double write_bytes_per_s;
+        double read_latency_ms;      ///< Average time per completed read.
+        double write_latency_ms;     ///< Average time per completed write.
+        double queue_depth;          ///< Average number of requests in flight.
+        double utilization;          ///< Percentage of time the device was busy.
+    };
+
+    template <>
+    struct Schema<BlockDeviceStats>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&BlockDeviceStats::name>("name"),
+            field<&BlockDeviceStats::read_iops>("read_iops", Unit::per_second),
+            field<&BlockDeviceStats::write_iops>("write_iops", Unit::per_second),
+            field<&BlockDeviceStats::read_bytes_per_s>("read_bytes_per_s", Unit::bytes_per_second),
+            field<&BlockDeviceStats::write_bytes_per_s>("write_bytes_per_s", Unit::bytes_per_second),
+            field<&BlockDeviceStats::read_latency_ms>("read_latency_ms", Unit::msec),
+            field<&BlockDeviceStats::write_latency_ms>("write_latency_ms", Unit::msec),
+            field<&BlockDeviceStats::queue_depth>("queue_depth"),
+            field<&BlockDeviceStats::utilization>("utilization", Unit::percent));
+    };
+
+    /**
+     * @class BlockDeviceCollector
+     * @brief Samples /proc/diskstats and derives per-device I/O rates from counter deltas.
+     *
+     * Only whole devices are reported: the kernel already accounts partition I/O to the
+     * parent device, so partition rows are recognized (through sysfs) and skipped rather
+     * than added on top. Devices that never did any I/O are left out.
+     */
+    class BlockDeviceCollector
+    {
+    public:
+        /**
+         * @enum error
+         * @brief Enumerates possible errors for the BlockDeviceCollector class.
+         */
+        enum class error
+        {
+            read_failed /**< /proc/diskstats could not be read. */
+        };
+
+        /**
+         * @brief Opens /proc/diskstats.
+         * @throws std::runtime_error if /proc/diskstats cannot be opened.
+         */
+        BlockDeviceCollector();
+
+        /**
+         * @brief Takes a new sample and computes the rates since the previous one.
+         * @param[out] devices One entry per active device; its storage is reused between calls.
+         * @return std::optional<error> An optional error code; empty if successful.
+         */
+        std::optional<error> collect(std::vector<BlockDeviceStats> &devices);
+
+    private:
+        /** Counter columns of /proc/diskstats used, in file order after the device name. */
+        enum counter
+        {
+            reads,
+            reads_merged,
+            sectors_read,
+            read_ms,
+            writes,
+            writes_merged,
+            sectors_written,
+            write_ms,
+            ios_in_progress,
+            io_ticks,
+            time_in_queue,
+            num_counters
+        };
+
+        /** A device row of /proc/diskstats and its counters at the previous sample. */
+        struct Device
+        {
+            uint32_t major;
+            uint32_t minor;
+            char name[32];
+            bool is_partition;
+            bool seen;   ///< Present in the latest sample.
+            uint64_t counters[num_counters];
+        };
+
+        procfs::File diskstats_file; ///< Persistent /proc/diskstats handle.
+        std::vector<Device> devices_state;
+        uint64_t previous_ns = 0;    ///< CLOCK_MONOTONIC time of the previous sample.
+
+        Device *findDevice(uint32_t major, uint32_t minor, size_t hint);
+    };
+}
+
+#endif // BLOCKDEVICECOLLECTOR_HPP
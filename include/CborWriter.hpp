@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef CBORWRITER_HPP
+#define CBORWRITER_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "JsonWriter.hpp"
+
+namespace ob
+{
+    /**
+     * @class CborWriter
+     * @brief Streams CBOR (RFC 8949) into a reusable buffer, with the interface of JsonWriter.
+     *
+     * A report serialized with either writer has the same structure, so the serializers are
+     * templates over the writer type. Objects and arrays are written with indefinite lengths,
+     * as their size is not known when they are opened. Integers take the smallest encoding
+     * that holds them, and doubles are written as single-precision floats when that is exact.
+     *
+     * reset() keeps the buffer, so once it has grown to the size of a report no further
+     * allocation happens.
+     */
+    class CborWriter
+    {
+    public:
+        /**
+         * @struct Checkpoint
+         * @brief Position in the document that rewind() can return to.
+         */
+        struct Checkpoint
+        {
+            size_t size;
+        };
+
+    private:
+        std::string buf;
+
+        void appendHead(uint8_t major, uint64_t argument);
+        void valueInt(int64_t v);
+        void valueUint(uint64_t v) { appendHead(0, v); }
+
+    public:
+        /**
+         * @brief Discards the document written so far, keeping the buffer's capacity.
+         */
+        void reset() { buf.clear(); }
+
+        void beginObject() { buf.push_back(static_cast<char>(0xbf)); }
+        void endObject() { buf.push_back(static_cast<char>(0xff)); }
+        void beginArray() { buf.push_back(static_cast<char>(0x9f)); }
+        void endArray() { buf.push_back(static_cast<char>(0xff)); }
+
+        /**
+         * @brief Records the current position, to discard what is written after it with rewind().
+         */
+        Checkpoint checkpoint() const { return {buf.size()}; }
+
+        /**
+         * @brief Discards everything written since @p cp was taken. Never allocates.
+         */
+        void rewind(const Checkpoint &cp) { buf.resize(cp.size); }
+
+        /**
+         * @brief Writes the key of the next member of the current object.
+         */
+        void key(std::string_view k) { value(k); }
+
+        void value(std::string_view v);
+        void value(const char *v) { value(std::string_view(v)); }
+        void value(double v);
+        void value(bool v) { buf.push_back(static_cast<char>(v ? 0xf5 : 0xf4)); }
+
+        template <std::integral T>
+        void value(T v)
+        {
+            if constexpr (std::is_signed_v<T>)
+                valueInt(v);
+            else
+                valueUint(v);
+        }
+
+        /**
+         * @brief Writes a member of the current object.
+         */
+        template <typename T>
+        void member(std::string_view k, const T &v)
+        {
+            key(k);
+            value(v);
+        }
+
+        /**
+         * @brief The document written since the last reset().
+         */
+        std::string_view view() const { return buf; }
+    };
+
+    /**
+     * @brief Rewrites a CBOR document produced by CborWriter as JSON.
+     *
+     * Used to fall back to JSON for reports already encoded. Numbers keep their type, so the
+     * result is what JsonWriter would have written for the same report.
+     *
+     * @return false if @p cbor is not a well-formed document of the subset CborWriter produces.
+     */
+    bool cborToJson(std::string_view cbor, JsonWriter &json);
+}
+
+#endif // CBORWRITER_HPP
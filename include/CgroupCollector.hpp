@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef CGROUPCOLLECTOR_HPP
+#define CGROUPCOLLECTOR_HPP
+
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MetricSchema.hpp"
+
+namespace ob
+{
+    /**
+     * @struct CgroupStats
+     * @brief Resource usage of one cgroup, including its descendants.
+     */
+    struct CgroupStats
+    {
+        std::string path;               ///< Path below the cgroup2 mount, "/" for the root.
+        uint64_t memory_current;        ///< KiB, from memory.current.
+        uint64_t memory_high_events;    ///< From memory.events.
+        uint64_t memory_max_events;
+        uint64_t memory_oom_events;
+        uint64_t memory_oom_kill_events;
+        uint64_t cpu_usage_usec;        ///< From cpu.stat.
+        double cpu_percentage;          ///< CPU usage since the previous sample, 100 per fully used core.
+        uint64_t nr_throttled;
+        uint64_t throttled_usec;
+        uint64_t io_rbytes;             ///< From io.stat, summed over all devices.
+        uint64_t io_wbytes;
+        uint64_t io_rios;
+        uint64_t io_wios;
+    };
+
+    template <>
+    struct Schema<CgroupStats>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&CgroupStats::path>("path"),
+            field<&CgroupStats::memory_current>("memory_current", Unit::kib),
+            field<&CgroupStats::memory_high_events>("memory_high_events"),
+            field<&CgroupStats::memory_max_events>("memory_max_events"),
+            field<&CgroupStats::memory_oom_events>("memory_oom_events"),
+            field<&CgroupStats::memory_oom_kill_events>("memory_oom_kill_events"),
+            field<&CgroupStats::cpu_usage_usec>("cpu_usage_usec", Unit::usec),
+            field<&CgroupStats::cpu_percentage>("cpu_percentage", Unit::percent),
+            field<&CgroupStats::nr_throttled>("nr_throttled"),
+            field<&CgroupStats::throttled_usec>("throttled_usec", Unit::usec),
+            field<&CgroupStats::io_rbytes>("io_rbytes", Unit::bytes),
+            field<&CgroupStats::io_wbytes>("io_wbytes", Unit::bytes),
+            field<&CgroupStats::io_rios>("io_rios"),
+            field<&CgroupStats::io_wios>("io_wios"));
+    };
+
+    /**
+     * @class CgroupCollector
+     * @brief Reports per-cgroup resource usage from the cgroup v2 hierarchy.
+     *
+     * The tree is walked once, down to `max_depth` levels below the root (the default of 2
+     * covers `system.slice/<unit>.service`), and a directory descriptor is kept per cgroup so
+     * the stat files are opened relative to it. Each cgroup directory and its cgroup.events
+     * file are watched with inotify: cgroups created or removed only trigger a re-scan of their
+     * parent, and cgroups that are not populated, according to cgroup.events, are not read.
+     *
+     * Both a pure cgroup v2 system (/sys/fs/cgroup) and the hybrid layout
+     * (/sys/fs/cgroup/unified) are supported; without cgroup v2 nothing is reported.
+     */
+    class CgroupCollector
+    {
+    public:
+        /**
+         * @enum error
+         * @brief Enumerates possible errors for the CgroupCollector class.
+         */
+        enum class error
+        {
+            inotify_failed /**< The inotify queue overflowed or could not be read. */
+        };
+
+        /**
+         * @brief Finds the cgroup v2 mount and scans the hierarchy.
+         * @param max_depth Levels reported below the root cgroup.
+         */
+        CgroupCollector(unsigned max_depth);
+
+        /**
+         * @brief Closes every descriptor and the inotify instance.
+         */
+        ~CgroupCollector();
+
+        CgroupCollector(const CgroupCollector &) = delete;
+        CgroupCollector &operator=(const CgroupCollector &) = delete;
+
+        /**
+         * @brief Applies the pending hierarchy changes and reads every populated cgroup.
+         * @param[out] cgroups One entry per populated cgroup; its storage is reused between calls.
+         * @return std::optional<error> An optional error code; empty if successful.
+         */
+        std::optional<error> collect(std::vector<CgroupStats> &cgroups);
+
+    private:
+        /** A cgroup being tracked. */
+        struct Node
+        {
+            int dirfd = -1;
+            unsigned depth = 0;
+            int dir_wd = -1;      ///< Watch on the directory, for created/removed children.
+            int events_wd = -1;   ///< Watch on cgroup.events, for population changes.
+            bool populated = true;
+            bool rescan = false;  ///< Children changed since the last scan.
+            bool reread_events = false;
+            uint64_t previous_usage_usec = 0;
+        };
+
+        std::string root;                       ///< cgroup2 mount point, empty if there is none.
+        unsigned max_depth;
+        int inotify_fd = -1;
+        std::map<std::string, Node> nodes;       ///< Keyed by path; a subtree is a contiguous range.
+        std::unordered_map<int, std::string> watches; ///< inotify watch descriptor to node path.
+        uint64_t previous_ns = 0;               ///< CLOCK_MONOTONIC time of the previous sample.
+        std::vector<char> events_buf;
+
+        void addSubtree(const std::string &path, int dirfd, unsigned depth);
+        void removeSubtree(const std::string &path);
+        void rescanChildren(const std::string &path, Node &node);
+        void readPopulated(Node &node);
+        bool drainEvents();
+        void readStats(const std::string &path, Node &node, CgroupStats &stats, double elapsed_us);
+    };
+}
+
+#endif // CGROUPCOLLECTOR_HPP
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef COLUMNARWRITER_HPP
+#define COLUMNARWRITER_HPP
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "FlatWriter.hpp"
+#include "JsonWriter.hpp"
+
+namespace ob
+{
+    /**
+     * @class ColumnarWriter
+     * @brief Encodes a batch of samples column by column, with Gorilla-style compression.
+     *
+     * Every sample is taken as the leaves recorded by a FlatWriter. Each path becomes a column
+     * holding its values across the batch, so each value is encoded against the previous one
+     * of the same field:
+     *
+     * - the `timestamp` column as delta-of-deltas, bucketed as in Gorilla: 1 bit when
+     *   samples are evenly spaced;
+     * - other integers as zig-zag varints of their delta;
+     * - doubles XORed with the previous value, storing only the bits in between the leading
+     *   and trailing zeros, or a single bit when the value is unchanged;
+     * - strings as a single byte when unchanged, bools as a bit.
+     *
+     * Columns are kept in document order: a path seen for the first time is placed after
+     * the path before it in its sample. A column that is missing from some samples, like the
+     * fields of a mount that appeared mid-batch, carries a bitmap of the samples it is in.
+     *
+     * The document starts with "OBC" and a version byte, followed by varints for the number
+     * of samples and of columns. Each column then has its path (varint length and bytes), its
+     * type, a byte telling whether a presence bitmap follows, then its values prefixed with
+     * their length, so that a reader can skip the columns it does not need. Bit streams are
+     * written most significant bit first, and padded to a byte at the end of a column.
+     *
+     * Values are encoded as the samples are added, so the batch never holds more than its
+     * encoded size; reset() keeps every buffer for the next batch.
+     */
+    class ColumnarWriter
+    {
+    public:
+        /**
+         * @brief Adds a sample; a sample that does not fit in memory leaves the batch as it was.
+         * @throws std::bad_alloc in arena mode, before anything is written.
+         */
+        void add(std::span<const FlatWriter::Entry> sample);
+
+        /**
+         * @brief Returns the encoded batch; valid until the next add() or reset().
+         */
+        std::string_view finish();
+
+        /**
+         * @brief Empties the batch, keeping its buffers.
+         */
+        void reset();
+
+        size_t size() const { return samples; }
+
+    private:
+        /**
+         * @struct Bits
+         * @brief Bit stream, most significant bit first.
+         */
+        struct Bits
+        {
+            std::string bytes;
+            unsigned used = 8; ///< Bits taken in the last byte.
+
+            void write(uint64_t value, unsigned count);
+            void writeVarint(uint64_t value);
+            void reserve(size_t more_bytes) { bytes.reserve(bytes.size() + more_bytes); }
+            void clear();
+        };
+
+        struct Column
+        {
+            std::string path;
+            uint8_t type;
+            Bits presence;
+            Bits values;
+            size_t present = 0;         ///< Samples with a value.
+            uint64_t stamp = 0;         ///< Last add() that gave the column a value.
+            size_t position = 0;        ///< Index in `order`.
+            uint64_t previous = 0;      ///< Last integer, or bits of the last double.
+            int64_t previous_delta = 0; ///< Last delta, for timestamps.
+            unsigned leading = 0;       ///< XOR window of the last double.
+            unsigned trailing = 0;
+            bool window = false;
+            std::string previous_string;
+        };
+
+        std::vector<Column> columns;
+        std::vector<size_t> order; ///< Indices in `columns`, in document order.
+        std::unordered_map<std::string, size_t> index; ///< Path and type to index in `columns`.
+        std::vector<size_t> resolved; ///< Column of each entry of the sample being added.
+        std::string lookup;
+        std::string out;
+        size_t samples = 0;
+        uint64_t attempt = 0; ///< Calls to add().
+
+        size_t resolve(const FlatWriter::Entry &entry, size_t &cursor);
+        void encode(Column &column, const FlatWriter::Value &value);
+    };
+
+    /**
+     * @brief Rewrites a batch encoded by ColumnarWriter as a JSON array of samples.
+     *
+     * Used to fall back to JSON for batches already encoded. The result is what JsonWriter
+     * would have written for the same samples.
+     *
+     * @return false if @p columnar is not a well-formed batch.
+     */
+    bool columnarToJson(std::string_view columnar, JsonWriter &json);
+}
+
+#endif // COLUMNARWRITER_HPP
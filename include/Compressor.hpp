@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef COMPRESSOR_HPP
+#define COMPRESSOR_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <string_view>
+
+struct z_stream_s;
+struct ZSTD_CCtx_s;
+struct ZSTD_CDict_s;
+
+namespace ob
+{
+    /**
+     * @enum Compression
+     * @brief Request body encodings.
+     */
+    enum class Compression
+    {
+        none,
+        gzip,
+        zstd,           /**< Only available in builds with libzstd (HAVE_ZSTD). */
+        zstd_dictionary /**< zstd with the dictionary embedded at build time, trained on reports. */
+    };
+
+    /**
+     * @brief Returns the Content-Encoding token of @p compression, or "" for Compression::none.
+     *
+     * Both zstd variants are "zstd"; the dictionary is identified by a separate header.
+     */
+    std::string_view compressionName(Compression compression);
+
+    /**
+     * @brief Parses "none", "gzip", "zstd" or "zstd-dict".
+     */
+    std::optional<Compression> parseCompression(std::string_view name);
+
+    /**
+     * @struct CompressionConfig
+     * @brief How HTTPClient compresses request bodies.
+     */
+    struct CompressionConfig
+    {
+        Compression algorithm = Compression::none;
+        size_t min_size = 1024; ///< Bodies below this size are sent as is; compressing them does not pay.
+        int level = 0;          ///< Algorithm-specific level; 0 for the library's default.
+    };
+
+    /**
+     * @class Compressor
+     * @brief Compresses buffers with one algorithm, reusing its context between calls.
+     *
+     * The context is allocated once, so compressing does not allocate once the output buffer
+     * has grown to the size of a compressed report.
+     */
+    class Compressor
+    {
+    public:
+        /**
+         * @throws std::runtime_error if the context cannot be created, or zstd is not available.
+         */
+        Compressor(Compression algorithm, int level);
+
+        ~Compressor();
+
+        Compressor(const Compressor &) = delete;
+        Compressor &operator=(const Compressor &) = delete;
+
+        /**
+         * @brief Replaces @p out with the compressed form of @p in.
+         * @return false if compression failed; @p out is then unspecified.
+         */
+        bool compress(std::string_view in, std::string &out);
+
+        Compression algorithm() const { return compression; }
+
+        /**
+         * @brief ID of the dictionary the frames are compressed with, 0 if none.
+         *
+         * It is also recorded in each frame; the server needs the same dictionary to decode them.
+         */
+        unsigned dictionaryId() const { return dictionary_id; }
+
+    private:
+        Compression compression;
+        struct z_stream_s *deflate_stream = nullptr;
+        struct ZSTD_CCtx_s *zstd_context = nullptr;
+        struct ZSTD_CDict_s *zstd_dictionary = nullptr;
+        unsigned dictionary_id = 0;
+    };
+}
+
+#endif // COMPRESSOR_HPP
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef CPUCOLLECTOR_HPP
+#define CPUCOLLECTOR_HPP
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "MetricSchema.hpp"
+#include "Procfs.hpp"
+
+namespace ob
+{
+    /**
+     * @struct CpuUsage
+     * @brief CPU time split in percentages of the interval between two samples.
+     *
+     * `user` includes nice time and `irq` includes softirq time.
+     */
+    struct CpuUsage
+    {
+        double user;
+        double system;
+        double iowait;
+        double steal;
+        double irq;
+        double idle;
+    };
+
+    template <>
+    struct Schema<CpuUsage>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&CpuUsage::user>("user", Unit::percent),
+            field<&CpuUsage::system>("system", Unit::percent),
+            field<&CpuUsage::iowait>("iowait", Unit::percent),
+            field<&CpuUsage::steal>("steal", Unit::percent),
+            field<&CpuUsage::irq>("irq", Unit::percent),
+            field<&CpuUsage::idle>("idle", Unit::percent));
+    };
+
+    /**
+     * @struct CpuStats
+     * @brief Aggregate and per-core CPU utilization plus scheduler counters.
+     */
+    struct CpuStats
+    {
+        CpuUsage total;
+        std::vector<CpuUsage> cores; ///< Indexed by CPU number; offline cores read as all zeroes, idle included.
+        uint64_t context_switches;   ///< Context switches per second.
+        uint64_t procs_running;      ///< Runnable tasks at sampling time.
+    };
+
+    /**
+     * @class CpuCollector
+     * @brief Samples /proc/stat and turns counter deltas into utilization percentages.
+     *
+     * The raw counters of every CPU are kept in one contiguous array (one row of
+     * `num_counters` per CPU, the aggregate first), so the previous sample costs a
+     * single buffer regardless of the number of cores. The first sample reports the
+     * averages since boot.
+     */
+    class CpuCollector
+    {
+    public:
+        /**
+         * @enum error
+         * @brief Enumerates possible errors for the CpuCollector class.
+         */
+        enum class error
+        {
+            read_failed,  /**< /proc/stat could not be read. */
+            parse_failed  /**< /proc/stat did not have the expected layout. */
+        };
+
+        /**
+         * @brief Opens /proc/stat.
+         * @throws std::runtime_error if /proc/stat cannot be opened.
+         */
+        CpuCollector();
+
+        /**
+         * @brief Takes a new sample and computes utilization since the previous one.
+         * @param[out] stats Filled with the new utilization; its storage is reused between calls.
+         * @return std::optional<error> An optional error code; empty if successful.
+         */
+        std::optional<error> collect(CpuStats &stats);
+
+    private:
+        /** Counter columns kept per CPU, in /proc/stat order. */
+        enum counter
+        {
+            user,
+            nice,
+            system,
+            idle,
+            iowait,
+            irq,
+            softirq,
+            steal,
+            num_counters
+        };
+
+        procfs::File stat_file;        ///< Persistent /proc/stat handle.
+        std::vector<uint64_t> current; ///< Counters of the latest sample, `num_counters` per row.
+        std::vector<uint64_t> previous;///< Counters of the sample before it.
+        uint64_t previous_ctxt = 0;    ///< Context switch counter of the previous sample.
+        uint64_t previous_ns = 0;      ///< CLOCK_MONOTONIC time of the previous sample.
+
+        void computeUsage(size_t row, CpuUsage &usage) const;
+    };
+}
+
+#endif // CPUCOLLECTOR_HPP
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef DELTAENCODER_HPP
+#define DELTAENCODER_HPP
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "CborWriter.hpp"
+#include "FlatWriter.hpp"
+#include "JsonWriter.hpp"
+#include "ReportFormat.hpp"
+#include "SystemInfo.hpp"
+
+namespace ob
+{
+    /**
+     * @struct Deadband
+     * @brief Change below which a numeric field is not reported.
+     */
+    struct Deadband
+    {
+        std::string field; ///< Trailing segments of the paths covered, `*` matching any: "memory.used", "cores.*.idle".
+        double threshold;
+        bool relative; ///< @p threshold is a percentage of the last value sent.
+    };
+
+    /**
+     * @brief Parses "<field>=<threshold>" or "<field>=<threshold>%".
+     */
+    std::optional<Deadband> parseDeadband(std::string_view spec);
+
+    /**
+     * @struct DeltaConfig
+     * @brief Settings of a DeltaEncoder.
+     */
+    struct DeltaConfig
+    {
+        unsigned keyframe_interval = 60; ///< Messages from one keyframe to the next.
+        std::vector<Deadband> deadbands; ///< The last one matching a field applies.
+    };
+
+    /**
+     * @class DeltaEncoder
+     * @brief Encodes reports as a stream of keyframes and of the fields that changed in between.
+     *
+     * Every message carries the stream it belongs to, a random number drawn at startup, and
+     * its sequence number in that stream. A keyframe holds the whole report:
+     *
+     *     {"stream": 3735928559, "sequence": 120, "keyframe": true, "report": {...}}
+     *
+     * The messages in between only hold the values that changed since they were last sent, by
+     * path (see FlatWriter), and the paths that are gone, e.g. of a mount that disappeared:
+     *
+     *     {"stream": 3735928559, "sequence": 121, "set": {"uptime": 3612, "memory.used": 802816},
+     *      "remove": ["mounts.3.free", ...]}
+     *
+     * Objects and arrays left with no members are set to `{}` or `[]`. The receiver applies a
+     * message only if it has applied the previous one, and should answer anything else with 409
+     * Conflict, after which the next message is a keyframe.
+     *
+     * A numeric field covered by a Deadband is only sent once it has moved past the threshold
+     * from the value last sent, so slow drifts are still reported while jitter is not.
+     */
+    class DeltaEncoder
+    {
+    public:
+        explicit DeltaEncoder(const DeltaConfig &config, bool pretty = false);
+
+        /**
+         * @brief Encodes the current report of @p sysinfo as the next message of the stream.
+         *
+         * @param standalone The message will not be delivered in order, e.g. because it is
+         *                   spooled; it is sent as a keyframe, and so is the next one.
+         * @return The message, valid until the next call.
+         * @throws std::bad_alloc in arena mode if the report does not fit.
+         */
+        std::string_view encode(SystemInfo &sysinfo, ReportFormat format, bool standalone = false);
+
+        /**
+         * @brief Encodes @p report, the leaves a FlatWriter recorded, as the next message of the stream.
+         *
+         * Same as above; a keyframe rebuilds the report from its leaves.
+         */
+        std::string_view encode(std::span<const FlatWriter::Entry> report, ReportFormat format,
+                                bool standalone = false);
+
+        /**
+         * @brief Makes the next message a keyframe, e.g. after a message was lost.
+         */
+        void requestKeyframe() { keyframe_requested = true; }
+
+        /**
+         * @brief Whether @p payload is a message of the stream other than a keyframe.
+         *
+         * Such a message only applies after the one before it, so it cannot be spooled and
+         * delivered later.
+         */
+        static bool isDelta(std::string_view payload);
+
+    private:
+        /**
+         * @struct Sent
+         * @brief Last value of a field the receiver knows.
+         */
+        struct Sent
+        {
+            FlatWriter::Value value;
+            const Deadband *deadband = nullptr;
+            uint64_t seen = 0; ///< Sequence number of the last report that had the field.
+        };
+
+        DeltaConfig config;
+        uint32_t stream;
+        uint64_t sequence = 0;
+        unsigned since_keyframe = 0;
+        bool keyframe_requested = true;
+
+        FlatWriter flat; ///< Report of the SystemInfo being encoded.
+        std::unordered_map<std::string, Sent> sent;
+        std::vector<const FlatWriter::Entry *> changes; ///< Entries of the report being encoded.
+        std::vector<std::string> removed;               ///< Paths of the report being encoded.
+        JsonWriter json;
+        CborWriter cbor;
+
+        const Deadband *deadbandOf(std::string_view path) const;
+        void track(std::span<const FlatWriter::Entry> report, bool keyframe);
+
+        template <typename Writer>
+        void write(Writer &writer, std::span<const FlatWriter::Entry> report, bool keyframe);
+    };
+}
+
+#endif // DELTAENCODER_HPP
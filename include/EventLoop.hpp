@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef EVENTLOOP_HPP
+#define EVENTLOOP_HPP
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <unordered_map>
+
+namespace ob
+{
+    /**
+     * @class EventLoop
+     * @brief Single-threaded epoll loop dispatching descriptor events to handlers.
+     *
+     * Everything the daemon waits on goes through it: the sampling timer, signals (through
+     * a signalfd), PSI triggers and the sockets of the uploads in flight. Handlers may add
+     * and remove descriptors, including their own, while being dispatched.
+     */
+    class EventLoop
+    {
+    public:
+        /** Receives the epoll events reported on the descriptor. */
+        using Handler = std::function<void(uint32_t events)>;
+
+        /**
+         * @throws std::runtime_error if the epoll instance cannot be created.
+         */
+        EventLoop();
+
+        /**
+         * @brief Closes the epoll instance and the signalfd; other descriptors are left open.
+         */
+        ~EventLoop();
+
+        EventLoop(const EventLoop &) = delete;
+        EventLoop &operator=(const EventLoop &) = delete;
+
+        /**
+         * @brief Starts watching @p fd for @p events (EPOLLIN, EPOLLOUT, EPOLLPRI...).
+         * @return false if epoll refused the descriptor.
+         */
+        bool add(int fd, uint32_t events, Handler handler);
+
+        /**
+         * @brief Changes the events watched on @p fd.
+         */
+        bool modify(int fd, uint32_t events);
+
+        /**
+         * @brief Stops watching @p fd. Does nothing if it is not watched.
+         */
+        void remove(int fd);
+
+        /**
+         * @brief Blocks @p signals and delivers them to @p handler through a signalfd.
+         *
+         * Unlike a signal handler, @p handler runs from the loop, so it can do anything.
+         *
+         * @throws std::runtime_error if the signalfd cannot be created.
+         */
+        void handleSignals(std::initializer_list<int> signals, std::function<void(int)> handler);
+
+        /**
+         * @brief Waits up to @p timeout_ms (-1: forever) for events and dispatches them.
+         */
+        void poll(int timeout_ms);
+
+        /**
+         * @brief Dispatches events until stop() is called.
+         */
+        void run();
+
+        /**
+         * @brief Makes run() return once the current handler does.
+         */
+        void stop() { stopped = true; }
+
+        bool isStopped() const { return stopped; }
+
+    private:
+        int epoll_fd = -1;
+        int signal_fd = -1;
+        bool stopped = false;
+        /** Shared so that dispatching keeps a handler alive without copying it. */
+        std::unordered_map<int, std::shared_ptr<Handler>> handlers;
+    };
+
+    /**
+     * @class Timer
+     * @brief timerfd-based timer dispatched by an EventLoop.
+     *
+     * Expirations are absolute: a periodic timer fires at `start + n * period` no matter how
+     * long its handler runs, so it never drifts.
+     */
+    class Timer
+    {
+    public:
+        /**
+         * @param clock   CLOCK_MONOTONIC or CLOCK_REALTIME.
+         * @param handler Called once per expiration; missed expirations are coalesced.
+         * @throws std::runtime_error if the timerfd cannot be created.
+         */
+        Timer(EventLoop &loop, clockid_t clock, std::function<void()> handler);
+
+        ~Timer();
+
+        Timer(const Timer &) = delete;
+        Timer &operator=(const Timer &) = delete;
+
+        /**
+         * @brief Fires every @p period_ns, at the multiples of the period on the timer's clock.
+         *
+         * On CLOCK_REALTIME, a 1 s period fires on every wall-clock second. If the clock is set,
+         * the timer is re-aligned to the new time.
+         */
+        void setAligned(uint64_t period_ns);
+
+        /**
+         * @brief Fires once, @p delay_ns from now.
+         */
+        void setOnce(uint64_t delay_ns);
+
+        /**
+         * @brief Disarms the timer.
+         */
+        void cancel();
+
+    private:
+        EventLoop &loop;
+        clockid_t clock;
+        int fd;
+        uint64_t aligned_period_ns = 0; ///< Period of setAligned(), 0 otherwise.
+        std::function<void()> handler;
+
+        void onReadable();
+    };
+}
+
+#endif // EVENTLOOP_HPP
@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef FLATWRITER_HPP
+#define FLATWRITER_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace ob
+{
+    /**
+     * @class FlatWriter
+     * @brief Records a document as a list of leaf values and their paths, with the interface of JsonWriter.
+     *
+     * A path joins the keys and array indices leading to its value with dots: `memory.used`,
+     * `mounts.0.free`. Keys are not escaped, which is unambiguous as long as they have no dots
+     * and are not numbers, as is the case for every key of a report. Objects and arrays with no
+     * members are recorded as leaves too, so the document can be rebuilt from its entries.
+     *
+     * reset() keeps the entries and their strings, so once a report has been recorded, recording
+     * another one with the same paths allocates nothing.
+     */
+    class FlatWriter
+    {
+    public:
+        /**
+         * @enum Empty
+         * @brief Value of an entry recorded for an object or array with no members.
+         */
+        enum class Empty
+        {
+            object,
+            array
+        };
+
+        using Value = std::variant<int64_t, uint64_t, double, bool, std::string, Empty>;
+
+        /**
+         * @struct Entry
+         * @brief One leaf of the document.
+         */
+        struct Entry
+        {
+            std::string path;
+            Value value;
+        };
+
+        /**
+         * @struct Checkpoint
+         * @brief Position in the document that rewind() can return to.
+         */
+        struct Checkpoint
+        {
+            size_t count;
+            size_t path_size;
+            size_t depth;
+            size_t index; ///< Next index of the enclosing array.
+        };
+
+    private:
+        static constexpr size_t max_depth = 16;
+
+        struct Level
+        {
+            size_t path_size;   ///< Length of the path of the container.
+            bool array;
+            size_t index;       ///< Index of the next element, in an array.
+            size_t first_entry; ///< Entries recorded before the container was opened.
+        };
+
+        std::vector<Entry> entries_; ///< Grows only; the first `count` are the document.
+        size_t count = 0;
+        std::string path;
+        std::string pending_key;
+        Level levels[max_depth] = {};
+        size_t depth = 0;
+
+        void enter();
+        void leave();
+        Entry &record();
+        void open(bool array);
+        void close();
+        void valueString(std::string_view v);
+
+    public:
+        /**
+         * @brief Discards the document recorded so far, keeping the entries' buffers.
+         */
+        void reset();
+
+        void beginObject() { open(false); }
+        void endObject() { close(); }
+        void beginArray() { open(true); }
+        void endArray() { close(); }
+
+        /**
+         * @brief Records the current position, to discard what is written after it with rewind().
+         */
+        Checkpoint checkpoint() const
+        {
+            return {count, path.size(), depth, depth > 0 ? levels[depth - 1].index : 0};
+        }
+
+        /**
+         * @brief Discards everything written since @p cp was taken. Never allocates.
+         */
+        void rewind(const Checkpoint &cp)
+        {
+            count = cp.count;
+            path.resize(cp.path_size);
+            depth = cp.depth;
+            if (depth > 0)
+                levels[depth - 1].index = cp.index;
+        }
+
+        /**
+         * @brief Sets the key of the next member of the current object.
+         *
+         * Cleared and appended rather than assigned: GCC 12 sees a false overlap in an inlined
+         * std::string::assign() and warns with -Wrestrict.
+         */
+        void key(std::string_view k)
+        {
+            pending_key.clear();
+            pending_key.append(k);
+        }
+
+        void value(std::string_view v) { valueString(v); }
+        void value(const char *v) { valueString(v); }
+        void value(double v);
+        void value(bool v);
+
+        template <std::integral T>
+        void value(T v)
+        {
+            enter();
+            if constexpr (std::is_signed_v<T>)
+                record().value = static_cast<int64_t>(v);
+            else
+                record().value = static_cast<uint64_t>(v);
+            leave();
+        }
+
+        /**
+         * @brief Writes a member of the current object.
+         */
+        template <typename T>
+        void member(std::string_view k, const T &v)
+        {
+            key(k);
+            value(v);
+        }
+
+        /**
+         * @brief The leaves recorded since the last reset(), in document order.
+         */
+        std::span<const Entry> entries() const { return {entries_.data(), count}; }
+    };
+
+    /**
+     * @class DocumentBuilder
+     * @brief Writes a document from the leaves a FlatWriter recorded, reopening the objects and
+     *        arrays their paths go through.
+     *
+     * @p Writer has the interface of JsonWriter; CborWriter works too. The leaves are given one
+     * by one, in document order, inside an object the caller opened; a segment made of digits
+     * is an array index. The leaf of an empty root, with an empty path, writes nothing.
+     */
+    template <typename Writer>
+    class DocumentBuilder
+    {
+    public:
+        explicit DocumentBuilder(Writer &writer) : writer(writer) {}
+
+        /**
+         * @brief Writes the leaf at @p path.
+         * @return false if @p path is nested deeper than a FlatWriter records.
+         */
+        bool add(std::string_view path, const FlatWriter::Value &value)
+        {
+            if (path.empty())
+                return true;
+
+            segments.clear();
+            for (size_t start = 0;;)
+            {
+                const size_t dot = path.find('.', start);
+                segments.push_back(path.substr(start, dot - start));
+                if (dot == std::string_view::npos)
+                    break;
+                start = dot + 1;
+            }
+
+            size_t common = 0;
+            while (common < open.size() && common + 1 < segments.size() && open[common].segment == segments[common])
+                common++;
+            while (open.size() > common)
+                closeLevel();
+
+            for (size_t i = open.size(); i + 1 < segments.size(); i++)
+            {
+                if (open.size() + 1 >= max_depth)
+                    return false;
+                keyOf(segments[i]);
+                const bool array = isIndex(segments[i + 1]);
+                if (array)
+                    writer.beginArray();
+                else
+                    writer.beginObject();
+                open.push_back({segments[i], array});
+            }
+
+            keyOf(segments.back());
+            writeValue(writer, value);
+            return true;
+        }
+
+        /**
+         * @brief Closes the objects and arrays left open by the last leaf.
+         */
+        void finish()
+        {
+            while (!open.empty())
+                closeLevel();
+        }
+
+        /**
+         * @brief Writes @p value, as `{}` or `[]` for an empty container.
+         */
+        static void writeValue(Writer &writer, const FlatWriter::Value &value)
+        {
+            std::visit([&](const auto &v)
+            {
+                using T = std::decay_t<decltype(v)>;
+                if constexpr (std::is_same_v<T, FlatWriter::Empty>)
+                {
+                    if (v == FlatWriter::Empty::array)
+                    {
+                        writer.beginArray();
+                        writer.endArray();
+                    }
+                    else
+                    {
+                        writer.beginObject();
+                        writer.endObject();
+                    }
+                }
+                else if constexpr (std::is_same_v<T, std::string>)
+                {
+                    writer.value(std::string_view(v));
+                }
+                else
+                {
+                    writer.value(v);
+                }
+            }, value);
+        }
+
+    private:
+        /** One less than FlatWriter, for the object the caller opened. */
+        static constexpr size_t max_depth = 15;
+
+        struct Level
+        {
+            std::string_view segment;
+            bool array;
+        };
+
+        Writer &writer;
+        std::vector<Level> open;
+        std::vector<std::string_view> segments;
+
+        static bool isIndex(std::string_view segment)
+        {
+            return !segment.empty() && segment.find_first_not_of("0123456789") == std::string_view::npos;
+        }
+
+        void keyOf(std::string_view segment)
+        {
+            // elements of an array are written in order, their index is implied
+            if (open.empty() || !open.back().array)
+                writer.key(segment);
+        }
+
+        void closeLevel()
+        {
+            if (open.back().array)
+                writer.endArray();
+            else
+                writer.endObject();
+            open.pop_back();
+        }
+    };
+}
+
+#endif // FLATWRITER_HPP
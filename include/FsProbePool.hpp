@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef FSPROBEPOOL_HPP
+#define FSPROBEPOOL_HPP
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <sys/statfs.h>
+
+namespace ob
+{
+    /**
+     * @struct FsProbe
+     * @brief A statfs() call on one path, run by an FsProbePool.
+     *
+     * Probes are shared with the worker running them, so a worker stuck on a hung
+     * filesystem never touches memory the collector has since released.
+     */
+    struct FsProbe
+    {
+        /**
+         * @enum status
+         * @brief State of the last probe of the path.
+         */
+        enum class status
+        {
+            ok,     /**< statfs() succeeded in this round; `result` holds its output. */
+            failed, /**< statfs() failed in this round. */
+            stale   /**< statfs() has not returned in this round. */
+        };
+
+        std::string path;
+
+        // guarded by the pool mutex
+        bool in_flight = false; ///< Queued or running.
+        bool running = false;
+        bool hung = false;      ///< Its worker was written off and replaced.
+        bool reserved = false;  ///< Runs on the reserved worker.
+        bool ok = false;
+        uint64_t round = 0;          ///< Round it was last submitted in.
+        uint64_t done_round = 0;     ///< Round its last statfs() returned in.
+        uint64_t held_until = 0;     ///< Round before which it is not submitted again.
+        std::chrono::steady_clock::time_point started; ///< When its worker picked it up.
+        struct statfs result = {}; ///< Output of the last successful statfs().
+    };
+
+    /**
+     * @class FsProbePool
+     * @brief Runs statfs() probes on a small pool of threads, with a deadline per probe.
+     *
+     * Each probe is given the timeout of wait() from the moment a worker picks it up, so a
+     * probe queued behind slow ones is not charged for their time; a round never waits more
+     * than a few timeouts in total. A probe that does not return in time is reported as stale
+     * and is not submitted again until its worker comes back.
+     *
+     * When a probe overruns its deadline while others are queued, its worker is written off
+     * and replaced, up to `max_threads` threads, so hung mounts cannot starve the others. A
+     * probe that was in flight for `hung_rounds` rounds or more is left out, once it returns,
+     * for as many rounds, so a mount that keeps hanging does not take a worker every time.
+     *
+     * Probes submitted as reserved run on a worker of their own, so that the root filesystem
+     * is never queued behind hung mounts.
+     */
+    class FsProbePool
+    {
+    public:
+        /** Signature of statfs(), which tests replace. */
+        using ProbeFunction = int (*)(const char *path, struct statfs *buf);
+
+        /** Rounds in flight after which a probe is held back once it returns. */
+        static constexpr uint64_t hung_rounds = 3;
+
+        /**
+         * @brief Starts @p threads workers, plus the reserved one.
+         * @param threads Workers available to the probes at any time.
+         * @param max_threads Upper bound on workers, counting the ones stuck on hung filesystems.
+         * @param probe Function run by the workers.
+         */
+        FsProbePool(unsigned threads, unsigned max_threads, ProbeFunction probe = ::statfs);
+
+        /**
+         * @brief Stops idle workers; workers stuck in statfs() are detached and exit when it returns.
+         */
+        ~FsProbePool();
+
+        FsProbePool(const FsProbePool &) = delete;
+        FsProbePool &operator=(const FsProbePool &) = delete;
+
+        /**
+         * @brief Starts a new round of probes.
+         */
+        void beginRound();
+
+        /**
+         * @brief Queues @p probe in the current round, unless it is still in flight or held back.
+         * @param reserved Runs it on the reserved worker, ahead of the shared queue.
+         */
+        void submit(const std::shared_ptr<FsProbe> &probe, bool reserved = false);
+
+        /**
+         * @brief Waits until every probe of the current round returned or ran for @p timeout_ms.
+         */
+        void wait(unsigned timeout_ms);
+
+        /**
+         * @brief Returns the outcome of @p probe in the current round.
+         *
+         * @p out receives the output of the last successful statfs() of the path (all zeroes if
+         * there was none), so stale probes can still be reported with their last known values.
+         */
+        FsProbe::status result(const FsProbe &probe, struct statfs &out);
+
+    private:
+        /** State shared with the workers, which may outlive the pool. */
+        struct Shared
+        {
+            std::mutex mutex;
+            std::condition_variable work_cv;
+            std::condition_variable reserved_cv;
+            std::condition_variable done_cv; ///< Signalled when a probe starts or returns.
+            std::deque<std::shared_ptr<FsProbe>> queue;
+            std::deque<std::shared_ptr<FsProbe>> reserved_queue;
+            ProbeFunction probe;
+            uint64_t round = 0;
+            unsigned workers = 0; ///< Workers that should be available.
+            unsigned threads = 0; ///< Shared-queue threads, including the written off ones.
+            unsigned hung = 0;    ///< Threads written off.
+            bool stopping = false;
+        };
+
+        std::shared_ptr<Shared> shared;
+        unsigned max_threads;
+        std::vector<std::shared_ptr<FsProbe>> submitted; ///< Probes of the current round.
+
+        static void workerLoop(std::shared_ptr<Shared> shared, bool reserved);
+        void spawnWorker(bool reserved);
+    };
+}
+
+#endif // FSPROBEPOOL_HPP
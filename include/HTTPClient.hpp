@@ -7,25 +7,57 @@
 #define OBHTTPCLIENT_HPP
 
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <curl/curl.h>
 #include <sys/sysinfo.h>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <random>
+#include <vector>
+#include "Compressor.hpp"
+#include "EventLoop.hpp"
+#include "ReportFormat.hpp"
 
 namespace ob
 {
+    /**
+     * @struct RetryConfig
+     * @brief How HTTPClient retries failed uploads.
+     */
+    struct RetryConfig
+    {
+        unsigned base_delay_ms = 1000;  ///< Backoff ceiling after the first failure, doubled after each one.
+        unsigned max_delay_ms = 60000;  ///< Upper bound of the backoff ceiling.
+        unsigned failure_threshold = 5; ///< Consecutive failures that open the circuit.
+        size_t max_queued = 32;         ///< Reports kept while the server is unreachable.
+    };
+
     /**
      * @class HTTPClient
      * @brief Manages the sending of system information to a specified server.
+     *
+     * Requests run on the curl multi interface: post() only starts a transfer, which the
+     * daemon's EventLoop then drives. curl tells the client which sockets to watch and when
+     * its next timeout is due, and the client registers them with the loop, so a slow server
+     * never delays the next sample. At most `max_in_flight` requests run at
+     * once; each owns a copy of its payload, so the caller can reuse its buffer right away.
+     *
+     * Reports wait in a bounded queue until they are delivered. A report whose upload fails
+     * (no connection, timeout, 408, 429 or 5xx) goes back to the head of the queue, and
+     * uploads pause for a random delay between 0 and a ceiling that doubles with every
+     * consecutive failure ("full jitter", so a fleet does not retry in lockstep). A
+     * `Retry-After` header extends the pause. After `failure_threshold` consecutive failures
+     * the circuit opens: once the pause is over, a single probe is sent, and the other uploads
+     * only resume when it succeeds. When the queue is full, the oldest report is dropped.
+     *
+     * The Content-Type of each request follows the format of its report. Bodies of at least
+     * `min_size` bytes are compressed, and sent with a Content-Encoding header, plus
+     * X-Zstd-Dictionary-ID with the trained dictionary; smaller ones are sent as is.
      */
     class HTTPClient
     {
-    private:
-        std::string server_url;               /**< The server URL to send data to. */
-        CURL *curl_session = nullptr;         /**< cURL session handle. */
-        std::string user_agent;               /**< User agent string for the cURL session. */
-        struct curl_slist *headers = nullptr; /**< List of HTTP headers for the cURL session. */
-
     public:
         /**
          * @enum error
@@ -33,31 +65,145 @@ namespace ob
          */
         enum class error
         {
-            request_failed,               /**< The HTTP request failed. */
-            unexpected_http_response_code /**< Received an unexpected HTTP response code. */
+            request_failed,                /**< The HTTP request could not be started. */
+            unexpected_http_response_code, /**< Received an unexpected HTTP response code, not retried. */
+            dropped,                       /**< Evicted from the full queue, or not queued for lack of memory. */
+            unsupported_media_type,        /**< The server does not accept the report's format (415). */
+            conflict                       /**< The server lacks the reports a delta depends on (409). */
         };
+
+        /**
+         * @brief Called once per report, when it is delivered or given up on.
+         *
+         * Receives the outcome (empty on success) and the report's payload.
+         */
+        using CompletionHandler = std::function<void(std::optional<error>, std::string_view)>;
+
         /**
          * @brief Constructs a HTTPClient object with the specified server URL.
+         * @param loop The loop driving the transfers.
          * @param url The server URL to send data to.
-         * @throws std::runtime_error if cURL initialization fails.
+         * @param max_in_flight Number of requests that may run concurrently.
+         * @param on_complete Called with the outcome of every report.
+         * @param retry How failed uploads are retried.
+         * @param compression How request bodies are compressed.
+         * @throws std::runtime_error if cURL or compressor initialization fails.
          */
-        HTTPClient(const std::string &url);
+        HTTPClient(EventLoop &loop, const std::string &url, size_t max_in_flight, CompletionHandler on_complete,
+                   const RetryConfig &retry = {}, const CompressionConfig &compression = {});
 
         /**
-         * @brief Destroys the HTTPClient object, cleaning up resources.
+         * @brief Destroys the HTTPClient object, aborting the requests in flight.
          */
         ~HTTPClient();
 
+        HTTPClient(const HTTPClient &) = delete;
+        HTTPClient &operator=(const HTTPClient &) = delete;
+
         /**
-         * @brief Sends a POST request with the specified payload to the server.
+         * @brief Queues a POST request with the specified payload, and starts it if possible.
          *
-         * Sets up the POST data and performs the request. Checks for successful
-         * completion and validates the HTTP response code.
+         * The payload is copied into a queue buffer, reused by later reports. If the buffer
+         * cannot grow in arena mode, the report is passed to the completion handler as
+         * error::dropped instead.
+         *
+         * @param payload The report to send.
+         * @param format  Encoding of @p payload, sent as its Content-Type.
+         */
+        void post(std::string_view payload, ReportFormat format = ReportFormat::json);
+
+
+        /**
+         * @brief Gives up on every queued and in-flight report, passing each to the completion
+         *        handler as error::dropped.
          *
-         * @param payload The JSON string to send.
-         * @return std::optional<http_client_error> An optional error code; empty if successful.
+         * Used at shutdown, so the reports can be saved elsewhere. A report aborted in flight
+         * may have reached the server already.
+         */
+        void abandon();
+
+        /**
+         * @brief Number of requests in flight.
+         */
+        size_t inFlight() const { return in_flight; }
+
+        /**
+         * @brief Number of reports waiting to be sent.
          */
-        std::optional<error> post(const std::string &payload);
+        size_t queued() const { return queue_count; }
+
+        /**
+         * @brief Whether uploads are paused after a failure.
+         */
+        bool backingOff() const;
+
+    private:
+        /**
+         * @struct Transfer
+         * @brief One request slot.
+         */
+        struct Transfer
+        {
+            CURL *easy = nullptr;
+            std::string payload;
+            ReportFormat format = ReportFormat::json;
+            std::string compressed; ///< Body sent when the payload is compressed.
+            bool busy = false;
+        };
+
+        /**
+         * @enum Circuit
+         * @brief State of the circuit breaker.
+         */
+        enum class Circuit
+        {
+            closed,   /**< Uploads run, paused after each failure. */
+            open,     /**< Too many failures: nothing is sent until the pause is over. */
+            half_open /**< A single probe is in flight or about to be sent. */
+        };
+
+        void cleanup();
+        void dispatch();
+        void requeue(Transfer &transfer);
+        void failed(long retry_after_s);
+        void socketAction(int fd, int flags);
+        void readCompletions();
+
+        static int onSocket(CURL *easy, curl_socket_t fd, int what, void *client, void *socket);
+        static int onTimer(CURLM *multi, long timeout_ms, void *client);
+
+        EventLoop &loop;
+        std::unique_ptr<Timer> timeout;       /**< Runs curl's timeouts. */
+        std::unique_ptr<Timer> resume;        /**< Ends the backoff pause. */
+        std::string server_url;               /**< The server URL to send data to. */
+        CURLM *multi = nullptr;               /**< cURL multi handle running the transfers. */
+        std::string user_agent;               /**< User agent string for the cURL session. */
+        /** HTTP headers, indexed by ReportFormat and by whether the body is compressed. */
+        struct curl_slist *headers[num_report_formats][2] = {};
+        std::vector<Transfer> transfers;      /**< Request slots. */
+        size_t in_flight = 0;
+        CompletionHandler on_complete;
+
+        RetryConfig retry;
+        size_t compression_min_size;
+        std::optional<Compressor> compressor;
+        /**
+         * @struct QueuedReport
+         * @brief Entry of the queue.
+         */
+        struct QueuedReport
+        {
+            std::string payload;
+            ReportFormat format = ReportFormat::json;
+        };
+
+        std::vector<QueuedReport> queue; /**< Ring of queued reports, buffers reused. */
+        size_t queue_head = 0;
+        size_t queue_count = 0;
+        Circuit circuit = Circuit::closed;
+        unsigned failures = 0;         /**< Consecutive failed uploads. */
+        uint64_t paused_until_ms = 0;  /**< CLOCK_MONOTONIC end of the backoff pause. */
+        std::minstd_rand jitter;
     };
 }
 #endif // OBHTTPCLIENT_HPP
@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef JSONWRITER_HPP
+#define JSONWRITER_HPP
+
+#include <concepts>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ob
+{
+    /**
+     * @class JsonWriter
+     * @brief Streams JSON straight into a reusable buffer.
+     *
+     * The output is byte-for-byte what json-c produces for the same document with
+     * JSON_C_TO_STRING_PLAIN or, when pretty-printing, JSON_C_TO_STRING_PRETTY: same
+     * indentation, same string escaping (including `\/`) and doubles printed as `%.17g`
+     * with `.0` appended to integral values. Numbers are formatted with std::to_chars.
+     *
+     * reset() keeps the buffer, so once it has grown to the size of a report no further
+     * allocation happens.
+     */
+    class JsonWriter
+    {
+    public:
+        /**
+         * @struct Checkpoint
+         * @brief Position in the document that rewind() can return to.
+         */
+        struct Checkpoint
+        {
+            size_t size;
+            size_t depth;
+            bool has_children;
+        };
+
+    private:
+        static constexpr size_t max_depth = 16;
+
+        std::string buf;
+        bool pretty;
+        size_t depth = 0;
+        bool in_array[max_depth] = {};
+        bool has_children[max_depth] = {};
+
+        void indent(size_t level);
+        void beforeValue();
+        void open(char c, bool array);
+        void close(char c);
+        void appendEscaped(std::string_view s);
+        void valueInt(int64_t v);
+        void valueUint(uint64_t v);
+
+    public:
+        /**
+         * @param pretty Pretty-print with two-space indentation, like JSON_C_TO_STRING_PRETTY.
+         */
+        explicit JsonWriter(bool pretty = false) : pretty(pretty) {}
+
+        /**
+         * @brief Discards the document written so far, keeping the buffer's capacity.
+         */
+        void reset();
+
+        void beginObject() { open('{', false); }
+        void endObject() { close('}'); }
+        void beginArray() { open('[', true); }
+        void endArray() { close(']'); }
+
+        /**
+         * @brief Records the current position, to discard what is written after it with rewind().
+         */
+        Checkpoint checkpoint() const
+        {
+            return {buf.size(), depth, depth > 0 && has_children[depth - 1]};
+        }
+
+        /**
+         * @brief Discards everything written since @p cp was taken. Never allocates.
+         */
+        void rewind(const Checkpoint &cp)
+        {
+            buf.resize(cp.size);
+            depth = cp.depth;
+            if (depth > 0)
+                has_children[depth - 1] = cp.has_children;
+        }
+
+        /**
+         * @brief Writes the key of the next member of the current object.
+         */
+        void key(std::string_view k);
+
+        void value(std::string_view v);
+        void value(const char *v) { value(std::string_view(v)); }
+        void value(double v);
+        void value(bool v);
+
+        template <std::integral T>
+        void value(T v)
+        {
+            if constexpr (std::is_signed_v<T>)
+                valueInt(v);
+            else
+                valueUint(v);
+        }
+
+        /**
+         * @brief Writes a member of the current object.
+         */
+        template <typename T>
+        void member(std::string_view k, const T &v)
+        {
+            key(k);
+            value(v);
+        }
+
+        /**
+         * @brief The document written since the last reset().
+         */
+        std::string_view view() const { return buf; }
+    };
+}
+
+#endif // JSONWRITER_HPP
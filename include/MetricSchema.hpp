@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef METRICSCHEMA_HPP
+#define METRICSCHEMA_HPP
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include "JsonWriter.hpp"
+
+/**
+ * A metric struct is described once, next to its definition, by specializing
+ * ob::Schema with a tuple of fields:
+ *
+ *     template <>
+ *     struct Schema<DiskStats>
+ *     {
+ *         static constexpr auto fields = std::make_tuple(
+ *             field<&DiskStats::total>("total", Unit::kib),
+ *             ...);
+ *     };
+ *
+ * Each field carries its serialized name, its unit and the member pointer it is read
+ * through (the type-safe form of an offset; a path of member pointers reaches into
+ * nested structs). Its type is that of the member, strings being read as string_view,
+ * unless fieldAs<T>() overrides it. The serializers below are templates that expand
+ * over the tuple, so every field access and every format decision is resolved at
+ * compile time.
+ */
+namespace ob
+{
+    /**
+     * @enum Unit
+     * @brief Unit of a metric field.
+     */
+    enum class Unit
+    {
+        none,
+        kib,
+        bytes,
+        seconds,
+        usec,
+        msec,
+        percent,
+        per_second,
+        bytes_per_second,
+        dbm
+    };
+
+    /**
+     * @brief Returns the name of @p unit, or "" for Unit::none.
+     */
+    constexpr std::string_view unitName(Unit unit)
+    {
+        switch (unit)
+        {
+        case Unit::kib: return "kibibytes";
+        case Unit::bytes: return "bytes";
+        case Unit::seconds: return "seconds";
+        case Unit::usec: return "microseconds";
+        case Unit::msec: return "milliseconds";
+        case Unit::percent: return "percent";
+        case Unit::per_second: return "per_second";
+        case Unit::bytes_per_second: return "bytes_per_second";
+        case Unit::dbm: return "dbm";
+        default: return "";
+        }
+    }
+
+    /**
+     * @brief Field list of a metric struct; specialized next to each struct.
+     */
+    template <typename S>
+    struct Schema;
+
+    namespace detail
+    {
+        template <auto First, auto... Rest, typename S>
+        constexpr const auto &resolve(const S &s)
+        {
+            if constexpr (sizeof...(Rest) == 0)
+                return s.*First;
+            else
+                return resolve<Rest...>(s.*First);
+        }
+
+        template <typename T>
+        struct member_of;
+
+        template <typename S, typename T>
+        struct member_of<T S::*>
+        {
+            using owner = S;
+            using type = T;
+        };
+
+        template <auto... Path>
+        using last_member_t = typename member_of<
+            std::tuple_element_t<sizeof...(Path) - 1, std::tuple<decltype(Path)...>>>::type;
+
+        /** Type a member is serialized as: strings and char arrays become string_view. */
+        template <typename T>
+        using wire_t = std::conditional_t<std::is_array_v<T> || std::is_same_v<T, std::string>,
+                                          std::string_view, T>;
+
+        template <typename T>
+        inline constexpr bool is_string_v = std::is_same_v<T, std::string_view>;
+
+        void appendPrometheusValue(std::string &out, double value);
+        void appendPrometheusValue(std::string &out, int64_t value);
+        void appendPrometheusValue(std::string &out, uint64_t value);
+        void appendPrometheusLabel(std::string &out, std::string_view name, std::string_view value);
+    }
+
+    /**
+     * @struct Field
+     * @brief One field of a Schema: name and unit, with type and location as template arguments.
+     *
+     * @tparam T    Type the field is serialized as.
+     * @tparam Path Member pointers leading from the described struct to the member.
+     */
+    template <typename T, auto... Path>
+    struct Field
+    {
+        using type = T;
+
+        std::string_view name;
+        Unit unit;
+
+        template <typename S>
+        static constexpr T get(const S &s)
+        {
+            return static_cast<T>(detail::resolve<Path...>(s));
+        }
+    };
+
+    /**
+     * @brief Declares a field read through @p Path and serialized with the member's own type.
+     */
+    template <auto... Path>
+    constexpr auto field(std::string_view name, Unit unit = Unit::none)
+    {
+        return Field<detail::wire_t<detail::last_member_t<Path...>>, Path...>{name, unit};
+    }
+
+    /**
+     * @brief Returns @p f, read through member @p Outer first.
+     */
+    template <auto Outer, typename T, auto... Path>
+    constexpr auto nestField(const Field<T, Path...> &f)
+    {
+        return Field<T, Outer, Path...>{f.name, f.unit};
+    }
+
+    /**
+     * @brief Declares a field read through @p Path and serialized as a @p T.
+     */
+    template <typename T, auto... Path>
+    constexpr auto fieldAs(std::string_view name, Unit unit = Unit::none)
+    {
+        return Field<T, Path...>{name, unit};
+    }
+
+    /**
+     * @brief Re-roots the fields of a nested struct's schema at member @p Outer of the enclosing struct.
+     *
+     * Used to splice a schema into another: `std::tuple_cat(..., nest<&MountStats::disk>(Schema<DiskStats>::fields), ...)`.
+     */
+    template <auto Outer, typename Fields>
+    constexpr auto nest(const Fields &fields)
+    {
+        return std::apply([](const auto &...f)
+        {
+            return std::make_tuple(nestField<Outer>(f)...);
+        }, fields);
+    }
+
+    /**
+     * @brief Calls @p f with every field of the schema of @p S, in order.
+     */
+    template <typename S, typename F>
+    constexpr void forEachField(F &&f)
+    {
+        std::apply([&](const auto &...fields) { (f(fields), ...); }, Schema<S>::fields);
+    }
+
+    /**
+     * @brief Writes every field of @p s as a member of the object being written.
+     *
+     * @tparam Writer JsonWriter, or CborWriter which has the same interface.
+     */
+    template <typename Writer, typename S>
+    void writeJsonMembers(Writer &json, const S &s)
+    {
+        forEachField<S>([&](const auto &f) { json.member(f.name, f.get(s)); });
+    }
+
+    /**
+     * @brief Writes @p s as an object, with a JsonWriter or a CborWriter.
+     */
+    template <typename Writer, typename S>
+    void writeJson(Writer &json, const S &s)
+    {
+        json.beginObject();
+        writeJsonMembers(json, s);
+        json.endObject();
+    }
+
+    /**
+     * @brief Appends one number in little-endian byte order.
+     */
+    template <typename T>
+        requires std::is_arithmetic_v<T>
+    void appendBinaryValue(std::string &out, T value)
+    {
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+        if constexpr (std::endian::native == std::endian::big)
+            std::reverse(bytes, bytes + sizeof(T));
+        out.append(bytes, sizeof(T));
+    }
+
+    /**
+     * @brief Appends @p s in the packed binary layout of its schema.
+     *
+     * Fields follow each other without padding, in schema order and little-endian:
+     * numbers take the size of their type, bools one byte and strings a 16-bit length
+     * followed by their bytes.
+     */
+    template <typename S>
+    void appendBinary(std::string &out, const S &s)
+    {
+        forEachField<S>([&](const auto &f)
+        {
+            using T = typename std::remove_cvref_t<decltype(f)>::type;
+            const T value = f.get(s);
+            if constexpr (detail::is_string_v<T>)
+            {
+                const uint16_t size = value.size() > UINT16_MAX ? UINT16_MAX : value.size();
+                appendBinaryValue(out, size);
+                out.append(value.data(), size);
+            }
+            else
+            {
+                appendBinaryValue(out, value);
+            }
+        });
+    }
+
+    /**
+     * @brief Appends the instances in @p items in the Prometheus text exposition format.
+     *
+     * Every numeric field becomes a gauge named `<prefix>_<field>`, with one sample per
+     * item and its unit in the HELP line. String fields become labels of the item's samples, after the
+     * `labels` given by the caller (already formatted as `name="value",...`). Samples are
+     * grouped per metric as the format requires.
+     */
+    template <typename S>
+    void appendPrometheus(std::string &out, std::string_view prefix, std::span<const S> items,
+                          std::string_view labels = {})
+    {
+        forEachField<S>([&](const auto &f)
+        {
+            using T = typename std::remove_cvref_t<decltype(f)>::type;
+            if constexpr (!detail::is_string_v<T>)
+            {
+                auto appendName = [&] { out.append(prefix).append("_").append(f.name); };
+
+                if (const auto unit = unitName(f.unit); !unit.empty())
+                {
+                    out.append("# HELP ");
+                    appendName();
+                    out.append(" Unit: ").append(unit).append(".\n");
+                }
+                out.append("# TYPE ");
+                appendName();
+                out.append(" gauge\n");
+                for (const auto &item : items)
+                {
+                    appendName();
+
+                    bool first_label = labels.empty();
+                    if (!labels.empty())
+                        out.append("{").append(labels);
+                    forEachField<S>([&](const auto &l)
+                    {
+                        using L = typename std::remove_cvref_t<decltype(l)>::type;
+                        if constexpr (detail::is_string_v<L>)
+                        {
+                            out.append(first_label ? "{" : ",");
+                            first_label = false;
+                            detail::appendPrometheusLabel(out, l.name, l.get(item));
+                        }
+                    });
+                    if (!first_label)
+                        out.append("}");
+
+                    out.append(" ");
+                    if constexpr (std::is_floating_point_v<T>)
+                        detail::appendPrometheusValue(out, static_cast<double>(f.get(item)));
+                    else if constexpr (std::is_signed_v<T>)
+                        detail::appendPrometheusValue(out, static_cast<int64_t>(f.get(item)));
+                    else
+                        detail::appendPrometheusValue(out, static_cast<uint64_t>(f.get(item)));
+                    out.append("\n");
+                }
+            }
+        });
+    }
+
+    /**
+     * @brief Appends a single instance in the Prometheus text exposition format.
+     */
+    template <typename S>
+    void appendPrometheus(std::string &out, std::string_view prefix, const S &s,
+                          std::string_view labels = {})
+    {
+        appendPrometheus(out, prefix, std::span<const S>(&s, 1), labels);
+    }
+}
+
+#endif // METRICSCHEMA_HPP
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef MOUNTCOLLECTOR_HPP
+#define MOUNTCOLLECTOR_HPP
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "FsProbePool.hpp"
+#include "MetricSchema.hpp"
+#include "Procfs.hpp"
+
+namespace ob
+{
+    /**
+     * @struct DiskStats
+     * @brief Holds disk usage statistics.
+     *
+     * The sizes are reported in KiB (kilobytes), similar to the output of the `df` command.
+     */
+    struct DiskStats
+    {
+        int64_t total;
+        int64_t free;
+        int64_t used;
+        int64_t available;
+        int64_t cached;
+        int8_t usage_percentage;
+    };
+
+    template <>
+    struct Schema<DiskStats>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&DiskStats::total>("total", Unit::kib),
+            field<&DiskStats::free>("free", Unit::kib),
+            field<&DiskStats::used>("used", Unit::kib),
+            field<&DiskStats::available>("available", Unit::kib),
+            fieldAs<double, &DiskStats::usage_percentage>("usage_percentage", Unit::percent));
+    };
+
+    /**
+     * @struct MountStats
+     * @brief Capacity and inode usage of one mounted filesystem.
+     */
+    struct MountStats
+    {
+        std::string mount_point;
+        std::string fstype;
+        std::string device;
+        FsProbe::status status; ///< Stale mounts keep the values of their last successful probe.
+        DiskStats disk;         ///< Capacity, in KiB like `df`.
+        uint64_t inodes_total;
+        uint64_t inodes_free;
+        uint64_t inodes_used;
+        int8_t inodes_usage_percentage;
+    };
+
+    /** The stale flag is derived from `status` and written by the serializer itself. */
+    template <>
+    struct Schema<MountStats>
+    {
+        static constexpr auto fields = std::tuple_cat(
+            std::make_tuple(
+                field<&MountStats::mount_point>("mount_point"),
+                field<&MountStats::fstype>("fstype"),
+                field<&MountStats::device>("device")),
+            nest<&MountStats::disk>(Schema<DiskStats>::fields),
+            std::make_tuple(
+                field<&MountStats::inodes_total>("inodes_total"),
+                field<&MountStats::inodes_free>("inodes_free"),
+                field<&MountStats::inodes_used>("inodes_used"),
+                fieldAs<double, &MountStats::inodes_usage_percentage>("inodes_usage_percentage", Unit::percent)));
+    };
+
+    /**
+     * @struct MountFilter
+     * @brief Selects which mounts are reported.
+     *
+     * A mount is skipped if its filesystem type is listed in `exclude_fstypes`, or if its
+     * mount point is one of `exclude_paths` or lies below one of them.
+     */
+    struct MountFilter
+    {
+        std::vector<std::string> exclude_fstypes = {
+            "autofs", "binfmt_misc", "bpf", "cgroup", "cgroup2", "configfs", "debugfs",
+            "devpts", "devtmpfs", "efivarfs", "fusectl", "hugetlbfs", "mqueue", "nsfs",
+            "proc", "pstore", "rpc_pipefs", "securityfs", "selinuxfs", "sysfs", "tracefs"};
+        std::vector<std::string> exclude_paths = {"/proc", "/sys", "/dev"};
+
+        bool accepts(std::string_view fstype, std::string_view mount_point) const;
+    };
+
+    /**
+     * @class MountCollector
+     * @brief Reports capacity and inode usage of every real mount.
+     *
+     * The mount table comes from /proc/self/mountinfo, which is kept open and only re-parsed
+     * when poll() flags it with POLLPRI, i.e. when something was mounted or unmounted.
+     *
+     * statfs() runs on an FsProbePool with a deadline for the whole collection, so a hung
+     * NFS or FUSE mount is reported as stale instead of blocking the daemon.
+     */
+    class MountCollector
+    {
+    public:
+        /**
+         * @enum error
+         * @brief Enumerates possible errors for the MountCollector class.
+         */
+        enum class error
+        {
+            read_failed, /**< /proc/self/mountinfo could not be read. */
+            root_failed  /**< statfs() of the root filesystem failed. */
+        };
+
+        /**
+         * @brief Opens /proc/self/mountinfo.
+         * @param filter Selects the reported mounts.
+         * @param timeout_ms Time given to the statfs() call of each mount, from when it starts.
+         * @param mountinfo_path Mount table to read, which tests replace.
+         * @throws std::runtime_error if the mount table cannot be opened.
+         */
+        MountCollector(const MountFilter &filter, unsigned timeout_ms,
+                       const char *mountinfo_path = "/proc/self/mountinfo");
+
+        /**
+         * @brief Refreshes the mount table if it changed and queries every mount.
+         *
+         * If the mount table cannot be read, the mounts of the last table read are queried
+         * again, and so is `/`: only root_failed leaves @p root out of date.
+         *
+         * @param[out] mounts One entry per reported mount; its storage is reused between calls.
+         * @param[in,out] root Usage of `/`; left untouched if its probe is stale.
+         * @return std::optional<error> An optional error code, root_failed first; empty if successful.
+         */
+        std::optional<error> collect(std::vector<MountStats> &mounts, DiskStats &root);
+
+    private:
+        MountFilter filter;
+        procfs::File mountinfo_file; ///< Persistent /proc/self/mountinfo handle.
+        bool parsed = false;         ///< Whether the mount table was parsed at least once.
+        unsigned timeout_ms;
+        FsProbePool pool;
+        std::shared_ptr<FsProbe> root_probe;
+        std::vector<std::shared_ptr<FsProbe>> probes; ///< One per entry of the reported mounts.
+
+        std::optional<error> parseMountinfo(std::vector<MountStats> &mounts);
+    };
+}
+
+#endif // MOUNTCOLLECTOR_HPP
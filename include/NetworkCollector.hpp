@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef NETWORKCOLLECTOR_HPP
+#define NETWORKCOLLECTOR_HPP
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "MetricSchema.hpp"
+#include "Procfs.hpp"
+
+namespace ob
+{
+    /**
+     * @struct InterfaceStats
+     * @brief Traffic counters and rates of one network interface.
+     */
+    struct InterfaceStats
+    {
+        char name[16]; ///< Interface name (IFNAMSIZ).
+        uint64_t rx_bytes;
+        uint64_t tx_bytes;
+        uint64_t rx_packets;
+        uint64_t tx_packets;
+        uint64_t rx_errors;
+        uint64_t tx_errors;
+        uint64_t rx_dropped;
+        uint64_t tx_dropped;
+        double rx_bytes_per_s;
+        double tx_bytes_per_s;
+        double rx_packets_per_s;
+        double tx_packets_per_s;
+        bool wireless;         ///< Whether the fields below are set.
+        int64_t link_quality;  ///< Link quality as reported by the driver.
+        int64_t signal_dbm;
+        int64_t noise_dbm;
+    };
+
+    /** The optional wireless fields are written by the serializer itself. */
+    template <>
+    struct Schema<InterfaceStats>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&InterfaceStats::name>("name"),
+            field<&InterfaceStats::rx_bytes>("rx_bytes", Unit::bytes),
+            field<&InterfaceStats::tx_bytes>("tx_bytes", Unit::bytes),
+            field<&InterfaceStats::rx_packets>("rx_packets"),
+            field<&InterfaceStats::tx_packets>("tx_packets"),
+            field<&InterfaceStats::rx_errors>("rx_errors"),
+            field<&InterfaceStats::tx_errors>("tx_errors"),
+            field<&InterfaceStats::rx_dropped>("rx_dropped"),
+            field<&InterfaceStats::tx_dropped>("tx_dropped"),
+            field<&InterfaceStats::rx_bytes_per_s>("rx_bytes_per_s", Unit::bytes_per_second),
+            field<&InterfaceStats::tx_bytes_per_s>("tx_bytes_per_s", Unit::bytes_per_second),
+            field<&InterfaceStats::rx_packets_per_s>("rx_packets_per_s", Unit::per_second),
+            field<&InterfaceStats::tx_packets_per_s>("tx_packets_per_s", Unit::per_second));
+    };
+
+    /**
+     * @class NetworkCollector
+     * @brief Reads per-interface counters with one RTM_GETLINK netlink dump per sample.
+     *
+     * Counters come from IFLA_STATS64, so no text has to be parsed; rates are computed from
+     * the deltas against the previous sample. Wireless link quality is added from
+     * /proc/net/wireless when the file exists.
+     */
+    class NetworkCollector
+    {
+    public:
+        /**
+         * @enum error
+         * @brief Enumerates possible errors for the NetworkCollector class.
+         */
+        enum class error
+        {
+            request_failed, /**< The netlink dump could not be requested or received. */
+            parse_failed    /**< The netlink dump was malformed or reported an error. */
+        };
+
+        /**
+         * @brief Opens the NETLINK_ROUTE socket and /proc/net/wireless, if present.
+         * @throws std::runtime_error if the netlink socket cannot be created.
+         */
+        NetworkCollector();
+
+        /**
+         * @brief Closes the netlink socket.
+         */
+        ~NetworkCollector();
+
+        NetworkCollector(const NetworkCollector &) = delete;
+        NetworkCollector &operator=(const NetworkCollector &) = delete;
+
+        /**
+         * @brief Dumps the interface counters and computes the rates since the previous call.
+         * @param[out] interfaces One entry per interface; its storage is reused between calls.
+         * @return std::optional<error> An optional error code; empty if successful.
+         */
+        std::optional<error> collect(std::vector<InterfaceStats> &interfaces);
+
+    private:
+        /** Counters of an interface at the previous sample. */
+        struct Previous
+        {
+            int32_t ifindex;
+            uint64_t rx_bytes;
+            uint64_t tx_bytes;
+            uint64_t rx_packets;
+            uint64_t tx_packets;
+        };
+
+        int sock = -1;
+        uint32_t seq = 0;
+        std::vector<char> buf;          ///< Receive buffer for the dump.
+        std::vector<Previous> previous; ///< Counters of the previous sample.
+        std::vector<Previous> current;  ///< Counters of the sample being taken.
+        uint64_t previous_ns = 0;       ///< CLOCK_MONOTONIC time of the previous sample.
+        procfs::File wireless_file;     ///< /proc/net/wireless; closed if the kernel has no wireless support.
+
+        std::optional<error> dumpLinks(std::vector<InterfaceStats> &interfaces, double elapsed_s);
+        void readWireless(std::vector<InterfaceStats> &interfaces);
+    };
+}
+
+#endif // NETWORKCOLLECTOR_HPP
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef PRESSURECOLLECTOR_HPP
+#define PRESSURECOLLECTOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include "MetricSchema.hpp"
+#include "Procfs.hpp"
+
+namespace ob
+{
+    /**
+     * @enum PressureResource
+     * @brief Resources tracked by pressure stall information (PSI).
+     */
+    enum class PressureResource
+    {
+        cpu,
+        memory,
+        io
+    };
+
+    /** Number of PressureResource values. */
+    inline constexpr size_t num_pressure_resources = 3;
+
+    /**
+     * @brief Returns the name of @p resource, as used in /proc/pressure.
+     */
+    const char *pressureResourceName(PressureResource resource);
+
+    /**
+     * @struct PressureLine
+     * @brief One line (`some` or `full`) of a /proc/pressure file.
+     */
+    struct PressureLine
+    {
+        double avg10;   ///< Percentage of time stalled over the last 10 s.
+        double avg60;
+        double avg300;
+        uint64_t total; ///< Total stall time in microseconds.
+    };
+
+    template <>
+    struct Schema<PressureLine>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&PressureLine::avg10>("avg10", Unit::percent),
+            field<&PressureLine::avg60>("avg60", Unit::percent),
+            field<&PressureLine::avg300>("avg300", Unit::percent),
+            field<&PressureLine::total>("total", Unit::usec));
+    };
+
+    /**
+     * @struct PressureStats
+     * @brief Pressure of one resource.
+     */
+    struct PressureStats
+    {
+        bool available; ///< False if the kernel does not expose this resource.
+        PressureLine some;
+        PressureLine full;
+    };
+
+    /**
+     * @class PressureCollector
+     * @brief Reads /proc/pressure/{cpu,memory,io}.
+     *
+     * Kernels built without PSI have no /proc/pressure; the collector then reports nothing.
+     */
+    class PressureCollector
+    {
+    public:
+        /**
+         * @brief Opens the /proc/pressure files that exist.
+         */
+        PressureCollector();
+
+        /**
+         * @brief Reads the pressure of every available resource.
+         * @param[out] stats Indexed by PressureResource.
+         */
+        void collect(std::array<PressureStats, num_pressure_resources> &stats);
+
+    private:
+        std::array<procfs::File, num_pressure_resources> files;
+    };
+
+    /**
+     * @class PressureMonitor
+     * @brief Waits for PSI triggers so stalls are noticed as they happen.
+     *
+     * A trigger such as `some 150000 1000000` (150 ms of stall within 1 s) is written to each
+     * /proc/pressure file; the kernel then flags the descriptor with POLLPRI when the threshold
+     * is crossed, at most once per window. The daemon polls those descriptors while it waits for
+     * the next sample, so detecting a stall costs nothing between samples.
+     */
+    class PressureMonitor
+    {
+    public:
+        /**
+         * @brief Registers @p trigger on every resource that supports it.
+         *
+         * Resources that cannot be monitored (no PSI, or no permission) are skipped with a warning.
+         *
+         * @param trigger Trigger specification, see the kernel's psi.rst; empty disables monitoring.
+         */
+        PressureMonitor(const std::string &trigger);
+
+        /**
+         * @brief Closes the trigger descriptors.
+         */
+        ~PressureMonitor();
+
+        PressureMonitor(const PressureMonitor &) = delete;
+        PressureMonitor &operator=(const PressureMonitor &) = delete;
+
+        /**
+         * @brief Trigger descriptors, indexed by PressureResource; -1 if not monitored.
+         *
+         * They are polled by the daemon's loop for POLLPRI, next to its other descriptors.
+         */
+        const std::array<int, num_pressure_resources> &descriptors() const { return fds; }
+
+        /**
+         * @brief Handles the poll events @p revents reported on descriptor @p fd.
+         * @return The stalled resource if its trigger fired, an empty optional otherwise.
+         */
+        std::optional<PressureResource> handleEvent(int fd, short revents);
+
+    private:
+        std::array<int, num_pressure_resources> fds; ///< Trigger descriptors, -1 if not monitored.
+    };
+}
+
+#endif // PRESSURECOLLECTOR_HPP
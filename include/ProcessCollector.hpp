@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef PROCESSCOLLECTOR_HPP
+#define PROCESSCOLLECTOR_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <dirent.h>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "MetricSchema.hpp"
+
+namespace ob
+{
+    /**
+     * @struct ProcessInfo
+     * @brief Resource usage of a single process.
+     */
+    struct ProcessInfo
+    {
+        int32_t pid;
+        char name[16];         ///< Command name, as in /proc/[pid]/comm (TASK_COMM_LEN).
+        double cpu_percentage; ///< CPU usage since the previous sample, 100 per fully used core.
+        uint64_t rss;          ///< Resident set size in KiB.
+    };
+
+    template <>
+    struct Schema<ProcessInfo>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&ProcessInfo::pid>("pid"),
+            field<&ProcessInfo::name>("name"),
+            field<&ProcessInfo::cpu_percentage>("cpu_percentage", Unit::percent),
+            field<&ProcessInfo::rss>("rss", Unit::kib));
+    };
+
+    /**
+     * @struct ProcessStats
+     * @brief The processes using the most CPU and memory.
+     */
+    struct ProcessStats
+    {
+        uint64_t total;                   ///< Number of processes seen in the last scan.
+        std::vector<ProcessInfo> top_cpu; ///< Highest CPU usage first.
+        std::vector<ProcessInfo> top_rss; ///< Highest RSS first.
+    };
+
+    /**
+     * @class ProcessCollector
+     * @brief Scans /proc/[pid]/stat in parallel and selects the top N processes by CPU and RSS.
+     *
+     * The list of PIDs is split into one contiguous slice per thread; the calling thread scans
+     * the first slice and a fixed set of workers scan the rest. The CPU ticks of the previous
+     * scan are kept in an open-addressing table keyed by (pid, starttime), so a recycled PID
+     * is never mistaken for the process that used it before. Selection uses bounded heaps of
+     * N entries instead of sorting every process.
+     */
+    class ProcessCollector
+    {
+    public:
+        /**
+         * @enum error
+         * @brief Enumerates possible errors for the ProcessCollector class.
+         */
+        enum class error
+        {
+            read_failed /**< /proc could not be listed. */
+        };
+
+        /**
+         * @brief Opens /proc and starts the scan workers.
+         * @param top_n Number of processes to report in each list.
+         * @param threads Number of threads scanning /proc, including the caller; 0 picks one per core up to 4.
+         * @throws std::runtime_error if /proc cannot be opened.
+         */
+        ProcessCollector(size_t top_n, unsigned threads = 0);
+
+        /**
+         * @brief Stops the scan workers and closes /proc.
+         */
+        ~ProcessCollector();
+
+        ProcessCollector(const ProcessCollector &) = delete;
+        ProcessCollector &operator=(const ProcessCollector &) = delete;
+
+        /**
+         * @brief Scans every process and selects the top N.
+         * @param[out] stats Filled with the selection; its storage is reused between calls.
+         * @return std::optional<error> An optional error code; empty if successful.
+         */
+        std::optional<error> collect(ProcessStats &stats);
+
+    private:
+        /** One process read during a scan. */
+        struct Sample
+        {
+            int32_t pid; ///< 0 if the process vanished before it could be read.
+            uint64_t starttime;
+            uint64_t ticks;
+            uint64_t rss;
+            double cpu_percentage;
+            char name[16];
+        };
+
+        /** CPU ticks of a process at the previous scan. */
+        struct Entry
+        {
+            int32_t pid; ///< 0 marks an empty slot.
+            uint64_t starttime;
+            uint64_t ticks;
+        };
+
+        size_t top_n;
+        DIR *proc_dir = nullptr;
+        long page_kb;
+        long ticks_per_s;
+
+        std::vector<int32_t> pids;
+        std::vector<Sample> samples;
+        std::vector<Entry> previous; ///< Table of the previous scan; size is a power of two.
+        std::vector<Entry> current;  ///< Table being built for the next scan.
+        uint64_t previous_ns = 0;    ///< CLOCK_MONOTONIC time of the previous scan.
+        uint64_t scan_ns = 0;        ///< CLOCK_MONOTONIC time of the scan in progress.
+        uint64_t boot_ticks = 0;     ///< Time since boot of the scan in progress, in clock ticks.
+
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable start_cv;
+        std::condition_variable done_cv;
+        uint64_t generation = 0;
+        size_t pending = 0;
+        bool stopping = false;
+
+        void workerLoop(size_t slice);
+        void scanSlice(size_t slice);
+        void readProcess(int proc_fd, int32_t pid, Sample &sample) const;
+        const Entry *findPrevious(int32_t pid, uint64_t starttime) const;
+        void insertCurrent(const Sample &sample);
+    };
+}
+
+#endif // PROCESSCOLLECTOR_HPP
@@ -0,0 +1,312 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef PROCFS_HPP
+#define PROCFS_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <string_view>
+#include <vector>
+
+namespace ob::procfs
+{
+    /**
+     * @brief Returns a pointer to the first occurrence of @p c in [p, end), or @p end.
+     *
+     * Uses AVX2/SSE2 when the build targets them, and a scalar loop otherwise.
+     */
+    const char *findByte(const char *p, const char *end, char c);
+
+    /**
+     * @brief Returns a pointer to the first space or tab in [p, end), or @p end.
+     */
+    const char *findSpace(const char *p, const char *end);
+
+    /**
+     * @brief Returns a pointer to the first byte in [p, end) that is not a space or tab, or @p end.
+     */
+    const char *skipSpaces(const char *p, const char *end);
+
+    /**
+     * @brief Parses the unsigned decimal integer at the start of [p, end).
+     *
+     * Stops at the first non-digit. No locale, no errno, no overflow checking.
+     *
+     * @return Pointer past the last digit consumed (equal to @p p if there were none).
+     */
+    inline const char *parseU64(const char *p, const char *end, uint64_t &out)
+    {
+        uint64_t value = 0;
+        while (p < end && static_cast<unsigned char>(*p - '0') < 10)
+            value = value * 10 + static_cast<unsigned char>(*p++ - '0');
+        out = value;
+        return p;
+    }
+
+    /**
+     * @brief Parses the signed decimal integer at the start of [p, end), see parseU64().
+     */
+    inline const char *parseI64(const char *p, const char *end, int64_t &out)
+    {
+        bool negative = p < end && *p == '-';
+        uint64_t value;
+        const char *digits = p + negative;
+        const char *q = parseU64(digits, end, value);
+        if (q == digits)
+        {
+            out = 0;
+            return p;
+        }
+        out = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+        return q;
+    }
+
+    /**
+     * @class File
+     * @brief A procfs file kept open and re-read with pread() into a reusable buffer.
+     *
+     * The buffer only grows when the file no longer fits, so steady-state reads allocate nothing.
+     */
+    class File
+    {
+    private:
+        int fd = -1;            /**< Open descriptor, or -1. */
+        std::vector<char> buf;  /**< Buffer holding the last read contents. */
+
+    public:
+        File() = default;
+
+        /**
+         * @brief Opens @p path; check isOpen() for the result.
+         */
+        explicit File(const char *path);
+
+        File(File &&other) noexcept;
+        File &operator=(File &&other) noexcept;
+        File(const File &) = delete;
+        File &operator=(const File &) = delete;
+
+        /**
+         * @brief Closes the file.
+         */
+        ~File();
+
+        /**
+         * @brief Opens @p path relative to @p dirfd (AT_FDCWD for a plain path).
+         * @return 0 on success, -errno on failure.
+         */
+        int open(const char *path, int dirfd = -100 /* AT_FDCWD */);
+
+        /**
+         * @brief Closes the file if open.
+         */
+        void close();
+
+        bool isOpen() const { return fd >= 0; }
+        int descriptor() const { return fd; }
+
+        /**
+         * @brief Re-reads the whole file from offset 0.
+         * @return A view of the contents, valid until the next read(), or -errno.
+         */
+        std::expected<std::string_view, int> read();
+    };
+
+    /**
+     * @class Line
+     * @brief Whitespace tokenizer over one line of a procfs file.
+     */
+    class Line
+    {
+    private:
+        const char *p = nullptr;
+        const char *end = nullptr;
+
+    public:
+        Line() = default;
+        Line(const char *begin, const char *end) : p(begin), end(end) {}
+
+        bool empty() const { return skipSpaces(p, end) == end; }
+        std::string_view rest() const { return {p, static_cast<size_t>(end - p)}; }
+
+        /**
+         * @brief Returns the next whitespace-delimited token, or an empty view at the end of the line.
+         */
+        std::string_view token()
+        {
+            p = skipSpaces(p, end);
+            const char *start = p;
+            p = findSpace(p, end);
+            return {start, static_cast<size_t>(p - start)};
+        }
+
+        /**
+         * @brief Returns the next key, terminated by ':' or whitespace, and consumes the ':'.
+         *
+         * Handles both `MemTotal:  123 kB` (meminfo) and `eth0:123 ...` (net/dev) layouts.
+         */
+        std::string_view key()
+        {
+            p = skipSpaces(p, end);
+            const char *start = p;
+            const char *space = findSpace(p, end);
+            const char *colon = findByte(p, space, ':');
+            p = colon < space ? colon + 1 : space;
+            return {start, static_cast<size_t>(colon - start)};
+        }
+
+        /**
+         * @brief Parses the next token as an unsigned integer.
+         * @return false if there was no numeric token left.
+         */
+        bool u64(uint64_t &out)
+        {
+            p = skipSpaces(p, end);
+            const char *start = p;
+            p = parseU64(p, end, out);
+            if (p == start)
+                return false;
+            p = findSpace(p, end);
+            return true;
+        }
+
+        /**
+         * @brief Parses the next token as a signed integer, ignoring anything after the digits
+         *        (e.g. the trailing '.' of /proc/net/wireless values).
+         * @return false if there was no numeric token left.
+         */
+        bool i64(int64_t &out)
+        {
+            p = skipSpaces(p, end);
+            const char *start = p;
+            p = parseI64(p, end, out);
+            if (p == start)
+                return false;
+            p = findSpace(p, end);
+            return true;
+        }
+
+        /**
+         * @brief Parses the next token as an unsigned integer, or returns 0.
+         */
+        uint64_t u64()
+        {
+            uint64_t value = 0;
+            u64(value);
+            return value;
+        }
+
+        /**
+         * @brief Skips @p n tokens.
+         */
+        void skip(size_t n)
+        {
+            while (n--)
+                token();
+        }
+    };
+
+    /**
+     * @class Scanner
+     * @brief Splits a procfs buffer into lines.
+     */
+    class Scanner
+    {
+    private:
+        const char *p;
+        const char *end;
+
+    public:
+        explicit Scanner(std::string_view text) : p(text.data()), end(text.data() + text.size()) {}
+
+        /**
+         * @brief Advances to the next line.
+         * @return false when the buffer is exhausted.
+         */
+        bool next(Line &line)
+        {
+            if (p >= end)
+                return false;
+            const char *nl = findByte(p, end, '\n');
+            line = Line(p, nl);
+            p = nl < end ? nl + 1 : end;
+            return true;
+        }
+    };
+
+    /**
+     * @class KeySet
+     * @brief A compile-time set of keys matched with a perfect hash.
+     *
+     * Build it with makeKeySet(); find() returns the index of the key in declaration order,
+     * so collectors can map it straight onto an enum or an array of values.
+     */
+    template <size_t N>
+    class KeySet
+    {
+    private:
+        static constexpr size_t table_size = std::bit_ceil(N * 2);
+
+        std::array<std::string_view, N> keys{};
+        std::array<int16_t, table_size> slots{};
+        uint32_t seed = 0;
+
+        static constexpr uint32_t hash(std::string_view s, uint32_t seed)
+        {
+            uint32_t h = 2166136261u ^ seed;
+            for (char c : s)
+            {
+                h ^= static_cast<unsigned char>(c);
+                h *= 16777619u;
+            }
+            return h ^ (h >> 15);
+        }
+
+    public:
+        consteval KeySet(const std::array<std::string_view, N> &k) : keys(k)
+        {
+            for (seed = 0;; seed++)
+            {
+                slots.fill(-1);
+                bool collision = false;
+                for (size_t i = 0; i < N && !collision; i++)
+                {
+                    auto &slot = slots[hash(keys[i], seed) & (table_size - 1)];
+                    collision = slot >= 0;
+                    slot = static_cast<int16_t>(i);
+                }
+                if (!collision)
+                    break;
+            }
+        }
+
+        static constexpr size_t size() { return N; }
+
+        /**
+         * @brief Looks up @p key.
+         * @return The index of the key, or -1 if it is not in the set.
+         */
+        constexpr int find(std::string_view key) const
+        {
+            int idx = slots[hash(key, seed) & (table_size - 1)];
+            return (idx >= 0 && keys[idx] == key) ? idx : -1;
+        }
+    };
+
+    /**
+     * @brief Builds a KeySet at compile time, e.g. `makeKeySet("MemTotal", "MemFree")`.
+     */
+    template <typename... K>
+    consteval auto makeKeySet(K... keys)
+    {
+        return KeySet<sizeof...(K)>(std::array<std::string_view, sizeof...(K)>{std::string_view(keys)...});
+    }
+}
+
+#endif // PROCFS_HPP
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef REPORTBATCH_HPP
+#define REPORTBATCH_HPP
+
+#include <cstdint>
+#include <string_view>
+#include "CborWriter.hpp"
+#include "ColumnarWriter.hpp"
+#include "FlatWriter.hpp"
+#include "JsonWriter.hpp"
+#include "ReportFormat.hpp"
+#include "SystemInfo.hpp"
+
+namespace ob
+{
+    /**
+     * @class ReportBatch
+     * @brief Accumulates samples into a single JSON or CBOR array, or a columnar batch, sent as one POST.
+     *
+     * Each element is a full report with a "timestamp" member (milliseconds since the Unix
+     * epoch). In the columnar format, the samples are encoded field by field as they are
+     * added. The batch is ready to be sent once it holds `max_samples` samples or its oldest
+     * sample is `max_age_ms` old, whichever comes first; ready() only checks the age when it
+     * is called, so the caller arms a timer to send the batch when it gets too old.
+     */
+    class ReportBatch
+    {
+    public:
+        /**
+         * @param max_samples Samples per batch; at least 1.
+         * @param max_age_ms  Age of the oldest sample at which the batch is sent regardless
+         *                    of its size; 0 for no limit.
+         * @param pretty      Pretty-print the JSON array.
+         * @param format      Encoding of the batch.
+         */
+        ReportBatch(size_t max_samples, unsigned max_age_ms, bool pretty, ReportFormat format = ReportFormat::json);
+
+        /**
+         * @brief Appends the current report of @p sysinfo, stamped with the current time.
+         *
+         * In arena mode, a sample that does not fit in memory makes the batch ready early with
+         * the samples it already holds, and the batch size is lowered to that count; the
+         * caller should send it and add the sample again. A sample that does not fit in an
+         * empty batch sheds an optional collector of @p sysinfo instead.
+         *
+         * @return false if the sample was not added because the batch must be sent first.
+         * @throws std::bad_alloc if the sample does not fit even in an empty batch and there
+         *         is nothing left to shed.
+         */
+        bool add(SystemInfo &sysinfo);
+
+        /**
+         * @brief Whether the batch is full or its oldest sample is too old.
+         */
+        bool ready() const;
+
+        bool empty() const { return count == 0; }
+        size_t size() const { return count; }
+        ReportFormat format() const { return encoding; }
+
+        /**
+         * @brief Changes the encoding of the next samples; the batch must be empty.
+         */
+        void setFormat(ReportFormat format);
+
+        /**
+         * @brief Closes the array and returns it; valid until clear().
+         */
+        std::string_view finish();
+
+        /**
+         * @brief Empties the batch, keeping its buffer.
+         */
+        void clear();
+
+    private:
+        JsonWriter json;
+        CborWriter cbor;
+        FlatWriter flat;        ///< Sample being added, in the columnar format.
+        ColumnarWriter columns;
+        ReportFormat encoding;
+        size_t max_samples;
+        unsigned max_age_ms;
+        size_t count = 0;
+        uint64_t first_ms = 0; ///< CLOCK_MONOTONIC time of the oldest sample.
+        bool full = false;     ///< Set when a sample did not fit in memory.
+        bool finished = false;
+    };
+}
+
+#endif // REPORTBATCH_HPP
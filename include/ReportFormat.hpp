@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef REPORTFORMAT_HPP
+#define REPORTFORMAT_HPP
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+namespace ob
+{
+    /**
+     * @enum ReportFormat
+     * @brief Encoding of a report or a batch of reports.
+     */
+    enum class ReportFormat
+    {
+        json,    /**< Written by JsonWriter. */
+        cbor,    /**< Written by CborWriter, RFC 8949. */
+        columnar /**< Written by ColumnarWriter; batches only. */
+    };
+
+    constexpr size_t num_report_formats = 3;
+
+    /**
+     * @brief Returns the Content-Type of @p format.
+     */
+    constexpr std::string_view contentType(ReportFormat format)
+    {
+        switch (format)
+        {
+        case ReportFormat::cbor: return "application/cbor";
+        case ReportFormat::columnar: return "application/vnd.observabilityd.columnar";
+        default: return "application/json";
+        }
+    }
+
+    /**
+     * @brief Parses "json", "cbor" or "columnar".
+     */
+    constexpr std::optional<ReportFormat> parseReportFormat(std::string_view name)
+    {
+        if (name == "json")
+            return ReportFormat::json;
+        if (name == "cbor")
+            return ReportFormat::cbor;
+        if (name == "columnar")
+            return ReportFormat::columnar;
+        return {};
+    }
+
+    /**
+     * @brief Tells the format of a report from its first byte.
+     *
+     * CborWriter always starts a document with an indefinite-length map or array (0xbf, 0x9f),
+     * and ColumnarWriter with "OBC", neither of which can start a JSON document.
+     */
+    constexpr ReportFormat detectReportFormat(std::string_view payload)
+    {
+        if (payload.starts_with("OBC"))
+            return ReportFormat::columnar;
+        if (!payload.empty() && (static_cast<unsigned char>(payload[0]) == 0xbf ||
+                                 static_cast<unsigned char>(payload[0]) == 0x9f))
+            return ReportFormat::cbor;
+        return ReportFormat::json;
+    }
+}
+
+#endif // REPORTFORMAT_HPP
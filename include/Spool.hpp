@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef SPOOL_HPP
+#define SPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace ob
+{
+    /**
+     * @struct SpoolConfig
+     * @brief Location and size caps of a Spool.
+     */
+    struct SpoolConfig
+    {
+        std::string directory;             ///< Created if missing.
+        size_t segment_size = 1024 * 1024; ///< Bytes per segment file, header included.
+        size_t max_size = 16 * 1024 * 1024; ///< Total bytes of segments; the oldest one is dropped beyond.
+    };
+
+    /**
+     * @class Spool
+     * @brief Crash-safe, append-only queue of reports on disk, read oldest-first.
+     *
+     * The spool is a ring of fixed-size segment files named after their sequence number, each
+     * mapped with mmap(). A segment starts with a header holding its sequence number, and the
+     * end and count of its committed records and of its consumed ones; records follow, each made of
+     * its length, the CRC-32 of its payload and the payload itself, padded to 8 bytes.
+     *
+     * A record is synced to disk before the header commits it, so a crash can only lose the
+     * record being written. As the header says where the valid data ends, recovery reads
+     * the headers of the segments and never scans records, however full the spool is. A record
+     * whose CRC does not match when it is read is skipped.
+     */
+    class Spool
+    {
+    public:
+        /**
+         * @enum error
+         * @brief Errors of append().
+         */
+        enum class error
+        {
+            too_large, /**< The record does not fit in a segment. */
+            io_failed  /**< A segment could not be created or mapped. */
+        };
+
+        /**
+         * @brief Opens the spool in @p config.directory, recovering the segments found there.
+         * @throws std::runtime_error if the directory cannot be created or read.
+         */
+        explicit Spool(const SpoolConfig &config);
+
+        /**
+         * @brief Unmaps the segments; their contents stay on disk.
+         */
+        ~Spool();
+
+        Spool(const Spool &) = delete;
+        Spool &operator=(const Spool &) = delete;
+
+        /**
+         * @brief Appends @p payload after the newest record.
+         *
+         * Starts a new segment when the current one is full, dropping the oldest segment
+         * and its unread records if the spool would exceed `max_size`.
+         */
+        std::optional<error> append(std::string_view payload);
+
+        /**
+         * @brief Returns the oldest unread record, or an empty optional if there is none.
+         *
+         * The view stays valid until the next call to pop() or append().
+         */
+        std::optional<std::string_view> front();
+
+        /**
+         * @brief Marks the record returned by front() as read.
+         */
+        void pop();
+
+        /**
+         * @brief Whether every record has been read.
+         */
+        bool empty() const;
+
+        /**
+         * @brief Number of unread records.
+         */
+        size_t size() const { return records; }
+
+    private:
+        struct Segment
+        {
+            uint64_t sequence;
+            int fd;
+            char *data;
+            size_t size;
+        };
+
+        SpoolConfig config;
+        std::deque<Segment> segments; ///< Oldest first.
+        size_t records = 0;
+
+        std::optional<Segment> openSegment(uint64_t sequence, bool create);
+        void closeSegment(Segment &segment, bool remove);
+        std::string segmentPath(uint64_t sequence) const;
+    };
+}
+
+#endif // SPOOL_HPP
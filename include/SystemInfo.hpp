@@ -10,27 +10,23 @@
 #include <stdexcept>
 #include <expected>
 #include <optional>
-#include <json-c/json.h>
+#include "Procfs.hpp"
+#include "Arena.hpp"
+#include "CborWriter.hpp"
+#include "FlatWriter.hpp"
+#include "JsonWriter.hpp"
+#include "MetricSchema.hpp"
+#include "CpuCollector.hpp"
+#include "ProcessCollector.hpp"
+#include "MountCollector.hpp"
+#include "BlockDeviceCollector.hpp"
+#include "NetworkCollector.hpp"
+#include "PressureCollector.hpp"
+#include "CgroupCollector.hpp"
 
 namespace ob
 {
 
-    /**
-     * @struct DiskStats
-     * @brief Holds disk usage statistics.
-     *
-     * The sizes are reported in KiB (kilobytes), similar to the output of the `df` command.
-     */
-    struct DiskStats
-    {
-        int64_t total;
-        int64_t free;
-        int64_t used;
-        int64_t available;
-        int64_t cached;
-        int8_t usage_percentage;
-    };
-
     /**
      * @struct MemoryStats
      * @brief Holds memory usage statistics.
@@ -47,26 +43,43 @@ namespace ob
         uint64_t available;
     };
 
+    template <>
+    struct Schema<MemoryStats>
+    {
+        static constexpr auto fields = std::make_tuple(
+            field<&MemoryStats::total>("total", Unit::kib),
+            field<&MemoryStats::used>("used", Unit::kib),
+            field<&MemoryStats::free>("free", Unit::kib),
+            field<&MemoryStats::shared>("shared", Unit::kib),
+            field<&MemoryStats::cached>("cached", Unit::kib),
+            field<&MemoryStats::available>("available", Unit::kib));
+    };
+
+    /**
+     * @struct SystemInfoConfig
+     * @brief Tunables of the collectors run by SystemInfo.
+     */
+    struct SystemInfoConfig
+    {
+        size_t top_processes = 5; ///< Processes reported per top-N list; 0 disables the process collector.
+        MountFilter mounts;       ///< Selects the mounts reported under "mounts".
+        unsigned mount_timeout_ms = 1000; ///< Deadline of each statfs() call.
+        const char *mountinfo_path = "/proc/self/mountinfo"; ///< Mount table; tests replace it.
+        unsigned cgroup_depth = 2;        ///< cgroup levels reported below the root; 0 disables the cgroup collector.
+        bool pretty_json = false;         ///< Pretty-print the JSON report.
+    };
+
     /**
      * @class SystemInfo
      * @brief Collects and provides system information such as hostname, uptime, memory, and disk statistics.
      *
      * The SystemInfo class is responsible for retrieving various system statistics and providing
      * them both as raw data and as a JSON-formatted string. The class uses non-throwing methods 
-     * that return error codes wrapped in std::optional or std::expected types.
+     * that return error codes wrapped in std::optional types.
      */
     class SystemInfo
     {
     public:
-        /**
-         * @enum json_error
-         * @brief Error codes related to JSON serialization.
-         */
-        enum class json_error
-        {
-            json_object_creation_error ///< Failed to create a JSON object.
-        };
-
         /**
          * @enum sysstats_error
          * @brief Error codes related to system statistics retrieval.
@@ -74,40 +87,141 @@ namespace ob
         enum class sysstats_error
         {
             failed_to_get_hostname,    ///< Unable to retrieve the system hostname.
-            failed_to_get_sysinfo,     ///< Unable to retrieve system uptime and memory info.
+            failed_to_get_uptime,      ///< Unable to retrieve the system uptime.
             failed_to_get_disk_stats,  ///< Unable to retrieve disk usage statistics.
-            failed_to_parse_meminfo    ///< Unable to parse /proc/meminfo for detailed memory info.
+            failed_to_parse_meminfo,   ///< Unable to parse /proc/meminfo for detailed memory info.
+            failed_to_get_cpu_stats,   ///< Unable to read or parse /proc/stat.
+            failed_to_get_process_stats, ///< Unable to scan the processes in /proc.
+            failed_to_get_mount_stats, ///< Unable to read /proc/self/mountinfo.
+            failed_to_get_block_device_stats, ///< Unable to read /proc/diskstats.
+            failed_to_get_network_stats, ///< Unable to dump the network interfaces over netlink.
+            out_of_memory              ///< The memory limit was reached; an optional collector was shed.
         };
 
+        /**
+         * @brief Constructs a SystemInfo object, opening the procfs files it re-reads every cycle.
+         * @param config Collector tunables.
+         * @throws std::runtime_error if /proc, one of the procfs files read every cycle or the
+         *         netlink socket cannot be opened.
+         */
+        SystemInfo(const SystemInfoConfig &config = {});
+
         /**
          * @brief Reads and populates the system information.
          *
-         * This method collects system data including hostname, uptime, memory, and disk statistics.
-         * All memory and disk sizes are reported in KiB.
+         * This method collects system data including hostname, uptime, memory, disk, CPU,
+         * top process, per-mount, block device I/O, network interface, pressure and cgroup statistics.
+         * All memory and disk sizes are reported in KiB; CPU utilization is computed against the
+         * previous call.
+         *
+         * Hostname, uptime, memory and disk are needed by every report, so their failure ends the
+         * call. The other collectors are independent: one failing is reported, and the rest still
+         * run.
+         *
+         * In arena mode, running out of memory sheds an optional collector (see shed()).
          *
          * @return std::optional<sysstats_error>
          *         - An empty optional indicates success.
-         *         - A non-empty optional contains the error code corresponding to the failure encountered.
+         *         - A non-empty optional contains the error code of the first failure encountered.
+         * @throws std::bad_alloc if memory runs out with no optional collector left to shed.
          */
         std::optional<sysstats_error> readSysInfo();
 
         /**
-         * @brief Serializes the system information to a JSON string.
+         * @brief Drops an optional collector to free memory.
          *
-         * Converts the collected system statistics into a human-readable, pretty-printed JSON string.
-         * On success, the function returns the JSON string wrapped in an std::expected.
+         * Used when an allocation fails in arena mode. The process collector goes first, as its
+         * tables grow with the number of processes, then the cgroup collector. Its section is
+         * left out of later reports.
          *
-         * @return std::expected<const std::string, json_error>
-         *         - On success, an expected containing the JSON string.
-         *         - On failure (e.g., when a JSON object cannot be created), an unexpected containing the appropriate json_error.
+         * @return false if every optional collector was already dropped.
          */
-        std::expected<const std::string, json_error> toJson();
+        bool shed();
+
+        /**
+         * @brief Serializes the system information to JSON.
+         *
+         * The document is written into a buffer owned by this object, which is reused by the next
+         * call, so no allocation happens once the buffer has grown to the size of a report. It is
+         * pretty-printed if SystemInfoConfig::pretty_json was set.
+         *
+         * If the buffer cannot grow in arena mode, optional collectors are shed until the report fits.
+         *
+         * @return std::string_view The JSON document, valid until the next call to toJson().
+         * @throws std::bad_alloc if the report does not fit even without optional collectors.
+         */
+        std::string_view toJson();
+
+        /**
+         * @brief Appends the report to @p json as the next value, e.g. one element of an array of samples.
+         *
+         * The object is the one toJson() returns, with a leading "timestamp" member if
+         * @p timestamp_ms is given.
+         *
+         * @param json         Writer positioned inside an array, or after a key.
+         * @param timestamp_ms Sampling time, in milliseconds since the Unix epoch.
+         * @throws std::bad_alloc in arena mode if the writer cannot grow; the partially
+         *         written object is discarded first.
+         */
+        void appendJson(JsonWriter &json, std::optional<int64_t> timestamp_ms);
+
+        /**
+         * @brief Serializes the system information to CBOR.
+         *
+         * Same document as toJson(), in the same buffer-reusing and shedding way.
+         *
+         * @return std::string_view The CBOR document, valid until the next call to toCbor().
+         * @throws std::bad_alloc if the report does not fit even without optional collectors.
+         */
+        std::string_view toCbor();
+
+        /**
+         * @brief Appends the report to @p cbor as one element of an array of samples, like appendJson().
+         */
+        void appendCbor(CborWriter &cbor, std::optional<int64_t> timestamp_ms);
+
+        /**
+         * @brief Records the report in @p flat as a list of paths and values.
+         *
+         * Same document as toJson(), with a leading "timestamp" member if @p timestamp_ms is
+         * given; optional collectors are shed until it fits.
+         *
+         * @throws std::bad_alloc if the report does not fit even without optional collectors.
+         */
+        void flatten(FlatWriter &flat, std::optional<int64_t> timestamp_ms = std::nullopt);
 
     private:
+        std::optional<sysstats_error> collect();
+
+        template <typename Writer>
+        void serialize(Writer &writer, std::optional<int64_t> timestamp_ms = std::nullopt);
+        template <typename Writer>
+        void appendReport(Writer &writer, std::optional<int64_t> timestamp_ms);
+        template <typename Writer>
+        void writeReport(Writer &json, std::optional<int64_t> timestamp_ms);
+
         std::string hostname; ///< System hostname.
         int64_t uptime;       ///< System uptime in seconds.
-        DiskStats disk;       ///< Disk usage statistics.
+        DiskStats disk;       ///< Disk usage statistics of the root filesystem.
         MemoryStats memory;   ///< Memory usage statistics.
+        CpuStats cpu;         ///< CPU utilization statistics.
+        ProcessStats processes; ///< Top processes by CPU and RSS.
+        std::vector<MountStats> mounts; ///< Usage of every reported mount.
+        std::vector<BlockDeviceStats> block_devices; ///< I/O activity of every active block device.
+        std::vector<InterfaceStats> interfaces; ///< Traffic of every network interface.
+        std::array<PressureStats, num_pressure_resources> pressure; ///< PSI, indexed by PressureResource.
+        std::vector<CgroupStats> cgroups; ///< Usage of every populated cgroup.
+
+        JsonWriter writer;          ///< Reused by every toJson() call.
+        CborWriter cbor_writer;     ///< Reused by every toCbor() call.
+        procfs::File meminfo_file;  ///< Persistent /proc/meminfo handle.
+        CpuCollector cpu_collector; ///< /proc/stat sampler holding the previous CPU counters.
+        std::optional<ProcessCollector> process_collector; ///< Process scanner; empty when disabled.
+        MountCollector mount_collector; ///< Mount table watcher.
+        BlockDeviceCollector block_device_collector; ///< /proc/diskstats sampler.
+        NetworkCollector network_collector; ///< Netlink interface counters sampler.
+        PressureCollector pressure_collector; ///< /proc/pressure reader.
+        std::optional<CgroupCollector> cgroup_collector; ///< cgroup v2 tree watcher; empty when disabled.
     };
 }
 
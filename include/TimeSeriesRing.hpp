@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef TIMESERIESRING_HPP
+#define TIMESERIESRING_HPP
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "FlatWriter.hpp"
+#include "SystemInfo.hpp"
+
+namespace ob
+{
+    /**
+     * @struct RangeSummary
+     * @brief Aggregates of a field over a time range.
+     */
+    struct RangeSummary
+    {
+        size_t count; ///< Samples in the range that have the field.
+        double min;
+        double max;
+        double avg;
+    };
+
+    /**
+     * @class TimeSeriesRing
+     * @brief Keeps the numeric fields of the last samples, one contiguous array per field.
+     *
+     * Every sample is taken as the leaves recorded by a FlatWriter; integers, doubles and bools
+     * are stored as doubles, in the column of their path, while strings and empty containers
+     * are left out. A sample missing a field, e.g. of a mount that disappeared, holds NaN in
+     * that column. Once the ring is full, each sample overwrites the oldest one.
+     *
+     * All the columns are allocated by the constructor, so memory is fixed at
+     * (max_fields + 1) × capacity × 8 bytes, the extra array holding the timestamps. A path
+     * seen for the first time takes a free column, or the column of a field that has been
+     * absent from the whole ring; when there is none, the field is not recorded.
+     *
+     * Timestamps never go backwards: a sample taken after the clock was stepped back is
+     * recorded at the time of the previous one, so that ranges can be found by bisection.
+     */
+    class TimeSeriesRing
+    {
+    public:
+        /**
+         * @param capacity   Samples kept.
+         * @param max_fields Columns available to fields.
+         * @throws std::runtime_error if the columns do not fit in memory.
+         */
+        TimeSeriesRing(size_t capacity, size_t max_fields);
+
+        /**
+         * @brief Records a sample taken at @p timestamp_ms, overwriting the oldest one if the ring is full.
+         */
+        void add(int64_t timestamp_ms, std::span<const FlatWriter::Entry> sample);
+
+        /**
+         * @brief Records the current report of @p sysinfo.
+         * @throws std::bad_alloc in arena mode if the report does not fit.
+         */
+        void add(int64_t timestamp_ms, SystemInfo &sysinfo);
+
+        /**
+         * @brief Aggregates the values of @p path in samples taken from @p from_ms to @p to_ms, inclusive.
+         * @return An empty optional if the field has no value in that range.
+         */
+        std::optional<RangeSummary> query(std::string_view path, int64_t from_ms, int64_t to_ms) const;
+
+        /**
+         * @brief Calls @p f with the path of every field that has a value in the ring, in column order.
+         */
+        void forEachField(const std::function<void(std::string_view)> &f) const;
+
+        size_t size() const { return total < capacity_ ? total : capacity_; }
+        size_t capacity() const { return capacity_; }
+        bool empty() const { return total == 0; }
+
+        /**
+         * @brief Timestamp of the oldest sample kept; the ring must not be empty.
+         */
+        int64_t oldest() const { return timestamps[slotOf(0)]; }
+
+        /**
+         * @brief Timestamp of the newest sample; the ring must not be empty.
+         */
+        int64_t newest() const { return timestamps[slotOf(size() - 1)]; }
+
+        /**
+         * @brief Values left out so far because every column was taken.
+         */
+        uint64_t droppedValues() const { return dropped; }
+
+        /**
+         * @brief Bytes taken by the columns and the timestamps.
+         */
+        size_t memoryUsage() const { return (values.size() + timestamps.size()) * sizeof(double); }
+
+    private:
+        struct Field
+        {
+            std::string path;
+            uint64_t last_seen; ///< Number of the last sample that had the field.
+        };
+
+        struct PathHash
+        {
+            using is_transparent = void;
+            size_t operator()(std::string_view path) const { return std::hash<std::string_view>{}(path); }
+        };
+
+        size_t capacity_;
+        size_t max_fields;
+        std::vector<double> values;     ///< max_fields columns of capacity values.
+        std::vector<int64_t> timestamps;
+        std::vector<Field> fields;      ///< Field of each column in use.
+        std::unordered_map<std::string, size_t, PathHash, std::equal_to<>> index; ///< Path to column.
+        std::vector<size_t> previous;   ///< Column of each entry of the last sample.
+        uint64_t total = 0;             ///< Samples added so far.
+        uint64_t dropped = 0;
+        FlatWriter flat;
+
+        /** Slot holding the @p i-th oldest sample kept. */
+        size_t slotOf(size_t i) const { return (total < capacity_ ? i : (total + i) % capacity_); }
+
+        double *column(size_t field) { return values.data() + field * capacity_; }
+        const double *column(size_t field) const { return values.data() + field * capacity_; }
+
+        std::optional<size_t> resolve(const std::string &path, size_t position);
+    };
+}
+
+#endif // TIMESERIESRING_HPP
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef ALLOC_UTILS_H
+#define ALLOC_UTILS_H
+#ifdef COUNT_ALLOCATIONS
+#include <stdint.h>
+#ifdef __cplusplus
+extern "C" {
+#endif
+/**
+ * @brief Number of heap allocations made by the process so far, from any thread.
+ *
+ * malloc() and friends are interposed, so allocations made by libraries (libcurl,
+ * libstdc++) are counted as well.
+ */
+uint64_t alloc_count(void);
+#ifdef __cplusplus
+}
+#endif
+#define ALLOC_COUNT() alloc_count()
+#else
+#define ALLOC_COUNT() 0
+#endif
+#endif // ALLOC_UTILS_H
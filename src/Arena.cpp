@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+#include "Arena.hpp"
+
+using namespace std;
+using namespace ob;
+
+// the arena must outlive every object allocated from it, so it is built in static storage
+// and never destroyed
+alignas(Arena) static unsigned char arena_storage[sizeof(Arena)];
+static atomic<Arena *> arena_instance{nullptr};
+
+Arena::Arena(char *base, size_t capacity)
+    : base(base), capacity(capacity)
+{
+}
+
+/**
+ * @brief Maps an arena of @p capacity bytes and routes operator new to it.
+ *
+ * The mapping is reserved without being populated, so pages only become resident as
+ * blocks are carved from them.
+ */
+Arena *Arena::create(size_t capacity)
+{
+    if (arena_instance.load() || capacity == 0)
+        return nullptr;
+
+    void *mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED)
+        return nullptr;
+
+    Arena *arena = new (arena_storage) Arena(static_cast<char *>(mapping), capacity);
+    arena_instance.store(arena, memory_order_release);
+    return arena;
+}
+
+Arena *Arena::get() noexcept
+{
+    return arena_instance.load(memory_order_acquire);
+}
+
+void *Arena::allocate(size_t size, size_t alignment) noexcept
+{
+    const size_t offset = alignment > sizeof(Header) ? alignment : sizeof(Header);
+    if (alignment > max_alignment || size > capacity || offset > capacity - size)
+    {
+        lock_guard<mutex> guard(lock);
+        failed++;
+        return nullptr;
+    }
+    const size_t needed = max(offset + size, blockSize(0));
+    const size_t size_class = bit_width(needed - 1) - min_block_shift;
+    const size_t block_size = blockSize(size_class);
+
+    lock_guard<mutex> guard(lock);
+
+    char *block;
+    if (free_lists[size_class])
+    {
+        block = reinterpret_cast<char *>(free_lists[size_class]);
+        free_lists[size_class] = free_lists[size_class]->next;
+    }
+    else
+    {
+        // carve from the untouched end; blocks are aligned to their own size, up to a page,
+        // which covers the alignment of any request of their size
+        const size_t block_align = min(block_size, max_alignment);
+        const size_t start = (carved + block_align - 1) & ~(block_align - 1);
+        if (start > capacity || block_size > capacity - start)
+        {
+            failed++;
+            return nullptr;
+        }
+        block = base + start;
+        carved = start + block_size;
+    }
+
+    char *payload = block + offset;
+    Header *header = reinterpret_cast<Header *>(payload) - 1;
+    header->size_class = size_class;
+    header->offset = offset;
+    header->requested = size;
+
+    in_use += size;
+    if (in_use > in_use_peak)
+        in_use_peak = in_use;
+
+    return payload;
+}
+
+void Arena::deallocate(void *ptr) noexcept
+{
+    const Header *header = static_cast<const Header *>(ptr) - 1;
+    char *block = static_cast<char *>(ptr) - header->offset;
+    const size_t size_class = header->size_class;
+
+    lock_guard<mutex> guard(lock);
+    in_use -= header->requested;
+    FreeBlock *free_block = reinterpret_cast<FreeBlock *>(block);
+    free_block->next = free_lists[size_class];
+    free_lists[size_class] = free_block;
+}
+
+Arena::Stats Arena::stats() noexcept
+{
+    lock_guard<mutex> guard(lock);
+    return {capacity, carved, in_use, in_use_peak, failed};
+}
+
+/**
+ * @brief Allocates from the arena once it exists, from malloc() before that.
+ */
+static void *allocate(size_t size, size_t alignment) noexcept
+{
+    if (size == 0)
+        size = 1;
+    if (Arena *arena = Arena::get())
+        return arena->allocate(size, alignment);
+    if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+        return malloc(size);
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+static void deallocate(void *ptr) noexcept
+{
+    if (!ptr)
+        return;
+    Arena *arena = Arena::get();
+    if (arena && arena->owns(ptr))
+        arena->deallocate(ptr);
+    else
+        free(ptr);
+}
+
+static void *allocateOrThrow(size_t size, size_t alignment)
+{
+    void *ptr = allocate(size, alignment);
+    if (!ptr)
+        throw bad_alloc();
+    return ptr;
+}
+
+void *operator new(size_t size)
+{
+    return allocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](size_t size)
+{
+    return allocateOrThrow(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(size_t size, align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, align_val_t alignment)
+{
+    return allocateOrThrow(size, static_cast<size_t>(alignment));
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(size_t size, align_val_t alignment, const nothrow_t &) noexcept
+{
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void *operator new[](size_t size, align_val_t alignment, const nothrow_t &) noexcept
+{
+    return allocate(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, align_val_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, size_t, align_val_t) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, size_t, align_val_t) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, const nothrow_t &) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, const nothrow_t &) noexcept { deallocate(ptr); }
+void operator delete(void *ptr, align_val_t, const nothrow_t &) noexcept { deallocate(ptr); }
+void operator delete[](void *ptr, align_val_t, const nothrow_t &) noexcept { deallocate(ptr); }
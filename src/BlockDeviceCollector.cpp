@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <time.h>
+#include <unistd.h>
+
+#include "BlockDeviceCollector.hpp"
+
+using namespace std;
+using namespace ob;
+
+/* Sectors in /proc/diskstats are always 512 bytes, whatever the device's block size. */
+static constexpr double sector_size = 512;
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+ */
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Difference between two samples of a counter that may have wrapped.
+ *
+ * The millisecond counters are 32-bit in the kernel, and on 32-bit kernels every counter
+ * is; a counter that went backwards from a value that fits in 32 bits wrapped at 2^32,
+ * otherwise at 2^64 (which unsigned arithmetic handles by itself).
+ */
+static inline uint64_t wrappingDelta(uint64_t current, uint64_t previous)
+{
+    if (current >= previous)
+        return current - previous;
+    if (previous <= UINT32_MAX)
+        return current + (static_cast<uint64_t>(UINT32_MAX) + 1 - previous);
+    return current - previous;
+}
+
+/**
+ * @brief Tells whether @p name is a partition, using /sys/class/block/<name>/partition.
+ */
+static bool isPartition(const char *name)
+{
+    char path[96];
+    snprintf(path, sizeof(path), "/sys/class/block/%s/partition", name);
+    return access(path, F_OK) == 0;
+}
+
+BlockDeviceCollector::BlockDeviceCollector()
+    : diskstats_file("/proc/diskstats")
+{
+    if (!diskstats_file.isOpen())
+    {
+        throw runtime_error("Failed to open /proc/diskstats");
+    }
+}
+
+/**
+ * @brief Finds the state of a device, trying position @p hint first since rows keep their order.
+ */
+BlockDeviceCollector::Device *BlockDeviceCollector::findDevice(uint32_t major, uint32_t minor, size_t hint)
+{
+    if (hint < devices_state.size() && devices_state[hint].major == major && devices_state[hint].minor == minor)
+        return &devices_state[hint];
+
+    for (auto &device : devices_state)
+    {
+        if (device.major == major && device.minor == minor)
+            return &device;
+    }
+    return nullptr;
+}
+
+optional<BlockDeviceCollector::error> BlockDeviceCollector::collect(vector<BlockDeviceStats> &devices)
+{
+    const auto text = diskstats_file.read();
+    if (!text.has_value())
+    {
+        return error::read_failed;
+    }
+    const uint64_t now_ns = monotonicNs();
+    const double elapsed_s = previous_ns ? (now_ns - previous_ns) / 1e9 : 0;
+
+    for (auto &device : devices_state)
+        device.seen = false;
+    devices.clear();
+
+    size_t row = 0;
+    procfs::Scanner scanner(text.value());
+    procfs::Line line;
+    for (; scanner.next(line); row++)
+    {
+        uint64_t major, minor;
+        if (!line.u64(major) || !line.u64(minor))
+            continue;
+        const auto name = line.token();
+        if (name.empty())
+            continue;
+
+        uint64_t counters[num_counters];
+        for (size_t i = 0; i < num_counters; i++)
+            counters[i] = line.u64();
+
+        Device *device = findDevice(major, minor, row);
+        bool is_new = !device;
+        if (is_new)
+        {
+            device = &devices_state.emplace_back();
+            device->major = major;
+            device->minor = minor;
+            size_t len = min(name.size(), sizeof(device->name) - 1);
+            memcpy(device->name, name.data(), len);
+            device->name[len] = '\0';
+            device->is_partition = isPartition(device->name);
+        }
+        device->seen = true;
+
+        uint64_t delta[num_counters];
+        for (size_t i = 0; i < num_counters; i++)
+            delta[i] = is_new ? 0 : wrappingDelta(counters[i], device->counters[i]);
+        memcpy(device->counters, counters, sizeof(counters));
+
+        if (device->is_partition || (counters[reads] == 0 && counters[writes] == 0))
+            continue;
+
+        BlockDeviceStats &stats = devices.emplace_back();
+        memcpy(stats.name, device->name, sizeof(stats.name));
+        if (elapsed_s <= 0)
+            continue;
+
+        const double elapsed_ms = elapsed_s * 1000;
+        stats.read_iops = delta[reads] / elapsed_s;
+        stats.write_iops = delta[writes] / elapsed_s;
+        stats.read_bytes_per_s = delta[sectors_read] * sector_size / elapsed_s;
+        stats.write_bytes_per_s = delta[sectors_written] * sector_size / elapsed_s;
+        stats.read_latency_ms = delta[reads] ? static_cast<double>(delta[read_ms]) / delta[reads] : 0;
+        stats.write_latency_ms = delta[writes] ? static_cast<double>(delta[write_ms]) / delta[writes] : 0;
+        stats.queue_depth = delta[time_in_queue] / elapsed_ms;
+        stats.utilization = min(100.0, delta[io_ticks] * 100.0 / elapsed_ms);
+    }
+
+    // forget devices that went away, so a new device reusing the numbers starts afresh
+    erase_if(devices_state, [](const Device &device) { return !device.seen; });
+    previous_ns = now_ns;
+
+    return {};
+}
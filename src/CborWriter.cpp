@@ -0,0 +1,267 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <bit>
+#include <cstring>
+
+#include "CborWriter.hpp"
+
+using namespace std;
+using namespace ob;
+
+namespace
+{
+    constexpr uint8_t major_uint = 0;
+    constexpr uint8_t major_negint = 1;
+    constexpr uint8_t major_text = 3;
+    constexpr uint8_t major_array = 4;
+    constexpr uint8_t major_map = 5;
+    constexpr uint8_t major_simple = 7;
+
+    constexpr uint8_t simple_false = 20;
+    constexpr uint8_t simple_true = 21;
+    constexpr uint8_t simple_float32 = 26;
+    constexpr uint8_t simple_float64 = 27;
+    constexpr uint8_t indefinite = 31;
+    constexpr uint8_t break_code = 0xff;
+}
+
+/**
+ * @brief Appends the @p size low bytes of @p v, most significant first as CBOR requires.
+ */
+static void appendBigEndian(string &buf, uint64_t v, size_t size)
+{
+    for (size_t i = size; i > 0; i--)
+        buf.push_back(static_cast<char>(v >> ((i - 1) * 8)));
+}
+
+void CborWriter::appendHead(uint8_t major, uint64_t argument)
+{
+    const uint8_t type = major << 5;
+    if (argument < 24)
+    {
+        buf.push_back(static_cast<char>(type | argument));
+    }
+    else if (argument <= UINT8_MAX)
+    {
+        buf.push_back(static_cast<char>(type | 24));
+        appendBigEndian(buf, argument, 1);
+    }
+    else if (argument <= UINT16_MAX)
+    {
+        buf.push_back(static_cast<char>(type | 25));
+        appendBigEndian(buf, argument, 2);
+    }
+    else if (argument <= UINT32_MAX)
+    {
+        buf.push_back(static_cast<char>(type | 26));
+        appendBigEndian(buf, argument, 4);
+    }
+    else
+    {
+        buf.push_back(static_cast<char>(type | 27));
+        appendBigEndian(buf, argument, 8);
+    }
+}
+
+void CborWriter::valueInt(int64_t v)
+{
+    if (v >= 0)
+        appendHead(major_uint, static_cast<uint64_t>(v));
+    else
+        // -1 - n, computed without overflowing on INT64_MIN
+        appendHead(major_negint, ~static_cast<uint64_t>(v));
+}
+
+void CborWriter::value(string_view v)
+{
+    appendHead(major_text, v.size());
+    buf.append(v);
+}
+
+void CborWriter::value(double v)
+{
+    const float narrow = static_cast<float>(v);
+    if (static_cast<double>(narrow) == v)
+    {
+        buf.push_back(static_cast<char>(major_simple << 5 | simple_float32));
+        appendBigEndian(buf, bit_cast<uint32_t>(narrow), 4);
+    }
+    else
+    {
+        buf.push_back(static_cast<char>(major_simple << 5 | simple_float64));
+        appendBigEndian(buf, bit_cast<uint64_t>(v), 8);
+    }
+}
+
+namespace
+{
+    /**
+     * @class CborReader
+     * @brief Recursive-descent reader of the CBOR subset written by CborWriter.
+     */
+    class CborReader
+    {
+    public:
+        CborReader(string_view in, JsonWriter &json) : in(in), json(json) {}
+
+        bool document()
+        {
+            return item(0) && pos == in.size();
+        }
+
+    private:
+        static constexpr int max_depth = 16;
+
+        string_view in;
+        size_t pos = 0;
+        JsonWriter &json;
+
+        bool readBigEndian(size_t size, uint64_t &v)
+        {
+            if (in.size() - pos < size)
+                return false;
+            v = 0;
+            for (size_t i = 0; i < size; i++)
+                v = v << 8 | static_cast<unsigned char>(in[pos++]);
+            return true;
+        }
+
+        /**
+         * @brief Reads the argument following an initial byte whose low bits are @p info.
+         */
+        bool argument(uint8_t info, uint64_t &v)
+        {
+            if (info < 24)
+            {
+                v = info;
+                return true;
+            }
+            if (info > 27)
+                return false;
+            return readBigEndian(size_t(1) << (info - 24), v);
+        }
+
+        bool text(uint8_t info, string_view &s)
+        {
+            uint64_t size;
+            if (!argument(info, size) || in.size() - pos < size)
+                return false;
+            s = in.substr(pos, size);
+            pos += size;
+            return true;
+        }
+
+        bool atBreak() const
+        {
+            return pos < in.size() && static_cast<unsigned char>(in[pos]) == break_code;
+        }
+
+        /**
+         * @brief Reads the items of an array or map, @p count of them or up to a break if indefinite.
+         */
+        template <typename F>
+        bool items(uint8_t info, F &&read)
+        {
+            if (info == indefinite)
+            {
+                while (!atBreak())
+                {
+                    if (pos >= in.size() || !read())
+                        return false;
+                }
+                pos++;
+                return true;
+            }
+            uint64_t count;
+            if (!argument(info, count))
+                return false;
+            for (uint64_t i = 0; i < count; i++)
+            {
+                if (!read())
+                    return false;
+            }
+            return true;
+        }
+
+        bool item(int depth)
+        {
+            if (pos >= in.size() || depth >= max_depth)
+                return false;
+            const uint8_t initial = static_cast<unsigned char>(in[pos++]);
+            const uint8_t major = initial >> 5;
+            const uint8_t info = initial & 0x1f;
+            uint64_t v;
+
+            switch (major)
+            {
+            case major_uint:
+                if (!argument(info, v))
+                    return false;
+                json.value(v);
+                return true;
+            case major_negint:
+                if (!argument(info, v) || v > INT64_MAX)
+                    return false;
+                json.value(static_cast<int64_t>(~v));
+                return true;
+            case major_text:
+            {
+                string_view s;
+                if (!text(info, s))
+                    return false;
+                json.value(s);
+                return true;
+            }
+            case major_array:
+                json.beginArray();
+                if (!items(info, [&] { return item(depth + 1); }))
+                    return false;
+                json.endArray();
+                return true;
+            case major_map:
+                json.beginObject();
+                if (!items(info, [&]
+                {
+                    string_view k;
+                    if (pos >= in.size() || static_cast<unsigned char>(in[pos]) >> 5 != major_text)
+                        return false;
+                    if (!text(static_cast<unsigned char>(in[pos++]) & 0x1f, k))
+                        return false;
+                    json.key(k);
+                    return item(depth + 1);
+                }))
+                    return false;
+                json.endObject();
+                return true;
+            case major_simple:
+                if (info == simple_false || info == simple_true)
+                {
+                    json.value(info == simple_true);
+                    return true;
+                }
+                if (info == simple_float32 && readBigEndian(4, v))
+                {
+                    json.value(static_cast<double>(bit_cast<float>(static_cast<uint32_t>(v))));
+                    return true;
+                }
+                if (info == simple_float64 && readBigEndian(8, v))
+                {
+                    json.value(bit_cast<double>(v));
+                    return true;
+                }
+                return false;
+            default:
+                return false;
+            }
+        }
+    };
+}
+
+bool ob::cborToJson(string_view cbor, JsonWriter &json)
+{
+    json.reset();
+    return CborReader(cbor, json).document();
+}
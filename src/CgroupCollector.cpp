@@ -0,0 +1,366 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/magic.h>
+#include <sys/inotify.h>
+#include <sys/statfs.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "CgroupCollector.hpp"
+#include "Procfs.hpp"
+
+using namespace std;
+using namespace ob;
+
+/* io.stat has one line per device; this fits well over fifty of them. */
+static constexpr size_t stat_buffer_size = 8192;
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+ */
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Returns whether @p path is the mount point of a cgroup v2 filesystem.
+ */
+static bool isCgroup2(const char *path)
+{
+    struct statfs s;
+    return statfs(path, &s) == 0 && s.f_type == CGROUP2_SUPER_MAGIC;
+}
+
+/**
+ * @brief Reads the small file @p name of the cgroup directory @p dirfd into @p buf.
+ * @return The contents, empty if the file does not exist (e.g. a disabled controller).
+ */
+static string_view readAt(int dirfd, const char *name, char *buf, size_t size)
+{
+    int fd = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return {};
+
+    ssize_t len = read(fd, buf, size);
+    close(fd);
+    return len > 0 ? string_view(buf, len) : string_view();
+}
+
+/**
+ * @brief Returns the prefix shared by the paths of every descendant of @p path.
+ */
+static string childPrefix(const string &path)
+{
+    return path == "/" ? path : path + "/";
+}
+
+CgroupCollector::CgroupCollector(unsigned max_depth)
+    : max_depth(max_depth), events_buf(4096)
+{
+    if (isCgroup2("/sys/fs/cgroup"))
+        root = "/sys/fs/cgroup";
+    else if (isCgroup2("/sys/fs/cgroup/unified"))
+        root = "/sys/fs/cgroup/unified";
+    else
+        return;
+
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    int dirfd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd < 0)
+    {
+        root.clear();
+        return;
+    }
+    addSubtree("/", dirfd, 0);
+}
+
+CgroupCollector::~CgroupCollector()
+{
+    for (auto &[path, node] : nodes)
+    {
+        if (node.dirfd >= 0)
+            close(node.dirfd);
+    }
+    if (inotify_fd >= 0)
+        close(inotify_fd);
+}
+
+/**
+ * @brief Starts tracking the cgroup at @p path and, within max_depth, its descendants.
+ */
+void CgroupCollector::addSubtree(const string &path, int dirfd, unsigned depth)
+{
+    Node &node = nodes[path];
+    node.dirfd = dirfd;
+    node.depth = depth;
+
+    const string fs_path = path == "/" ? root : root + path;
+    if (inotify_fd >= 0 && depth < max_depth)
+    {
+        node.dir_wd = inotify_add_watch(inotify_fd, fs_path.c_str(), IN_CREATE | IN_DELETE | IN_ONLYDIR);
+        if (node.dir_wd >= 0)
+            watches[node.dir_wd] = path;
+    }
+    if (inotify_fd >= 0 && depth > 0)
+    {
+        node.events_wd = inotify_add_watch(inotify_fd, (fs_path + "/cgroup.events").c_str(), IN_MODIFY);
+        if (node.events_wd >= 0)
+            watches[node.events_wd] = path;
+    }
+
+    readPopulated(node);
+    rescanChildren(path, node);
+}
+
+/**
+ * @brief Stops tracking the cgroup at @p path and all its descendants.
+ */
+void CgroupCollector::removeSubtree(const string &path)
+{
+    const string prefix = childPrefix(path);
+    auto it = nodes.lower_bound(path);
+    while (it != nodes.end() && (it->first == path || it->first.starts_with(prefix)))
+    {
+        Node &node = it->second;
+        // the kernel drops the watches of removed directories by itself; removing them again is harmless
+        for (int wd : {node.dir_wd, node.events_wd})
+        {
+            if (wd >= 0)
+            {
+                inotify_rm_watch(inotify_fd, wd);
+                watches.erase(wd);
+            }
+        }
+        close(node.dirfd);
+        it = nodes.erase(it);
+    }
+}
+
+/**
+ * @brief Lists the child cgroups of @p path and adds or removes nodes to match.
+ */
+void CgroupCollector::rescanChildren(const string &path, Node &node)
+{
+    node.rescan = false;
+    if (node.depth >= max_depth)
+        return;
+
+    int fd = openat(node.dirfd, ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+    DIR *dir = fdopendir(fd);
+    if (!dir)
+    {
+        close(fd);
+        return;
+    }
+
+    const string prefix = childPrefix(path);
+    vector<string> present;
+    while (struct dirent *ent = readdir(dir))
+    {
+        if (ent->d_type == DT_DIR && strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0)
+            present.push_back(prefix + ent->d_name);
+    }
+    closedir(dir);
+
+    // drop direct children that are gone
+    vector<string> gone;
+    for (auto it = nodes.upper_bound(path); it != nodes.end() && it->first.starts_with(prefix); ++it)
+    {
+        if (it->first.find('/', prefix.size()) == string::npos &&
+            find(present.begin(), present.end(), it->first) == present.end())
+            gone.push_back(it->first);
+    }
+    for (const auto &child : gone)
+        removeSubtree(child);
+
+    for (const auto &child : present)
+    {
+        if (nodes.contains(child))
+            continue;
+        int child_fd = openat(node.dirfd, child.c_str() + prefix.size(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (child_fd >= 0)
+            addSubtree(child, child_fd, node.depth + 1);
+    }
+}
+
+/**
+ * @brief Reads the `populated` flag of cgroup.events; the root cgroup is always populated.
+ */
+void CgroupCollector::readPopulated(Node &node)
+{
+    node.reread_events = false;
+    if (node.depth == 0)
+        return;
+
+    char buf[256];
+    procfs::Scanner scanner(readAt(node.dirfd, "cgroup.events", buf, sizeof(buf)));
+    procfs::Line line;
+    while (scanner.next(line))
+    {
+        if (line.token() == "populated")
+            node.populated = line.u64() != 0;
+    }
+}
+
+/**
+ * @brief Reads the pending inotify events and flags the nodes they concern.
+ * @return false if events were lost and everything has to be re-scanned.
+ */
+bool CgroupCollector::drainEvents()
+{
+    bool complete = true;
+    for (;;)
+    {
+        ssize_t len = read(inotify_fd, events_buf.data(), events_buf.size());
+        if (len <= 0)
+            break;
+
+        for (char *p = events_buf.data(); p < events_buf.data() + len;)
+        {
+            const auto *event = reinterpret_cast<const struct inotify_event *>(p);
+            p += sizeof(struct inotify_event) + event->len;
+
+            if (event->mask & IN_Q_OVERFLOW)
+            {
+                complete = false;
+                continue;
+            }
+            auto watch = watches.find(event->wd);
+            if (watch == watches.end())
+                continue;
+            auto node = nodes.find(watch->second);
+            if (node == nodes.end())
+                continue;
+
+            if (event->wd == node->second.events_wd && (event->mask & IN_MODIFY))
+                node->second.reread_events = true;
+            else if (event->wd == node->second.dir_wd && (event->mask & (IN_CREATE | IN_DELETE)))
+                node->second.rescan = true;
+        }
+    }
+    return complete;
+}
+
+/**
+ * @brief Reads memory.current, memory.events, cpu.stat and io.stat of one cgroup.
+ */
+void CgroupCollector::readStats(const string &path, Node &node, CgroupStats &stats, double elapsed_us)
+{
+    static constexpr auto memory_event_keys = procfs::makeKeySet("high", "max", "oom", "oom_kill");
+    static constexpr auto cpu_keys = procfs::makeKeySet("usage_usec", "nr_throttled", "throttled_usec");
+    static constexpr auto io_keys = procfs::makeKeySet("rbytes", "wbytes", "rios", "wios");
+
+    char buf[stat_buffer_size];
+    procfs::Line line;
+
+    stats.path.assign(path);
+
+    uint64_t memory_current = 0;
+    const auto current_text = readAt(node.dirfd, "memory.current", buf, sizeof(buf));
+    procfs::parseU64(current_text.data(), current_text.data() + current_text.size(), memory_current);
+    stats.memory_current = memory_current / 1024;
+
+    uint64_t *memory_events[] = {&stats.memory_high_events, &stats.memory_max_events,
+                                 &stats.memory_oom_events, &stats.memory_oom_kill_events};
+    for (auto *value : memory_events)
+        *value = 0;
+    for (procfs::Scanner scanner(readAt(node.dirfd, "memory.events", buf, sizeof(buf))); scanner.next(line);)
+    {
+        int idx = memory_event_keys.find(line.token());
+        if (idx >= 0)
+            *memory_events[idx] = line.u64();
+    }
+
+    uint64_t *cpu_values[] = {&stats.cpu_usage_usec, &stats.nr_throttled, &stats.throttled_usec};
+    for (auto *value : cpu_values)
+        *value = 0;
+    for (procfs::Scanner scanner(readAt(node.dirfd, "cpu.stat", buf, sizeof(buf))); scanner.next(line);)
+    {
+        int idx = cpu_keys.find(line.token());
+        if (idx >= 0)
+            *cpu_values[idx] = line.u64();
+    }
+    stats.cpu_percentage = (elapsed_us > 0 && node.previous_usage_usec && stats.cpu_usage_usec >= node.previous_usage_usec)
+                               ? (stats.cpu_usage_usec - node.previous_usage_usec) * 100.0 / elapsed_us
+                               : 0;
+    node.previous_usage_usec = stats.cpu_usage_usec;
+
+    // `8:0 rbytes=1 wbytes=2 rios=3 wios=4 dbytes=0 dios=0`, one line per device
+    uint64_t *io_values[] = {&stats.io_rbytes, &stats.io_wbytes, &stats.io_rios, &stats.io_wios};
+    for (auto *value : io_values)
+        *value = 0;
+    for (procfs::Scanner scanner(readAt(node.dirfd, "io.stat", buf, sizeof(buf))); scanner.next(line);)
+    {
+        line.skip(1);
+        for (auto token = line.token(); !token.empty(); token = line.token())
+        {
+            size_t eq = token.find('=');
+            int idx = eq == string_view::npos ? -1 : io_keys.find(token.substr(0, eq));
+            if (idx < 0)
+                continue;
+            uint64_t value;
+            procfs::parseU64(token.data() + eq + 1, token.data() + token.size(), value);
+            *io_values[idx] += value;
+        }
+    }
+}
+
+optional<CgroupCollector::error> CgroupCollector::collect(vector<CgroupStats> &cgroups)
+{
+    size_t count = 0;
+    optional<error> result;
+
+    if (!root.empty())
+    {
+        if (inotify_fd < 0 || !drainEvents())
+        {
+            // without events there is no telling what changed: re-scan the whole tree
+            for (auto &[path, node] : nodes)
+                node.rescan = node.reread_events = true;
+            if (inotify_fd >= 0)
+                result = error::inotify_failed;
+        }
+
+        vector<string> rescan;
+        for (auto &[path, node] : nodes)
+        {
+            if (node.reread_events)
+                readPopulated(node);
+            if (node.rescan)
+                rescan.push_back(path);
+        }
+        for (const auto &path : rescan)
+        {
+            auto it = nodes.find(path);
+            if (it != nodes.end())
+                rescanChildren(path, it->second);
+        }
+
+        const uint64_t now_ns = monotonicNs();
+        const double elapsed_us = previous_ns ? (now_ns - previous_ns) / 1e3 : 0;
+        for (auto &[path, node] : nodes)
+        {
+            if (!node.populated)
+                continue;
+            if (count == cgroups.size())
+                cgroups.emplace_back();
+            readStats(path, node, cgroups[count++], elapsed_us);
+        }
+        previous_ns = now_ns;
+    }
+
+    cgroups.resize(count);
+    return result;
+}
@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <bit>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+
+#include "ColumnarWriter.hpp"
+
+using namespace std;
+using namespace ob;
+
+namespace
+{
+    constexpr string_view magic("OBC\x01", 4);
+
+    /**
+     * @enum ColumnType
+     * @brief Type byte of a column.
+     */
+    enum ColumnType : uint8_t
+    {
+        type_int = 0,
+        type_uint = 1,
+        type_double = 2,
+        type_bool = 3,
+        type_string = 4,
+        type_empty_object = 5,
+        type_empty_array = 6,
+        type_timestamp = 7
+    };
+
+    /** Bytes a value can take at most, besides the bytes of a string. */
+    constexpr size_t max_value_size = 24;
+
+    constexpr uint64_t zigzag(int64_t v)
+    {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    constexpr int64_t unzigzag(uint64_t v)
+    {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+
+    /**
+     * @struct BitReader
+     * @brief Reads what Bits wrote; reading past the end clears `ok`.
+     */
+    struct BitReader
+    {
+        string_view data;
+        size_t bit = 0;
+        bool ok = true;
+
+        uint64_t read(unsigned count)
+        {
+            uint64_t value = 0;
+            while (count > 0)
+            {
+                if (bit / 8 >= data.size())
+                {
+                    ok = false;
+                    return 0;
+                }
+                const unsigned offset = bit % 8;
+                const unsigned take = min(count, 8 - offset);
+                const uint8_t byte = static_cast<uint8_t>(data[bit / 8]);
+                value = (value << take) | ((byte >> (8 - offset - take)) & ((1u << take) - 1));
+                bit += take;
+                count -= take;
+            }
+            return value;
+        }
+
+        uint64_t readVarint()
+        {
+            uint64_t value = 0;
+            for (unsigned shift = 0; shift < 64; shift += 7)
+            {
+                const uint64_t byte = read(8);
+                value |= (byte & 0x7f) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+            ok = false;
+            return 0;
+        }
+
+        /**
+         * @brief Returns the next @p size bytes; the reader must be at a byte boundary.
+         */
+        string_view readBytes(size_t size)
+        {
+            if (bit % 8 != 0 || size > data.size() - bit / 8)
+            {
+                ok = false;
+                return {};
+            }
+            const string_view bytes = data.substr(bit / 8, size);
+            bit += size * 8;
+            return bytes;
+        }
+    };
+}
+
+static void appendVarint(string &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Returns the column type of @p entry.
+ */
+static uint8_t typeOf(const FlatWriter::Entry &entry)
+{
+    return visit([&](const auto &v) -> uint8_t
+    {
+        using T = decay_t<decltype(v)>;
+        if constexpr (is_same_v<T, int64_t>)
+            return entry.path == "timestamp" ? type_timestamp : type_int;
+        else if constexpr (is_same_v<T, uint64_t>)
+            return type_uint;
+        else if constexpr (is_same_v<T, double>)
+            return type_double;
+        else if constexpr (is_same_v<T, bool>)
+            return type_bool;
+        else if constexpr (is_same_v<T, string>)
+            return type_string;
+        else
+            return v == FlatWriter::Empty::array ? type_empty_array : type_empty_object;
+    }, entry.value);
+}
+
+void ColumnarWriter::Bits::write(uint64_t value, unsigned count)
+{
+    while (count > 0)
+    {
+        if (used == 8)
+        {
+            bytes.push_back(0);
+            used = 0;
+        }
+        const unsigned take = min(count, 8 - used);
+        const uint8_t chunk = (value >> (count - take)) & ((1u << take) - 1);
+        bytes.back() = static_cast<char>(static_cast<uint8_t>(bytes.back()) | (chunk << (8 - used - take)));
+        used += take;
+        count -= take;
+    }
+}
+
+void ColumnarWriter::Bits::writeVarint(uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        write((value & 0x7f) | 0x80, 8);
+        value >>= 7;
+    }
+    write(value, 8);
+}
+
+void ColumnarWriter::Bits::clear()
+{
+    bytes.clear();
+    used = 8;
+}
+
+/**
+ * @brief Returns the column of @p entry, creating it if needed.
+ *
+ * @param cursor Position in `order` right after the column of the previous entry of the
+ *               sample, where the column is looked for first and created otherwise.
+ */
+size_t ColumnarWriter::resolve(const FlatWriter::Entry &entry, size_t &cursor)
+{
+    const uint8_t type = typeOf(entry);
+    if (cursor < order.size())
+    {
+        // samples mostly have the same paths in the same order
+        const Column &expected = columns[order[cursor]];
+        if (expected.type == type && expected.path == entry.path)
+            return order[cursor++];
+    }
+
+    lookup.assign(entry.path);
+    lookup.push_back(static_cast<char>(type));
+    if (auto it = index.find(lookup); it != index.end())
+    {
+        cursor = columns[it->second].position + 1;
+        return it->second;
+    }
+
+    // everything that can throw comes first, so a failure leaves the columns as they were
+    Column column;
+    column.path = entry.path;
+    column.type = type;
+    column.presence.reserve(samples / 8 + 1);
+    for (size_t i = 0; i < samples; i++)
+        column.presence.write(0, 1);
+    columns.reserve(columns.size() + 1);
+    order.reserve(order.size() + 1);
+    const size_t column_index = columns.size();
+    index.emplace(lookup, column_index);
+
+    columns.push_back(std::move(column));
+    order.insert(order.begin() + cursor, column_index);
+    for (size_t position = cursor; position < order.size(); position++)
+        columns[order[position]].position = position;
+    return order[cursor++];
+}
+
+void ColumnarWriter::add(span<const FlatWriter::Entry> sample)
+{
+    attempt++;
+
+    // first resolve the columns and grow every buffer, so writing the values cannot fail
+    resolved.clear();
+    resolved.reserve(sample.size());
+    size_t cursor = 0;
+    for (const auto &entry : sample)
+    {
+        const size_t column_index = resolve(entry, cursor);
+        Column &column = columns[column_index];
+        if (column.stamp == attempt)
+        {
+            // a path given twice keeps its first value
+            resolved.push_back(SIZE_MAX);
+            continue;
+        }
+        column.stamp = attempt;
+        resolved.push_back(column_index);
+
+        if (const auto *s = get_if<string>(&entry.value))
+        {
+            column.values.reserve(s->size() + max_value_size);
+            column.previous_string.reserve(s->size());
+        }
+        else
+        {
+            column.values.reserve(max_value_size);
+        }
+    }
+    for (auto &column : columns)
+        column.presence.reserve(1);
+
+    for (size_t i = 0; i < sample.size(); i++)
+    {
+        if (resolved[i] == SIZE_MAX)
+            continue;
+        Column &column = columns[resolved[i]];
+        column.presence.write(1, 1);
+        encode(column, sample[i].value);
+    }
+    for (auto &column : columns)
+    {
+        if (column.stamp != attempt)
+            column.presence.write(0, 1);
+    }
+    samples++;
+}
+
+/**
+ * @brief Appends @p value to the values of @p column, against the value before it.
+ */
+void ColumnarWriter::encode(Column &column, const FlatWriter::Value &value)
+{
+    Bits &out = column.values;
+    switch (column.type)
+    {
+    case type_int:
+    case type_uint:
+    {
+        // deltas are taken modulo 2^64, so both signednesses share the encoding
+        const uint64_t v = column.type == type_int ? static_cast<uint64_t>(get<int64_t>(value)) : get<uint64_t>(value);
+        out.writeVarint(zigzag(static_cast<int64_t>(v - column.previous)));
+        column.previous = v;
+        break;
+    }
+    case type_timestamp:
+    {
+        const int64_t v = get<int64_t>(value);
+        const int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(v) - column.previous);
+        if (column.present < 2)
+        {
+            // the first value and the first delta as they are
+            out.writeVarint(zigzag(delta));
+        }
+        else
+        {
+            const uint64_t dod = zigzag(delta - column.previous_delta);
+            if (dod == 0)
+                out.write(0, 1);
+            else if (dod < (1u << 7))
+                out.write((0b10 << 7) | dod, 2 + 7);
+            else if (dod < (1u << 9))
+                out.write((0b110 << 9) | dod, 3 + 9);
+            else if (dod < (1u << 12))
+                out.write((0b1110 << 12) | dod, 4 + 12);
+            else
+            {
+                out.write(0b1111, 4);
+                out.write(dod, 64);
+            }
+        }
+        column.previous_delta = column.present == 0 ? 0 : delta;
+        column.previous = static_cast<uint64_t>(v);
+        break;
+    }
+    case type_double:
+    {
+        const uint64_t bits = bit_cast<uint64_t>(get<double>(value));
+        if (column.present == 0)
+        {
+            out.write(bits, 64);
+            column.previous = bits;
+            break;
+        }
+        const uint64_t x = bits ^ column.previous;
+        column.previous = bits;
+        if (x == 0)
+        {
+            out.write(0, 1);
+            break;
+        }
+        const unsigned leading = min(countl_zero(x), 31);
+        const unsigned trailing = countr_zero(x);
+        if (column.window && leading >= column.leading && trailing >= column.trailing)
+        {
+            // the meaningful bits fit in the window of the previous value
+            out.write(0b10, 2);
+            out.write(x >> column.trailing, 64 - column.leading - column.trailing);
+        }
+        else
+        {
+            const unsigned meaningful = 64 - leading - trailing;
+            out.write(0b11, 2);
+            out.write(leading, 5);
+            out.write(meaningful - 1, 6);
+            out.write(x >> trailing, meaningful);
+            column.leading = leading;
+            column.trailing = trailing;
+            column.window = true;
+        }
+        break;
+    }
+    case type_bool:
+        out.write(get<bool>(value), 1);
+        break;
+    case type_string:
+    {
+        const string &s = get<string>(value);
+        if (column.present > 0 && s == column.previous_string)
+        {
+            out.writeVarint(0);
+            break;
+        }
+        out.writeVarint(s.size() + 1);
+        for (char c : s)
+            out.write(static_cast<uint8_t>(c), 8);
+        column.previous_string.assign(s);
+        break;
+    }
+    default:
+        // empty objects and arrays have no value
+        break;
+    }
+    column.present++;
+}
+
+string_view ColumnarWriter::finish()
+{
+    size_t size = magic.size() + 20;
+    size_t used_columns = 0;
+    for (const auto &column : columns)
+    {
+        if (column.present == 0)
+            continue;
+        size += column.path.size() + column.presence.bytes.size() + column.values.bytes.size() + 24;
+        used_columns++;
+    }
+
+    out.clear();
+    out.reserve(size);
+    out.append(magic);
+    appendVarint(out, samples);
+    appendVarint(out, used_columns);
+    for (size_t column_index : order)
+    {
+        const Column &column = columns[column_index];
+        if (column.present == 0)
+            continue;
+        appendVarint(out, column.path.size());
+        out.append(column.path);
+        out.push_back(static_cast<char>(column.type));
+        if (column.present == samples)
+        {
+            out.push_back(0);
+        }
+        else
+        {
+            out.push_back(1);
+            out.append(column.presence.bytes);
+        }
+        appendVarint(out, column.values.bytes.size());
+        out.append(column.values.bytes);
+    }
+    return out;
+}
+
+void ColumnarWriter::reset()
+{
+    // the paths missing from the whole batch, like those of an unmounted filesystem, go
+    bool unused = false;
+    for (const auto &column : columns)
+        unused |= column.present == 0;
+    if (unused)
+    {
+        vector<Column> kept;
+        vector<size_t> kept_order;
+        index.clear();
+        for (size_t column_index : order)
+        {
+            Column &column = columns[column_index];
+            if (column.present == 0)
+                continue;
+            column.position = kept_order.size();
+            kept_order.push_back(kept.size());
+            lookup.assign(column.path);
+            lookup.push_back(static_cast<char>(column.type));
+            index.emplace(lookup, kept.size());
+            kept.push_back(std::move(column));
+        }
+        columns = std::move(kept);
+        order = std::move(kept_order);
+    }
+
+    for (auto &column : columns)
+    {
+        column.presence.clear();
+        column.values.clear();
+        column.present = 0;
+        column.previous = 0;
+        column.previous_delta = 0;
+        column.window = false;
+    }
+    samples = 0;
+}
+
+namespace
+{
+    /**
+     * @struct DecodedColumn
+     * @brief A column read back, with a value per sample it is present in.
+     */
+    struct DecodedColumn
+    {
+        string_view path;
+        uint8_t type;
+        string_view presence; ///< Empty when present in every sample.
+        vector<FlatWriter::Value> values;
+        size_t next = 0;      ///< Index of the next value to write.
+
+        bool presentIn(size_t sample) const
+        {
+            return presence.empty() || (static_cast<uint8_t>(presence[sample / 8]) >> (7 - sample % 8)) & 1;
+        }
+    };
+
+    /**
+     * @brief Decodes @p count values of a column of @p type from @p in.
+     */
+    bool decodeValues(BitReader in, uint8_t type, size_t count, vector<FlatWriter::Value> &values)
+    {
+        uint64_t previous = 0;
+        int64_t previous_delta = 0;
+        unsigned leading = 0, trailing = 0;
+        string previous_string;
+
+        for (size_t i = 0; i < count && in.ok; i++)
+        {
+            switch (type)
+            {
+            case type_int:
+            case type_uint:
+                previous += static_cast<uint64_t>(unzigzag(in.readVarint()));
+                if (type == type_int)
+                    values.emplace_back(static_cast<int64_t>(previous));
+                else
+                    values.emplace_back(previous);
+                break;
+            case type_timestamp:
+            {
+                int64_t delta;
+                if (i < 2)
+                {
+                    delta = unzigzag(in.readVarint());
+                }
+                else
+                {
+                    uint64_t dod;
+                    if (in.read(1) == 0)
+                        dod = 0;
+                    else if (in.read(1) == 0)
+                        dod = in.read(7);
+                    else if (in.read(1) == 0)
+                        dod = in.read(9);
+                    else if (in.read(1) == 0)
+                        dod = in.read(12);
+                    else
+                        dod = in.read(64);
+                    delta = previous_delta + unzigzag(dod);
+                }
+                previous += static_cast<uint64_t>(delta);
+                previous_delta = i == 0 ? 0 : delta;
+                values.emplace_back(static_cast<int64_t>(previous));
+                break;
+            }
+            case type_double:
+                if (i == 0)
+                {
+                    previous = in.read(64);
+                }
+                else if (in.read(1) == 1)
+                {
+                    if (in.read(1) == 1)
+                    {
+                        leading = in.read(5);
+                        const unsigned meaningful = in.read(6) + 1;
+                        if (leading + meaningful > 64)
+                            return false;
+                        trailing = 64 - leading - meaningful;
+                    }
+                    previous ^= in.read(64 - leading - trailing) << trailing;
+                }
+                values.emplace_back(bit_cast<double>(previous));
+                break;
+            case type_bool:
+                values.emplace_back(in.read(1) == 1);
+                break;
+            case type_string:
+            {
+                const uint64_t size = in.readVarint();
+                if (size > 0)
+                {
+                    if (size - 1 > in.data.size())
+                        return false;
+                    previous_string.clear();
+                    for (uint64_t c = 1; c < size; c++)
+                        previous_string.push_back(static_cast<char>(in.read(8)));
+                }
+                else if (i == 0)
+                {
+                    return false;
+                }
+                values.emplace_back(previous_string);
+                break;
+            }
+            case type_empty_object:
+                values.emplace_back(FlatWriter::Empty::object);
+                break;
+            case type_empty_array:
+                values.emplace_back(FlatWriter::Empty::array);
+                break;
+            default:
+                return false;
+            }
+        }
+        return in.ok;
+    }
+}
+
+bool ob::columnarToJson(string_view columnar, JsonWriter &json)
+{
+    json.reset();
+    if (columnar.substr(0, magic.size()) != magic)
+        return false;
+
+    BitReader in{columnar.substr(magic.size())};
+    const uint64_t samples = in.readVarint();
+    const uint64_t column_count = in.readVarint();
+    // every sample has at least a bit in a column, every column at least a byte
+    if (!in.ok || samples > columnar.size() * 8 || column_count > columnar.size())
+        return false;
+
+    vector<DecodedColumn> columns(column_count);
+    for (auto &column : columns)
+    {
+        column.path = in.readBytes(in.readVarint());
+        column.type = static_cast<uint8_t>(in.read(8));
+        const uint64_t has_presence = in.read(8);
+        size_t present = samples;
+        if (has_presence)
+        {
+            column.presence = in.readBytes((samples + 7) / 8);
+            if (column.presence.size() != (samples + 7) / 8)
+                return false;
+            present = 0;
+            for (size_t sample = 0; sample < samples; sample++)
+                present += column.presentIn(sample);
+        }
+        const string_view values = in.readBytes(in.readVarint());
+        if (!in.ok || column.path.empty())
+            return false;
+        column.values.reserve(present);
+        if (!decodeValues(BitReader{values}, column.type, present, column.values))
+            return false;
+    }
+
+    json.beginArray();
+    for (size_t sample = 0; sample < samples; sample++)
+    {
+        json.beginObject();
+        DocumentBuilder builder(json);
+        for (auto &column : columns)
+        {
+            if (!column.presentIn(sample))
+                continue;
+            if (!builder.add(column.path, column.values[column.next++]))
+                return false;
+        }
+        builder.finish();
+        json.endObject();
+    }
+    json.endArray();
+    return true;
+}
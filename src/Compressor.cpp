@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <stdexcept>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#include "ReportDictionary.h"
+#endif
+
+#include "Compressor.hpp"
+
+using namespace std;
+using namespace ob;
+
+string_view ob::compressionName(Compression compression)
+{
+    switch (compression)
+    {
+    case Compression::gzip: return "gzip";
+    case Compression::zstd: return "zstd";
+    case Compression::zstd_dictionary: return "zstd";
+    default: return "";
+    }
+}
+
+optional<Compression> ob::parseCompression(string_view name)
+{
+    if (name == "none")
+        return Compression::none;
+    if (name == "gzip")
+        return Compression::gzip;
+    if (name == "zstd")
+        return Compression::zstd;
+    if (name == "zstd-dict")
+        return Compression::zstd_dictionary;
+    return {};
+}
+
+Compressor::Compressor(Compression algorithm, int level)
+    : compression(algorithm)
+{
+    switch (compression)
+    {
+    case Compression::gzip:
+        deflate_stream = new z_stream{};
+        // window bits + 16 selects the gzip wrapper rather than zlib's
+        if (deflateInit2(deflate_stream, level != 0 ? level : Z_DEFAULT_COMPRESSION, Z_DEFLATED,
+                         15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            delete deflate_stream;
+            throw runtime_error("Failed to initialize zlib");
+        }
+        break;
+    case Compression::zstd:
+    case Compression::zstd_dictionary:
+#ifdef HAVE_ZSTD
+        zstd_context = ZSTD_createCCtx();
+        if (!zstd_context)
+        {
+            throw runtime_error("Failed to initialize zstd");
+        }
+        if (compression == Compression::zstd_dictionary)
+        {
+            // digested once, so that each frame does not load the dictionary again
+            zstd_dictionary = ZSTD_createCDict(report_dictionary, sizeof(report_dictionary),
+                                               level != 0 ? level : ZSTD_CLEVEL_DEFAULT);
+            if (!zstd_dictionary)
+            {
+                ZSTD_freeCCtx(zstd_context);
+                throw runtime_error("Failed to load the zstd dictionary");
+            }
+            ZSTD_CCtx_refCDict(zstd_context, zstd_dictionary);
+            dictionary_id = ZSTD_getDictID_fromCDict(zstd_dictionary);
+        }
+        else
+        {
+            ZSTD_CCtx_setParameter(zstd_context, ZSTD_c_compressionLevel, level != 0 ? level : ZSTD_CLEVEL_DEFAULT);
+        }
+        break;
+#else
+        throw runtime_error("zstd compression requires a build with libzstd");
+#endif
+    default:
+        break;
+    }
+}
+
+Compressor::~Compressor()
+{
+    if (deflate_stream)
+    {
+        deflateEnd(deflate_stream);
+        delete deflate_stream;
+    }
+#ifdef HAVE_ZSTD
+    ZSTD_freeCCtx(zstd_context);
+    ZSTD_freeCDict(zstd_dictionary);
+#endif
+}
+
+bool Compressor::compress(string_view in, string &out)
+{
+    switch (compression)
+    {
+    case Compression::gzip:
+    {
+        deflateReset(deflate_stream);
+        out.resize(deflateBound(deflate_stream, in.size()));
+        deflate_stream->next_in = reinterpret_cast<Bytef *>(const_cast<char *>(in.data()));
+        deflate_stream->avail_in = in.size();
+        deflate_stream->next_out = reinterpret_cast<Bytef *>(out.data());
+        deflate_stream->avail_out = out.size();
+        if (deflate(deflate_stream, Z_FINISH) != Z_STREAM_END)
+            return false;
+        out.resize(deflate_stream->total_out);
+        return true;
+    }
+    case Compression::zstd:
+    case Compression::zstd_dictionary:
+    {
+#ifdef HAVE_ZSTD
+        out.resize(ZSTD_compressBound(in.size()));
+        const size_t size = ZSTD_compress2(zstd_context, out.data(), out.size(), in.data(), in.size());
+        if (ZSTD_isError(size))
+            return false;
+        out.resize(size);
+        return true;
+#else
+        return false;
+#endif
+    }
+    default:
+        out.assign(in);
+        return true;
+    }
+}
@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <time.h>
+
+#include "CpuCollector.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+ */
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Difference between two samples of a monotonic counter.
+ *
+ * Counters of a CPU that went offline and came back restart from zero; treat that as no progress.
+ */
+static inline uint64_t counterDelta(uint64_t current, uint64_t previous)
+{
+    return current >= previous ? current - previous : 0;
+}
+
+CpuCollector::CpuCollector()
+    : stat_file("/proc/stat")
+{
+    if (!stat_file.isOpen())
+    {
+        throw runtime_error("Failed to open /proc/stat");
+    }
+}
+
+/**
+ * @brief Computes the utilization of one counter row against the previous sample.
+ */
+void CpuCollector::computeUsage(size_t row, CpuUsage &usage) const
+{
+    const uint64_t *cur = &current[row * num_counters];
+    const uint64_t *prev = &previous[row * num_counters];
+
+    uint64_t delta[num_counters];
+    uint64_t total = 0;
+    for (size_t i = 0; i < num_counters; i++)
+    {
+        delta[i] = counterDelta(cur[i], prev[i]);
+        total += delta[i];
+    }
+
+    if (total == 0)
+    {
+        usage = {};
+        return;
+    }
+
+    const double scale = 100.0 / total;
+    usage.user = (delta[user] + delta[nice]) * scale;
+    usage.system = delta[system] * scale;
+    usage.iowait = delta[iowait] * scale;
+    usage.steal = delta[steal] * scale;
+    usage.irq = (delta[irq] + delta[softirq]) * scale;
+    usage.idle = delta[idle] * scale;
+}
+
+optional<CpuCollector::error> CpuCollector::collect(CpuStats &stats)
+{
+    static constexpr auto keys = procfs::makeKeySet("cpu", "ctxt", "procs_running");
+
+    const auto text = stat_file.read();
+    if (!text.has_value())
+    {
+        return error::read_failed;
+    }
+    const uint64_t now_ns = monotonicNs();
+
+    // CPUs missing from this sample (offline) keep their last counters: no time passes on them,
+    // so computeUsage() reports them as all zeroes, idle included
+    current.swap(previous);
+    copy(previous.begin(), previous.end(), current.begin());
+
+    bool seen_total = false;
+    uint64_t ctxt = 0;
+    procfs::Scanner scanner(text.value());
+    procfs::Line line;
+    while (scanner.next(line))
+    {
+        const auto key = line.token();
+        size_t row;
+        switch (keys.find(key))
+        {
+        case 0: // "cpu"
+            row = 0;
+            seen_total = true;
+            break;
+        case 1: // "ctxt"
+            ctxt = line.u64();
+            continue;
+        case 2: // "procs_running"
+            stats.procs_running = line.u64();
+            continue;
+        default:
+            if (key.size() > 3 && key.starts_with("cpu"))
+            {
+                uint64_t cpu;
+                if (procfs::parseU64(key.data() + 3, key.data() + key.size(), cpu) != key.data() + key.size())
+                    continue;
+                row = cpu + 1;
+                break;
+            }
+            continue;
+        }
+
+        if ((row + 1) * num_counters > current.size())
+        {
+            // a core came online (or this is the first sample); grow both rows together
+            current.resize((row + 1) * num_counters, 0);
+            previous.resize(current.size(), 0);
+        }
+        uint64_t *counters = &current[row * num_counters];
+        for (size_t i = 0; i < num_counters; i++)
+            counters[i] = line.u64();
+    }
+
+    if (!seen_total)
+    {
+        return error::parse_failed;
+    }
+
+    const size_t rows = current.size() / num_counters;
+    computeUsage(0, stats.total);
+    stats.cores.resize(rows - 1);
+    for (size_t row = 1; row < rows; row++)
+        computeUsage(row, stats.cores[row - 1]);
+
+    const uint64_t elapsed_ns = now_ns - previous_ns;
+    stats.context_switches = (previous_ns && elapsed_ns)
+                                 ? counterDelta(ctxt, previous_ctxt) * 1000000000ull / elapsed_ns
+                                 : 0;
+    previous_ctxt = ctxt;
+    previous_ns = now_ns;
+
+    return {};
+}
@@ -0,0 +1,284 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <charconv>
+#include <cmath>
+#include <random>
+#include <type_traits>
+
+#include "DeltaEncoder.hpp"
+
+using namespace std;
+using namespace ob;
+
+optional<Deadband> ob::parseDeadband(string_view spec)
+{
+    const size_t equals = spec.find('=');
+    if (equals == string_view::npos || equals == 0)
+        return {};
+
+    Deadband deadband{string(spec.substr(0, equals)), 0.0, false};
+    string_view threshold = spec.substr(equals + 1);
+    if (!threshold.empty() && threshold.back() == '%')
+    {
+        deadband.relative = true;
+        threshold.remove_suffix(1);
+    }
+    const auto result = from_chars(threshold.data(), threshold.data() + threshold.size(), deadband.threshold);
+    if (threshold.empty() || result.ec != errc() || result.ptr != threshold.data() + threshold.size() ||
+        !(deadband.threshold >= 0))
+        return {};
+    return deadband;
+}
+
+/**
+ * @brief Whether the trailing segments of @p path are those of @p field, `*` matching any segment.
+ */
+static bool matchesField(string_view field, string_view path)
+{
+    for (;;)
+    {
+        const size_t field_dot = field.rfind('.');
+        const size_t path_dot = path.rfind('.');
+        const string_view field_segment = field.substr(field_dot == string_view::npos ? 0 : field_dot + 1);
+        const string_view path_segment = path.substr(path_dot == string_view::npos ? 0 : path_dot + 1);
+        if (field_segment != "*" && field_segment != path_segment)
+            return false;
+        if (field_dot == string_view::npos)
+            return true;
+        if (path_dot == string_view::npos)
+            return false;
+        field = field.substr(0, field_dot);
+        path = path.substr(0, path_dot);
+    }
+}
+
+/**
+ * @brief Returns @p value as a double, or an empty optional if it is not a number.
+ */
+static optional<double> numericValue(const FlatWriter::Value &value)
+{
+    return visit([](const auto &v) -> optional<double>
+    {
+        using T = decay_t<decltype(v)>;
+        if constexpr (is_same_v<T, int64_t> || is_same_v<T, uint64_t> || is_same_v<T, double>)
+            return static_cast<double>(v);
+        else
+            return {};
+    }, value);
+}
+
+/**
+ * @brief Whether @p value differs from the value last sent enough to be sent.
+ */
+static bool hasChanged(const FlatWriter::Value &last_sent, const FlatWriter::Value &value, const Deadband *deadband)
+{
+    if (deadband && last_sent.index() == value.index())
+    {
+        const auto before = numericValue(last_sent);
+        const auto after = numericValue(value);
+        if (before && after)
+        {
+            const double limit = deadband->relative ? fabs(*before) * deadband->threshold / 100 : deadband->threshold;
+            return fabs(*after - *before) > limit;
+        }
+    }
+    return last_sent != value;
+}
+
+DeltaEncoder::DeltaEncoder(const DeltaConfig &config, bool pretty)
+    : config(config), stream(random_device{}()), json(pretty)
+{
+}
+
+const Deadband *DeltaEncoder::deadbandOf(string_view path) const
+{
+    for (auto it = config.deadbands.rbegin(); it != config.deadbands.rend(); ++it)
+    {
+        if (matchesField(it->field, path))
+            return &*it;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Compares @p report with what the receiver knows, and updates the latter.
+ *
+ * Fills `changes` with the entries to send and `removed` with the paths that are gone. For
+ * a keyframe, every entry is taken as sent.
+ */
+void DeltaEncoder::track(span<const FlatWriter::Entry> report, bool keyframe)
+{
+    changes.clear();
+    removed.clear();
+
+    for (const auto &entry : report)
+    {
+        auto it = sent.find(entry.path);
+        if (it == sent.end())
+        {
+            it = sent.emplace(entry.path, Sent{entry.value, deadbandOf(entry.path)}).first;
+            changes.push_back(&entry);
+        }
+        else if (keyframe || hasChanged(it->second.value, entry.value, it->second.deadband))
+        {
+            it->second.value = entry.value;
+            changes.push_back(&entry);
+        }
+        it->second.seen = sequence;
+    }
+
+    for (auto it = sent.begin(); it != sent.end();)
+    {
+        if (it->second.seen == sequence)
+        {
+            ++it;
+            continue;
+        }
+        auto node = sent.extract(it++);
+        removed.push_back(std::move(node.key()));
+    }
+}
+
+/**
+ * @brief Consumes the CBOR text string @p key at the start of @p in.
+ */
+static bool skipCborKey(string_view &in, string_view key)
+{
+    if (in.empty() || static_cast<unsigned char>(in[0]) != (0x60 | key.size()) || in.substr(1, key.size()) != key)
+        return false;
+    in.remove_prefix(1 + key.size());
+    return true;
+}
+
+/**
+ * @brief Consumes the CBOR unsigned integer at the start of @p in.
+ */
+static bool skipCborUint(string_view &in)
+{
+    if (in.empty() || static_cast<unsigned char>(in[0]) >> 5 != 0)
+        return false;
+    const unsigned info = static_cast<unsigned char>(in[0]) & 0x1f;
+    const size_t size = 1 + (info < 24 ? 0 : info <= 27 ? size_t{1} << (info - 24) : in.size());
+    if (size > in.size())
+        return false;
+    in.remove_prefix(size);
+    return true;
+}
+
+/**
+ * @brief Consumes the JSON key @p key, with the whitespace around it and its colon.
+ */
+static bool skipJsonKey(string_view &in, string_view key)
+{
+    const auto skipSpaces = [&] { in.remove_prefix(min(in.find_first_not_of(" \n"), in.size())); };
+    skipSpaces();
+    if (!in.starts_with('"') || in.substr(1, key.size()) != key || in.substr(1 + key.size(), 2) != "\":")
+        return false;
+    in.remove_prefix(key.size() + 3);
+    skipSpaces();
+    return true;
+}
+
+bool DeltaEncoder::isDelta(string_view payload)
+{
+    // the header comes first: stream, sequence, then "keyframe" or "set"
+    if (detectReportFormat(payload) == ReportFormat::cbor)
+    {
+        payload.remove_prefix(1);
+        return skipCborKey(payload, "stream") && skipCborUint(payload) && skipCborKey(payload, "sequence") &&
+               skipCborUint(payload) && skipCborKey(payload, "set");
+    }
+
+    if (!payload.starts_with('{'))
+        return false;
+    payload.remove_prefix(1);
+    if (!skipJsonKey(payload, "stream"))
+        return false;
+    payload.remove_prefix(min(payload.find(','), payload.size()));
+    payload.remove_prefix(min<size_t>(1, payload.size()));
+    if (!skipJsonKey(payload, "sequence"))
+        return false;
+    payload.remove_prefix(min(payload.find(','), payload.size()));
+    payload.remove_prefix(min<size_t>(1, payload.size()));
+    return skipJsonKey(payload, "set");
+}
+
+string_view DeltaEncoder::encode(SystemInfo &sysinfo, ReportFormat format, bool standalone)
+{
+    sysinfo.flatten(flat);
+    return encode(flat.entries(), format, standalone);
+}
+
+string_view DeltaEncoder::encode(span<const FlatWriter::Entry> report, ReportFormat format, bool standalone)
+{
+    const bool keyframe = keyframe_requested || standalone || since_keyframe + 1 >= config.keyframe_interval;
+    // what the receiver knows is only updated if the message is written entirely
+    keyframe_requested = true;
+
+    track(report, keyframe);
+
+    string_view message;
+    if (format == ReportFormat::cbor)
+    {
+        write(cbor, report, keyframe);
+        message = cbor.view();
+    }
+    else
+    {
+        write(json, report, keyframe);
+        message = json.view();
+    }
+    sequence++;
+    since_keyframe = keyframe ? 0 : since_keyframe + 1;
+    keyframe_requested = standalone;
+    return message;
+}
+
+/**
+ * @brief Writes the message of the report tracked last.
+ */
+template <typename Writer>
+void DeltaEncoder::write(Writer &writer, span<const FlatWriter::Entry> report, bool keyframe)
+{
+    writer.reset();
+    writer.beginObject();
+    writer.member("stream", stream);
+    writer.member("sequence", sequence);
+
+    if (keyframe)
+    {
+        writer.member("keyframe", true);
+        writer.key("report");
+        writer.beginObject();
+        // the paths of a FlatWriter are never nested too deep to be rebuilt
+        DocumentBuilder builder(writer);
+        for (const auto &entry : report)
+            builder.add(entry.path, entry.value);
+        builder.finish();
+        writer.endObject();
+        writer.endObject();
+        return;
+    }
+
+    writer.key("set");
+    writer.beginObject();
+    for (const auto *entry : changes)
+    {
+        writer.key(entry->path);
+        DocumentBuilder<Writer>::writeValue(writer, entry->value);
+    }
+    writer.endObject();
+
+    if (!removed.empty())
+    {
+        writer.key("remove");
+        writer.beginArray();
+        for (const auto &path : removed)
+            writer.value(string_view(path));
+        writer.endArray();
+    }
+    writer.endObject();
+}
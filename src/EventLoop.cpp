@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cerrno>
+#include <csignal>
+#include <stdexcept>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "EventLoop.hpp"
+
+using namespace std;
+using namespace ob;
+
+EventLoop::EventLoop()
+    : epoll_fd(epoll_create1(EPOLL_CLOEXEC))
+{
+    if (epoll_fd < 0)
+    {
+        throw runtime_error("Failed to create the epoll instance");
+    }
+}
+
+EventLoop::~EventLoop()
+{
+    if (signal_fd >= 0)
+        close(signal_fd);
+    close(epoll_fd);
+}
+
+bool EventLoop::add(int fd, uint32_t events, Handler handler)
+{
+    auto shared = make_shared<Handler>(std::move(handler));
+
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0)
+        return false;
+
+    handlers[fd] = std::move(shared);
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events)
+{
+    struct epoll_event ev = {};
+    ev.events = events;
+    ev.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &ev) == 0;
+}
+
+void EventLoop::remove(int fd)
+{
+    if (handlers.erase(fd) > 0)
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+}
+
+void EventLoop::handleSignals(initializer_list<int> signals, function<void(int)> handler)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signo : signals)
+        sigaddset(&mask, signo);
+
+    // blocked signals stay pending for the signalfd instead of interrupting the process
+    sigprocmask(SIG_BLOCK, &mask, nullptr);
+    signal_fd = signalfd(signal_fd, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signal_fd < 0)
+    {
+        throw runtime_error("Failed to create the signalfd");
+    }
+
+    const int fd = signal_fd;
+    add(fd, EPOLLIN, [fd, handler = std::move(handler)](uint32_t)
+    {
+        struct signalfd_siginfo info;
+        while (read(fd, &info, sizeof(info)) == sizeof(info))
+            handler(static_cast<int>(info.ssi_signo));
+    });
+}
+
+void EventLoop::poll(int timeout_ms)
+{
+    struct epoll_event events[16];
+    const int count = epoll_wait(epoll_fd, events, 16, timeout_ms);
+    for (int i = 0; i < count; i++)
+    {
+        // look the handler up for every event: an earlier one may have removed this descriptor
+        const auto it = handlers.find(events[i].data.fd);
+        if (it == handlers.end())
+            continue;
+        // held, as the handler may remove itself
+        const shared_ptr<Handler> handler = it->second;
+        (*handler)(events[i].events);
+    }
+}
+
+void EventLoop::run()
+{
+    stopped = false;
+    while (!stopped)
+        poll(-1);
+}
+
+Timer::Timer(EventLoop &loop, clockid_t clock, function<void()> handler)
+    : loop(loop), clock(clock), fd(timerfd_create(clock, TFD_NONBLOCK | TFD_CLOEXEC)),
+      handler(std::move(handler))
+{
+    if (fd < 0)
+    {
+        throw runtime_error("Failed to create a timerfd");
+    }
+    loop.add(fd, EPOLLIN, [this](uint32_t) { onReadable(); });
+}
+
+Timer::~Timer()
+{
+    loop.remove(fd);
+    close(fd);
+}
+
+/**
+ * @brief Converts nanoseconds to a timespec.
+ */
+static struct timespec toTimespec(uint64_t ns)
+{
+    return {static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+}
+
+void Timer::setAligned(uint64_t period_ns)
+{
+    aligned_period_ns = period_ns;
+
+    struct timespec now;
+    clock_gettime(clock, &now);
+    const uint64_t now_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+
+    struct itimerspec spec;
+    spec.it_value = toTimespec((now_ns / period_ns + 1) * period_ns);
+    spec.it_interval = toTimespec(period_ns);
+    int flags = TFD_TIMER_ABSTIME;
+    if (clock == CLOCK_REALTIME)
+        flags |= TFD_TIMER_CANCEL_ON_SET;
+    timerfd_settime(fd, flags, &spec, nullptr);
+}
+
+void Timer::setOnce(uint64_t delay_ns)
+{
+    aligned_period_ns = 0;
+
+    struct itimerspec spec = {};
+    // a zero it_value would disarm the timer
+    spec.it_value = toTimespec(delay_ns > 0 ? delay_ns : 1);
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+void Timer::cancel()
+{
+    aligned_period_ns = 0;
+
+    struct itimerspec spec = {};
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+void Timer::onReadable()
+{
+    uint64_t expirations;
+    if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+    {
+        handler();
+    }
+    else if (errno == ECANCELED && aligned_period_ns > 0)
+    {
+        // the wall clock was set: realign the schedule on the new time
+        setAligned(aligned_period_ns);
+    }
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <charconv>
+
+#include "FlatWriter.hpp"
+
+using namespace std;
+using namespace ob;
+
+void FlatWriter::reset()
+{
+    count = 0;
+    path.clear();
+    depth = 0;
+}
+
+/**
+ * @brief Appends the segment of the next value to the path: its key, or its index in an array.
+ */
+void FlatWriter::enter()
+{
+    if (depth == 0)
+        return;
+
+    Level &parent = levels[depth - 1];
+    if (depth > 1)
+        path.push_back('.');
+    if (parent.array)
+    {
+        char digits[24];
+        const auto result = to_chars(digits, digits + sizeof(digits), parent.index++);
+        path.append(digits, result.ptr);
+    }
+    else
+    {
+        path.append(pending_key);
+    }
+}
+
+/**
+ * @brief Removes the segment added by enter().
+ */
+void FlatWriter::leave()
+{
+    path.resize(depth > 0 ? levels[depth - 1].path_size : 0);
+}
+
+/**
+ * @brief Returns the next entry, at the current path, reusing the buffers of a previous document.
+ */
+FlatWriter::Entry &FlatWriter::record()
+{
+    if (count == entries_.size())
+        entries_.emplace_back();
+    Entry &entry = entries_[count++];
+    entry.path.assign(path);
+    return entry;
+}
+
+void FlatWriter::open(bool array)
+{
+    enter();
+    levels[depth++] = {path.size(), array, 0, count};
+}
+
+void FlatWriter::close()
+{
+    const Level &level = levels[depth - 1];
+    if (level.first_entry == count)
+        record().value = level.array ? Empty::array : Empty::object;
+    depth--;
+    leave();
+}
+
+void FlatWriter::valueString(string_view v)
+{
+    enter();
+    Entry &entry = record();
+    if (auto *s = get_if<string>(&entry.value))
+        s->assign(v);
+    else
+        entry.value.emplace<string>(v);
+    leave();
+}
+
+void FlatWriter::value(double v)
+{
+    enter();
+    record().value = v;
+    leave();
+}
+
+void FlatWriter::value(bool v)
+{
+    enter();
+    record().value = v;
+    leave();
+}
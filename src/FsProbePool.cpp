@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <thread>
+
+#include "FsProbePool.hpp"
+
+using namespace std;
+using namespace ob;
+
+namespace
+{
+    /** Timeouts a round waits at most, however many probes are queued. */
+    constexpr unsigned round_timeouts = 4;
+}
+
+FsProbePool::FsProbePool(unsigned threads, unsigned max_threads, ProbeFunction probe)
+    : shared(make_shared<Shared>()), max_threads(max(threads, max_threads))
+{
+    lock_guard<std::mutex> lock(shared->mutex);
+    shared->probe = probe;
+    shared->workers = threads;
+    for (unsigned i = 0; i < threads; i++)
+        spawnWorker(false);
+    spawnWorker(true);
+}
+
+FsProbePool::~FsProbePool()
+{
+    lock_guard<std::mutex> lock(shared->mutex);
+    shared->stopping = true;
+    shared->queue.clear();
+    shared->reserved_queue.clear();
+    shared->work_cv.notify_all();
+    shared->reserved_cv.notify_all();
+}
+
+/**
+ * @brief Starts a detached worker; must be called with the mutex held.
+ *
+ * Workers are detached because one blocked in statfs() on a hung mount cannot be joined.
+ */
+void FsProbePool::spawnWorker(bool reserved)
+{
+    if (!reserved)
+        shared->threads++;
+    thread(workerLoop, shared, reserved).detach();
+}
+
+void FsProbePool::workerLoop(shared_ptr<Shared> shared, bool reserved)
+{
+    auto &queue = reserved ? shared->reserved_queue : shared->queue;
+    auto &work_cv = reserved ? shared->reserved_cv : shared->work_cv;
+
+    unique_lock<std::mutex> lock(shared->mutex);
+    for (;;)
+    {
+        work_cv.wait(lock, [&] { return shared->stopping || !queue.empty(); });
+        if (shared->stopping)
+            break;
+
+        shared_ptr<FsProbe> probe = std::move(queue.front());
+        queue.pop_front();
+        probe->running = true;
+        probe->started = chrono::steady_clock::now();
+        // its deadline starts now
+        shared->done_cv.notify_all();
+        lock.unlock();
+
+        struct statfs result;
+        bool ok = shared->probe(probe->path.c_str(), &result) == 0;
+
+        lock.lock();
+        probe->running = false;
+        probe->in_flight = false;
+        probe->ok = ok;
+        if (ok)
+            probe->result = result;
+        probe->done_round = shared->round;
+        shared->done_cv.notify_all();
+
+        // a probe that was in flight for rounds is left out for as many
+        const uint64_t rounds = shared->round - probe->round;
+        if (rounds >= hung_rounds)
+            probe->held_until = shared->round + rounds;
+
+        if (probe->hung)
+        {
+            probe->hung = false;
+            shared->hung--;
+            // a replacement took over while this thread was stuck
+            if (shared->threads > shared->workers + shared->hung)
+            {
+                shared->threads--;
+                return;
+            }
+        }
+    }
+    if (!reserved)
+        shared->threads--;
+}
+
+void FsProbePool::beginRound()
+{
+    lock_guard<std::mutex> lock(shared->mutex);
+    shared->round++;
+    submitted.clear();
+}
+
+void FsProbePool::submit(const shared_ptr<FsProbe> &probe, bool reserved)
+{
+    lock_guard<std::mutex> lock(shared->mutex);
+    submitted.push_back(probe);
+    if (probe->in_flight || shared->round < probe->held_until)
+        return;
+
+    probe->in_flight = true;
+    probe->reserved = reserved;
+    probe->round = shared->round;
+    if (reserved)
+    {
+        shared->reserved_queue.push_back(probe);
+        shared->reserved_cv.notify_one();
+    }
+    else
+    {
+        shared->queue.push_back(probe);
+        shared->work_cv.notify_one();
+    }
+}
+
+void FsProbePool::wait(unsigned timeout_ms)
+{
+    unique_lock<std::mutex> lock(shared->mutex);
+    const auto timeout = chrono::milliseconds(timeout_ms);
+    const auto round_deadline = chrono::steady_clock::now() + timeout * round_timeouts;
+
+    for (;;)
+    {
+        const auto now = chrono::steady_clock::now();
+        auto wake = round_deadline;
+        bool pending = false;
+        for (const auto &probe : submitted)
+        {
+            const auto deadline = probe->started + timeout;
+            // a worker past its deadline while probes are queued is replaced, so that hung
+            // mounts cannot starve the others
+            if (probe->running && !probe->hung && !probe->reserved && deadline <= now && !shared->queue.empty())
+            {
+                probe->hung = true;
+                shared->hung++;
+                if (shared->threads < max_threads)
+                    spawnWorker(false);
+            }
+
+            // probes left over from an earlier round are waited for too, if they can still return in time
+            if (!probe->in_flight)
+                continue;
+            if (!probe->running)
+            {
+                pending = true;
+                continue;
+            }
+            if (deadline > now)
+            {
+                pending = true;
+                wake = min(wake, deadline);
+            }
+        }
+        if (!pending || now >= round_deadline)
+            break;
+        shared->done_cv.wait_until(lock, wake);
+    }
+}
+
+FsProbe::status FsProbePool::result(const FsProbe &probe, struct statfs &out)
+{
+    lock_guard<std::mutex> lock(shared->mutex);
+    out = probe.result;
+    if (probe.in_flight || probe.done_round != shared->round)
+        return FsProbe::status::stale;
+    if (!probe.ok)
+        return FsProbe::status::failed;
+    return FsProbe::status::ok;
+}
@@ -5,12 +5,16 @@
  */
 
 #include <cstring>
+#include <new>
 #include <stdexcept>
 #include <cerrno>
 #include <curl/curl.h>
 #include <unistd.h>
 #include <optional>
+#include <sys/epoll.h>
+#include <time.h>
 
+#include "log_utils.h"
 #include "HTTPClient.hpp"
 
 using namespace std;
@@ -27,24 +31,77 @@ static size_t curl_write_cb(void *ptr, size_t size, size_t nmemb, void *data)
 
 /**
  * @brief Constructs a HTTPClient object with the specified server URL.
+ * @param loop The loop driving the transfers.
  * @param url The server URL to send data to.
- * @throws std::runtime_error if cURL initialization fails.
+ * @param max_in_flight Number of requests that may run concurrently.
+ * @param on_complete Called with the outcome of every report.
+ * @param retry How failed uploads are retried.
+ * @param compression How request bodies are compressed.
+ * @throws std::runtime_error if cURL or compressor initialization fails.
  */
-HTTPClient::HTTPClient(const string &url)
-    : server_url(url), curl_session(curl_easy_init()), headers(nullptr)
+HTTPClient::HTTPClient(EventLoop &loop, const string &url, size_t max_in_flight, CompletionHandler on_complete,
+                       const RetryConfig &retry, const CompressionConfig &compression)
+    : loop(loop), timeout(make_unique<Timer>(loop, CLOCK_MONOTONIC, [this] { socketAction(CURL_SOCKET_TIMEOUT, 0); })),
+      resume(make_unique<Timer>(loop, CLOCK_MONOTONIC, [this] { dispatch(); })),
+      server_url(url), multi(curl_multi_init()),
+      transfers(max_in_flight > 0 ? max_in_flight : 1), on_complete(std::move(on_complete)),
+      retry(retry), compression_min_size(compression.min_size),
+      queue(retry.max_queued > 0 ? retry.max_queued : 1), jitter(random_device{}())
 {
-    if (!curl_session)
+    if (!multi)
     {
         throw runtime_error("Failed to initialize CURL");
     }
+    if (compression.algorithm != Compression::none)
+    {
+        try
+        {
+            compressor.emplace(compression.algorithm, compression.level);
+        }
+        catch (const runtime_error &)
+        {
+            cleanup();
+            throw;
+        }
+    }
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, static_cast<long>(transfers.size()));
+    curl_multi_setopt(multi, CURLMOPT_SOCKETFUNCTION, onSocket);
+    curl_multi_setopt(multi, CURLMOPT_SOCKETDATA, this);
+    curl_multi_setopt(multi, CURLMOPT_TIMERFUNCTION, onTimer);
+    curl_multi_setopt(multi, CURLMOPT_TIMERDATA, this);
+
     user_agent = "libcurl/" + string(curl_version_info(CURLVERSION_NOW)->version);
-    curl_easy_setopt(curl_session, CURLOPT_USERAGENT, user_agent.c_str());
-    curl_easy_setopt(curl_session, CURLOPT_WRITEFUNCTION, curl_write_cb);
-    curl_easy_setopt(curl_session, CURLOPT_URL, server_url.c_str());
-    curl_easy_setopt(curl_session, CURLOPT_TIMEOUT_MS, 5000);
-    headers = curl_slist_append(headers, "Expect:");
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-    curl_easy_setopt(curl_session, CURLOPT_HTTPHEADER, headers);
+    for (auto format : {ReportFormat::json, ReportFormat::cbor, ReportFormat::columnar})
+    {
+        for (bool compressed : {false, true})
+        {
+            if (compressed && !compressor)
+                continue;
+            struct curl_slist *&list = headers[static_cast<int>(format)][compressed];
+            list = curl_slist_append(list, "Expect:");
+            list = curl_slist_append(list, ("Content-Type: " + string(contentType(format))).c_str());
+            if (!compressed)
+                continue;
+            list = curl_slist_append(list, ("Content-Encoding: " + string(compressionName(compressor->algorithm()))).c_str());
+            if (compressor->dictionaryId() != 0)
+                list = curl_slist_append(list, ("X-Zstd-Dictionary-ID: " + to_string(compressor->dictionaryId())).c_str());
+        }
+    }
+
+    for (auto &transfer : transfers)
+    {
+        transfer.easy = curl_easy_init();
+        if (!transfer.easy)
+        {
+            cleanup();
+            throw runtime_error("Failed to initialize CURL");
+        }
+        curl_easy_setopt(transfer.easy, CURLOPT_USERAGENT, user_agent.c_str());
+        curl_easy_setopt(transfer.easy, CURLOPT_WRITEFUNCTION, curl_write_cb);
+        curl_easy_setopt(transfer.easy, CURLOPT_URL, server_url.c_str());
+        curl_easy_setopt(transfer.easy, CURLOPT_TIMEOUT_MS, 5000);
+        curl_easy_setopt(transfer.easy, CURLOPT_PRIVATE, &transfer);
+    }
 }
 
 /**
@@ -52,34 +109,355 @@ HTTPClient::HTTPClient(const string &url)
  */
 HTTPClient::~HTTPClient()
 {
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl_session);
+    cleanup();
+}
+
+void HTTPClient::cleanup()
+{
+    for (auto &transfer : transfers)
+    {
+        if (!transfer.easy)
+            continue;
+        if (transfer.busy)
+            curl_multi_remove_handle(multi, transfer.easy);
+        curl_easy_cleanup(transfer.easy);
+        transfer.easy = nullptr;
+    }
+    for (auto &lists : headers)
+    {
+        for (auto &list : lists)
+        {
+            curl_slist_free_all(list);
+            list = nullptr;
+        }
+    }
+    if (multi)
+        curl_multi_cleanup(multi);
+    multi = nullptr;
 }
 
 /**
- * @brief Sends a POST request with the specified payload to the server.
- *
+ * @brief Reads CLOCK_MONOTONIC in milliseconds.
+ */
+static uint64_t monotonic_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Queues a POST request with the specified payload, and starts it if possible.
  *
- * @param payload The JSON string to send.
- * @return std::optional<http_client_error> An optional error code; empty if successful.
+ * @param payload The report to send.
+ * @param format  Encoding of @p payload, sent as its Content-Type.
  */
-optional<HTTPClient::error> HTTPClient::post(const string &payload)
+void HTTPClient::post(string_view payload, ReportFormat format)
+{
+    if (queue_count == queue.size())
+    {
+        if (on_complete)
+            on_complete(error::dropped, queue[queue_head].payload);
+        queue_head = (queue_head + 1) % queue.size();
+        queue_count--;
+    }
+    QueuedReport &entry = queue[(queue_head + queue_count) % queue.size()];
+    try
+    {
+        // assign() reuses the slot's buffer once it has grown to the size of a report
+        entry.payload.assign(payload);
+    }
+    catch (const bad_alloc &)
+    {
+        // in arena mode; the slot keeps its old buffer, and the report is handled like an evicted one
+        OD_LOG_WARNING("Memory limit reached, a %zu byte report could not be queued.", payload.size());
+        if (on_complete)
+            on_complete(error::dropped, payload);
+        return;
+    }
+    entry.format = format;
+    queue_count++;
+
+    dispatch();
+}
+
+void HTTPClient::abandon()
 {
-    curl_easy_setopt(curl_session, CURLOPT_POSTFIELDS, payload.c_str());
-    curl_easy_setopt(curl_session, CURLOPT_POSTFIELDSIZE, payload.size());
+    for (auto &transfer : transfers)
+    {
+        if (!transfer.busy)
+            continue;
+        curl_multi_remove_handle(multi, transfer.easy);
+        transfer.busy = false;
+        in_flight--;
+        if (on_complete)
+            on_complete(error::dropped, transfer.payload);
+    }
+    for (; queue_count > 0; queue_count--)
+    {
+        if (on_complete)
+            on_complete(error::dropped, queue[queue_head].payload);
+        queue_head = (queue_head + 1) % queue.size();
+    }
+}
 
-    CURLcode res = curl_easy_perform(curl_session);
-    if (res != CURLE_OK)
+bool HTTPClient::backingOff() const
+{
+    return circuit != Circuit::closed || monotonic_ms() < paused_until_ms;
+}
+
+/**
+ * @brief Starts uploads from the head of the queue while the circuit and the free slots allow.
+ */
+void HTTPClient::dispatch()
+{
+    if (monotonic_ms() < paused_until_ms)
     {
-        return error::request_failed;
+        // the resume timer calls back once the pause is over
+        return;
     }
 
-    long response_code;
-    curl_easy_getinfo(curl_session, CURLINFO_RESPONSE_CODE, &response_code);
-    if (response_code != 201)
+    while (queue_count > 0)
     {
-        return error::unexpected_http_response_code;
+        if (circuit == Circuit::open)
+        {
+            OD_LOG_INFO("Probing the server after %u failed uploads.", failures);
+            circuit = Circuit::half_open;
+        }
+        if (circuit == Circuit::half_open && in_flight > 0)
+        {
+            // wait for the probe, or for the uploads started before the circuit opened
+            return;
+        }
+
+        Transfer *transfer = nullptr;
+        for (auto &candidate : transfers)
+        {
+            if (!candidate.busy)
+            {
+                transfer = &candidate;
+                break;
+            }
+        }
+        if (!transfer)
+        {
+            return;
+        }
+
+        // the buffers are swapped rather than copied, so they all keep circulating
+        transfer->payload.swap(queue[queue_head].payload);
+        transfer->format = queue[queue_head].format;
+        queue_head = (queue_head + 1) % queue.size();
+        queue_count--;
+
+        string_view body = transfer->payload;
+        bool compressed = false;
+        try
+        {
+            if (compressor && body.size() >= compression_min_size && compressor->compress(body, transfer->compressed))
+            {
+                OD_LOG_DBG("Compressed a %zu byte report to %zu bytes.", body.size(), transfer->compressed.size());
+                body = transfer->compressed;
+                compressed = true;
+            }
+        }
+        catch (const bad_alloc &)
+        {
+            // in arena mode; the report is sent as it is
+            OD_LOG_WARNING("Memory limit reached, sending a %zu byte report uncompressed.", body.size());
+        }
+
+        // CURLOPT_POSTFIELDS only stores the pointer, CURLOPT_COPYPOSTFIELDS would duplicate the payload
+        curl_easy_setopt(transfer->easy, CURLOPT_POSTFIELDS, body.data());
+        curl_easy_setopt(transfer->easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+        curl_easy_setopt(transfer->easy, CURLOPT_HTTPHEADER, headers[static_cast<int>(transfer->format)][compressed]);
+
+        if (curl_multi_add_handle(multi, transfer->easy) != CURLM_OK)
+        {
+            if (on_complete)
+                on_complete(error::request_failed, transfer->payload);
+            continue;
+        }
+        transfer->busy = true;
+        in_flight++;
+        // curl requests an immediate timeout through onTimer(), which starts the transfer from the loop
+    }
+}
+
+/**
+ * @brief Puts the payload of a failed upload back at the head of the queue.
+ */
+void HTTPClient::requeue(Transfer &transfer)
+{
+    if (queue_count == queue.size())
+    {
+        // newer reports filled the queue in the meantime, this one is the oldest
+        if (on_complete)
+            on_complete(error::dropped, transfer.payload);
+        return;
+    }
+    queue_head = (queue_head + queue.size() - 1) % queue.size();
+    queue[queue_head].payload.swap(transfer.payload);
+    queue[queue_head].format = transfer.format;
+    queue_count++;
+}
+
+/**
+ * @brief Records a failed upload and pauses the uploads accordingly.
+ * @param retry_after_s Delay requested by the server's Retry-After header, 0 if none.
+ */
+void HTTPClient::failed(long retry_after_s)
+{
+    failures++;
+
+    // full jitter: anywhere between 0 and the exponential ceiling
+    const unsigned shift = failures - 1 < 16 ? failures - 1 : 16;
+    const uint64_t ceiling_ms = min<uint64_t>(static_cast<uint64_t>(retry.base_delay_ms) << shift, retry.max_delay_ms);
+    uint64_t delay_ms = uniform_int_distribution<uint64_t>(0, ceiling_ms)(jitter);
+    if (retry_after_s > 0)
+        delay_ms = max<uint64_t>(delay_ms, static_cast<uint64_t>(retry_after_s) * 1000);
+
+    const uint64_t until_ms = monotonic_ms() + delay_ms;
+    if (until_ms > paused_until_ms)
+    {
+        paused_until_ms = until_ms;
+        resume->setOnce(delay_ms * 1000000);
+    }
+
+    if (circuit == Circuit::half_open || failures >= retry.failure_threshold)
+    {
+        if (circuit != Circuit::open)
+            OD_LOG_WARNING("Upload failed %u times in a row, pausing uploads for %llu ms.",
+                           failures, static_cast<unsigned long long>(paused_until_ms - monotonic_ms()));
+        circuit = Circuit::open;
+    }
+    else
+    {
+        OD_LOG_WARNING("Upload failed, retrying in %llu ms.",
+                       static_cast<unsigned long long>(paused_until_ms - monotonic_ms()));
+    }
+}
+
+/**
+ * @brief CURLMOPT_SOCKETFUNCTION: mirrors the sockets curl wants watched into the EventLoop.
+ */
+int HTTPClient::onSocket(CURL *, curl_socket_t fd, int what, void *client, void *socket)
+{
+    HTTPClient *self = static_cast<HTTPClient *>(client);
+    if (what == CURL_POLL_REMOVE)
+    {
+        self->loop.remove(fd);
+        curl_multi_assign(self->multi, fd, nullptr);
+        return 0;
+    }
+
+    uint32_t events = 0;
+    if (what & CURL_POLL_IN)
+        events |= EPOLLIN;
+    if (what & CURL_POLL_OUT)
+        events |= EPOLLOUT;
+
+    // socketp tells whether the socket is already registered
+    if (socket)
+    {
+        self->loop.modify(fd, events);
+    }
+    else
+    {
+        self->loop.add(fd, events, [self, fd](uint32_t revents)
+        {
+            int flags = 0;
+            if (revents & EPOLLIN)
+                flags |= CURL_CSELECT_IN;
+            if (revents & EPOLLOUT)
+                flags |= CURL_CSELECT_OUT;
+            if (revents & (EPOLLERR | EPOLLHUP))
+                flags |= CURL_CSELECT_ERR;
+            self->socketAction(fd, flags);
+        });
+        curl_multi_assign(self->multi, fd, self);
+    }
+    return 0;
+}
+
+/**
+ * @brief CURLMOPT_TIMERFUNCTION: arms the timer running curl's next timeout.
+ *
+ * curl must not be called back from here, so even a zero timeout goes through the loop.
+ */
+int HTTPClient::onTimer(CURLM *, long timeout_ms, void *client)
+{
+    HTTPClient *self = static_cast<HTTPClient *>(client);
+    if (timeout_ms < 0)
+        self->timeout->cancel();
+    else
+        self->timeout->setOnce(static_cast<uint64_t>(timeout_ms) * 1000000);
+    return 0;
+}
+
+void HTTPClient::socketAction(int fd, int flags)
+{
+    int running;
+    curl_multi_socket_action(multi, fd, flags, &running);
+    readCompletions();
+}
+
+void HTTPClient::readCompletions()
+{
+    int pending;
+    while (CURLMsg *msg = curl_multi_info_read(multi, &pending))
+    {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+
+        Transfer *transfer;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, &transfer);
+
+        // msg is invalidated by curl_multi_remove_handle()
+        const CURLcode result = msg->data.result;
+        long response_code = 0;
+        curl_easy_getinfo(transfer->easy, CURLINFO_RESPONSE_CODE, &response_code);
+        curl_off_t retry_after_s = 0;
+        curl_easy_getinfo(transfer->easy, CURLINFO_RETRY_AFTER, &retry_after_s);
+
+        curl_multi_remove_handle(multi, transfer->easy);
+        transfer->busy = false;
+        in_flight--;
+
+        if (result == CURLE_OK && response_code == 201)
+        {
+            if (circuit != Circuit::closed)
+                OD_LOG_INFO("Server reachable again, resuming uploads.");
+            circuit = Circuit::closed;
+            failures = 0;
+            paused_until_ms = 0;
+            if (on_complete)
+                on_complete({}, transfer->payload);
+        }
+        else if (result != CURLE_OK || response_code == 408 || response_code == 429 ||
+                 response_code >= 500)
+        {
+            // the server is unreachable or overloaded: try again later
+            failed(static_cast<long>(retry_after_s));
+            requeue(*transfer);
+        }
+        else if (response_code == 415)
+        {
+            if (on_complete)
+                on_complete(error::unsupported_media_type, transfer->payload);
+        }
+        else if (response_code == 409)
+        {
+            if (on_complete)
+                on_complete(error::conflict, transfer->payload);
+        }
+        else
+        {
+            // the server rejected the report itself, sending it again would not help
+            if (on_complete)
+                on_complete(error::unexpected_http_response_code, transfer->payload);
+        }
     }
 
-    return {};
+    dispatch();
 }
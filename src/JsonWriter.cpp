@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <charconv>
+#include <cmath>
+
+#include "JsonWriter.hpp"
+
+using namespace std;
+using namespace ob;
+
+void JsonWriter::reset()
+{
+    buf.clear();
+    depth = 0;
+}
+
+void JsonWriter::indent(size_t level)
+{
+    if (pretty)
+        buf.append(level * 2, ' ');
+}
+
+/**
+ * @brief Emits the separator and indentation that precede a value.
+ *
+ * Inside an object this was already done by key().
+ */
+void JsonWriter::beforeValue()
+{
+    if (depth == 0 || !in_array[depth - 1])
+        return;
+
+    if (has_children[depth - 1])
+    {
+        buf.push_back(',');
+        if (pretty)
+            buf.push_back('\n');
+    }
+    has_children[depth - 1] = true;
+    indent(depth);
+}
+
+void JsonWriter::open(char c, bool array)
+{
+    beforeValue();
+    buf.push_back(c);
+    if (pretty)
+        buf.push_back('\n');
+    in_array[depth] = array;
+    has_children[depth] = false;
+    depth++;
+}
+
+void JsonWriter::close(char c)
+{
+    depth--;
+    if (pretty)
+    {
+        if (has_children[depth])
+            buf.push_back('\n');
+        indent(depth);
+    }
+    buf.push_back(c);
+}
+
+void JsonWriter::key(string_view k)
+{
+    if (has_children[depth - 1])
+    {
+        buf.push_back(',');
+        if (pretty)
+            buf.push_back('\n');
+    }
+    has_children[depth - 1] = true;
+    indent(depth);
+    buf.push_back('"');
+    appendEscaped(k);
+    buf.append("\":");
+}
+
+/**
+ * @brief Appends @p s with json-c's escaping rules.
+ */
+void JsonWriter::appendEscaped(string_view s)
+{
+    static const char hex[] = "0123456789abcdef";
+
+    size_t start = 0;
+    for (size_t i = 0; i < s.size(); i++)
+    {
+        const unsigned char c = s[i];
+        const char *escape = nullptr;
+        switch (c)
+        {
+        case '\b': escape = "\\b"; break;
+        case '\n': escape = "\\n"; break;
+        case '\r': escape = "\\r"; break;
+        case '\t': escape = "\\t"; break;
+        case '\f': escape = "\\f"; break;
+        case '"': escape = "\\\""; break;
+        case '\\': escape = "\\\\"; break;
+        case '/': escape = "\\/"; break;
+        default:
+            if (c >= ' ')
+                continue;
+            break;
+        }
+
+        buf.append(s.data() + start, i - start);
+        start = i + 1;
+        if (escape)
+        {
+            buf.append(escape);
+        }
+        else
+        {
+            const char unicode[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+            buf.append(unicode, sizeof(unicode));
+        }
+    }
+    buf.append(s.data() + start, s.size() - start);
+}
+
+void JsonWriter::value(string_view v)
+{
+    beforeValue();
+    buf.push_back('"');
+    appendEscaped(v);
+    buf.push_back('"');
+}
+
+void JsonWriter::valueInt(int64_t v)
+{
+    beforeValue();
+    char tmp[24];
+    auto res = to_chars(tmp, tmp + sizeof(tmp), v);
+    buf.append(tmp, res.ptr);
+}
+
+void JsonWriter::valueUint(uint64_t v)
+{
+    beforeValue();
+    char tmp[24];
+    auto res = to_chars(tmp, tmp + sizeof(tmp), v);
+    buf.append(tmp, res.ptr);
+}
+
+void JsonWriter::value(double v)
+{
+    beforeValue();
+    if (isnan(v))
+    {
+        buf.append("NaN");
+        return;
+    }
+    if (isinf(v))
+    {
+        buf.append(v > 0 ? "Infinity" : "-Infinity");
+        return;
+    }
+
+    // same as json-c: "%.17g", made to look like a double if it printed as an integer
+    char tmp[32];
+    auto res = to_chars(tmp, tmp + sizeof(tmp), v, chars_format::general, 17);
+    string_view printed(tmp, res.ptr - tmp);
+    buf.append(printed);
+    if (printed.find_first_of(".e") == string_view::npos)
+        buf.append(".0");
+}
+
+void JsonWriter::value(bool v)
+{
+    beforeValue();
+    buf.append(v ? "true" : "false");
+}
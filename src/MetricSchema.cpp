@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <charconv>
+#include <cmath>
+
+#include "MetricSchema.hpp"
+
+using namespace std;
+using namespace ob;
+
+void ob::detail::appendPrometheusValue(string &out, double value)
+{
+    if (isnan(value))
+    {
+        out.append("NaN");
+        return;
+    }
+    if (isinf(value))
+    {
+        out.append(value > 0 ? "+Inf" : "-Inf");
+        return;
+    }
+
+    char tmp[32];
+    auto res = to_chars(tmp, tmp + sizeof(tmp), value);
+    out.append(tmp, res.ptr);
+}
+
+void ob::detail::appendPrometheusValue(string &out, int64_t value)
+{
+    char tmp[24];
+    auto res = to_chars(tmp, tmp + sizeof(tmp), value);
+    out.append(tmp, res.ptr);
+}
+
+void ob::detail::appendPrometheusValue(string &out, uint64_t value)
+{
+    char tmp[24];
+    auto res = to_chars(tmp, tmp + sizeof(tmp), value);
+    out.append(tmp, res.ptr);
+}
+
+/**
+ * @brief Appends `name="value"`, escaping the value as the exposition format requires.
+ */
+void ob::detail::appendPrometheusLabel(string &out, string_view name, string_view value)
+{
+    out.append(name).append("=\"");
+    for (char c : value)
+    {
+        switch (c)
+        {
+        case '\\': out.append("\\\\"); break;
+        case '"': out.append("\\\""); break;
+        case '\n': out.append("\\n"); break;
+        default: out.push_back(c); break;
+        }
+    }
+    out.push_back('"');
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <poll.h>
+#include <stdexcept>
+#include <sys/statfs.h>
+
+#include "MountCollector.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * @brief Decodes the octal escapes (`\040` for a space, ...) used by mountinfo fields.
+ */
+static void unescapeMountinfo(string_view field, string &out)
+{
+    out.clear();
+    for (size_t i = 0; i < field.size(); i++)
+    {
+        if (field[i] == '\\' && i + 3 < field.size() && field[i + 1] >= '0' && field[i + 1] <= '3')
+        {
+            out.push_back(static_cast<char>((field[i + 1] - '0') << 6 | (field[i + 2] - '0') << 3 | (field[i + 3] - '0')));
+            i += 3;
+        }
+        else
+        {
+            out.push_back(field[i]);
+        }
+    }
+}
+
+bool MountFilter::accepts(string_view fstype, string_view mount_point) const
+{
+    if (find(exclude_fstypes.begin(), exclude_fstypes.end(), fstype) != exclude_fstypes.end())
+        return false;
+
+    for (const auto &path : exclude_paths)
+    {
+        if (mount_point.starts_with(path) &&
+            (mount_point.size() == path.size() || path.ends_with('/') || mount_point[path.size()] == '/'))
+            return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Converts a statfs() result to KiB sizes, just like `df`.
+ */
+static void fillDiskStats(const struct statfs &s, DiskStats &disk)
+{
+    long block_size = s.f_frsize;
+    disk.total = s.f_blocks * block_size / 1024;
+    disk.free = s.f_bfree * block_size / 1024;
+    disk.available = s.f_bavail * block_size / 1024;
+    disk.used = disk.total - disk.free;
+    disk.cached = 0;
+    disk.usage_percentage = disk.total ? (disk.used * 100.0) / disk.total : 0;
+}
+
+/**
+ * @brief Fills the capacity and inode fields of @p mount from a statfs() result.
+ */
+static void fillMountStats(const struct statfs &s, MountStats &mount)
+{
+    fillDiskStats(s, mount.disk);
+
+    // filesystems without a fixed inode table (btrfs, ...) report zero inodes
+    mount.inodes_total = s.f_files;
+    mount.inodes_free = s.f_ffree;
+    mount.inodes_used = s.f_files - s.f_ffree;
+    mount.inodes_usage_percentage = s.f_files ? (mount.inodes_used * 100.0) / s.f_files : 0;
+}
+
+MountCollector::MountCollector(const MountFilter &filter, unsigned timeout_ms, const char *mountinfo_path)
+    : filter(filter), mountinfo_file(mountinfo_path), timeout_ms(timeout_ms),
+      pool(2, 16), root_probe(make_shared<FsProbe>(FsProbe{.path = "/"}))
+{
+    if (!mountinfo_file.isOpen())
+    {
+        throw runtime_error(string("Failed to open ") + mountinfo_path);
+    }
+}
+
+/**
+ * @brief Re-reads /proc/self/mountinfo and rebuilds the list of reported mounts.
+ *
+ * Line format, see proc(5):
+ * `36 35 98:0 /mnt1 /mnt2 rw,noatime master:1 - ext3 /dev/root rw,errors=continue`
+ */
+optional<MountCollector::error> MountCollector::parseMountinfo(vector<MountStats> &mounts)
+{
+    const auto text = mountinfo_file.read();
+    if (!text.has_value())
+    {
+        return error::read_failed;
+    }
+
+    size_t count = 0;
+    procfs::Scanner scanner(text.value());
+    procfs::Line line;
+    while (scanner.next(line))
+    {
+        line.skip(4); // mount ID, parent ID, major:minor, root
+        const auto mount_point = line.token();
+        line.skip(1); // mount options
+        // optional fields, terminated by a single hyphen
+        for (auto field = line.token(); !field.empty() && field != "-"; field = line.token())
+            ;
+        const auto fstype = line.token();
+        const auto device = line.token();
+        if (mount_point.empty() || fstype.empty())
+            continue;
+        if (!filter.accepts(fstype, mount_point))
+            continue;
+
+        if (count == mounts.size())
+            mounts.emplace_back();
+        MountStats &mount = mounts[count++];
+        unescapeMountinfo(mount_point, mount.mount_point);
+        mount.fstype.assign(fstype);
+        unescapeMountinfo(device, mount.device);
+    }
+    mounts.resize(count);
+
+    // report mounts sorted by path; when a path is mounted over, only the last (visible) mount is kept
+    auto by_path = [](const MountStats &a, const MountStats &b) { return a.mount_point < b.mount_point; };
+    stable_sort(mounts.begin(), mounts.end(), by_path);
+    auto out = mounts.begin();
+    for (auto it = mounts.begin(); it != mounts.end(); ++it)
+    {
+        if (next(it) != mounts.end() && next(it)->mount_point == it->mount_point)
+            continue;
+        if (out != it)
+            swap(*out, *it);
+        ++out;
+    }
+    mounts.erase(out, mounts.end());
+
+    // keep the probes of mounts that are still there, so hung ones are not submitted again
+    vector<shared_ptr<FsProbe>> old_probes;
+    old_probes.swap(probes);
+    auto old = old_probes.begin();
+    for (const auto &mount : mounts)
+    {
+        while (old != old_probes.end() && (*old)->path < mount.mount_point)
+            ++old;
+        if (old != old_probes.end() && (*old)->path == mount.mount_point)
+        {
+            probes.push_back(std::move(*old));
+            continue;
+        }
+        probes.push_back(make_shared<FsProbe>());
+        probes.back()->path = mount.mount_point;
+    }
+
+    return {};
+}
+
+optional<MountCollector::error> MountCollector::collect(vector<MountStats> &mounts, DiskStats &root)
+{
+    optional<error> result;
+    struct pollfd pfd = {mountinfo_file.descriptor(), POLLPRI, 0};
+    if (!parsed || (poll(&pfd, 1, 0) > 0 && (pfd.revents & (POLLPRI | POLLERR))))
+    {
+        // a failed read leaves the table as it was, so the last mounts read are still probed
+        result = parseMountinfo(mounts);
+        parsed = !result.has_value();
+    }
+
+    pool.beginRound();
+    // "/" has a worker of its own, so the root disk never waits behind hung mounts
+    pool.submit(root_probe, true);
+    for (const auto &probe : probes)
+        pool.submit(probe);
+    pool.wait(timeout_ms);
+
+    struct statfs s;
+    for (size_t i = 0; i < mounts.size(); i++)
+    {
+        mounts[i].status = pool.result(*probes[i], s);
+        fillMountStats(s, mounts[i]);
+    }
+
+    switch (pool.result(*root_probe, s))
+    {
+    case FsProbe::status::ok:
+        fillDiskStats(s, root);
+        break;
+    case FsProbe::status::failed:
+        return error::root_failed;
+    case FsProbe::status::stale:
+        break;
+    }
+
+    return result;
+}
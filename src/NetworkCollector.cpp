@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NetworkCollector.hpp"
+
+using namespace std;
+using namespace ob;
+
+/* Large enough for any single dump message the kernel sends (it sizes them to the reader's buffer). */
+static constexpr size_t receive_buffer_size = 32768;
+
+/**
+ * @brief Returns CLOCK_MONOTONIC in nanoseconds.
+ */
+static uint64_t monotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Rate of a monotonic counter; a counter that went backwards (interface reset) reads as idle.
+ */
+static inline double counterRate(uint64_t current, uint64_t previous, double elapsed_s)
+{
+    return (elapsed_s > 0 && current >= previous) ? (current - previous) / elapsed_s : 0;
+}
+
+NetworkCollector::NetworkCollector()
+    : sock(socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE)), buf(receive_buffer_size),
+      wireless_file("/proc/net/wireless")
+{
+    if (sock < 0)
+    {
+        throw runtime_error("Failed to open netlink socket");
+    }
+
+    struct sockaddr_nl addr = {};
+    addr.nl_family = AF_NETLINK;
+    if (bind(sock, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0)
+    {
+        close(sock);
+        throw runtime_error("Failed to bind netlink socket");
+    }
+}
+
+NetworkCollector::~NetworkCollector()
+{
+    close(sock);
+}
+
+/**
+ * @brief Sends a RTM_GETLINK dump request and fills @p interfaces from the replies.
+ */
+optional<NetworkCollector::error> NetworkCollector::dumpLinks(vector<InterfaceStats> &interfaces, double elapsed_s)
+{
+    struct
+    {
+        struct nlmsghdr header;
+        struct ifinfomsg info;
+    } request = {};
+    request.header.nlmsg_len = sizeof(request);
+    request.header.nlmsg_type = RTM_GETLINK;
+    request.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    request.header.nlmsg_seq = ++seq;
+    request.info.ifi_family = AF_UNSPEC;
+
+    if (send(sock, &request, sizeof(request), 0) < 0)
+    {
+        return error::request_failed;
+    }
+
+    for (;;)
+    {
+        ssize_t len = recv(sock, buf.data(), buf.size(), 0);
+        if (len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return error::request_failed;
+        }
+
+        for (auto *msg = reinterpret_cast<struct nlmsghdr *>(buf.data()); NLMSG_OK(msg, len); msg = NLMSG_NEXT(msg, len))
+        {
+            if (msg->nlmsg_seq != seq)
+                continue;
+            if (msg->nlmsg_type == NLMSG_DONE)
+                return {};
+            if (msg->nlmsg_type == NLMSG_ERROR)
+                return error::parse_failed;
+            if (msg->nlmsg_type != RTM_NEWLINK)
+                continue;
+
+            const auto *info = static_cast<const struct ifinfomsg *>(NLMSG_DATA(msg));
+            const char *name = nullptr;
+            const struct rtnl_link_stats64 *link_stats = nullptr;
+            int attr_len = IFLA_PAYLOAD(msg);
+            for (auto *attr = IFLA_RTA(info); RTA_OK(attr, attr_len); attr = RTA_NEXT(attr, attr_len))
+            {
+                if (attr->rta_type == IFLA_IFNAME)
+                    name = static_cast<const char *>(RTA_DATA(attr));
+                else if (attr->rta_type == IFLA_STATS64 && RTA_PAYLOAD(attr) >= sizeof(struct rtnl_link_stats64))
+                    link_stats = static_cast<const struct rtnl_link_stats64 *>(RTA_DATA(attr));
+            }
+            if (!name || !link_stats)
+                continue;
+
+            // attributes are only 4-byte aligned, so copy the 64-bit counters out
+            struct rtnl_link_stats64 counters;
+            memcpy(&counters, link_stats, sizeof(counters));
+
+            InterfaceStats &stats = interfaces.emplace_back();
+            strncpy(stats.name, name, sizeof(stats.name) - 1);
+            stats.name[sizeof(stats.name) - 1] = '\0';
+            stats.rx_bytes = counters.rx_bytes;
+            stats.tx_bytes = counters.tx_bytes;
+            stats.rx_packets = counters.rx_packets;
+            stats.tx_packets = counters.tx_packets;
+            stats.rx_errors = counters.rx_errors;
+            stats.tx_errors = counters.tx_errors;
+            stats.rx_dropped = counters.rx_dropped;
+            stats.tx_dropped = counters.tx_dropped;
+
+            current.push_back({info->ifi_index, counters.rx_bytes, counters.tx_bytes,
+                               counters.rx_packets, counters.tx_packets});
+
+            // interfaces are dumped in ifindex order, so a linear search usually hits right away
+            auto prev = find_if(previous.begin(), previous.end(),
+                                [&](const Previous &p) { return p.ifindex == info->ifi_index; });
+            if (prev != previous.end())
+            {
+                stats.rx_bytes_per_s = counterRate(counters.rx_bytes, prev->rx_bytes, elapsed_s);
+                stats.tx_bytes_per_s = counterRate(counters.tx_bytes, prev->tx_bytes, elapsed_s);
+                stats.rx_packets_per_s = counterRate(counters.rx_packets, prev->rx_packets, elapsed_s);
+                stats.tx_packets_per_s = counterRate(counters.tx_packets, prev->tx_packets, elapsed_s);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Adds the link quality columns of /proc/net/wireless to the matching interfaces.
+ *
+ * Format, after two header lines:
+ * ` wlan0: 0000   54.  -56.  -256        0      0      0      0      0        0`
+ */
+void NetworkCollector::readWireless(vector<InterfaceStats> &interfaces)
+{
+    if (!wireless_file.isOpen())
+        return;
+
+    const auto text = wireless_file.read();
+    if (!text.has_value())
+        return;
+
+    procfs::Scanner scanner(text.value());
+    procfs::Line line;
+    scanner.next(line);
+    scanner.next(line);
+    while (scanner.next(line))
+    {
+        const auto name = line.key();
+        auto it = find_if(interfaces.begin(), interfaces.end(),
+                          [&](const InterfaceStats &i) { return name == i.name; });
+        if (it == interfaces.end())
+            continue;
+
+        line.skip(1); // status
+        it->wireless = line.i64(it->link_quality) && line.i64(it->signal_dbm) && line.i64(it->noise_dbm);
+    }
+}
+
+optional<NetworkCollector::error> NetworkCollector::collect(vector<InterfaceStats> &interfaces)
+{
+    const uint64_t now_ns = monotonicNs();
+    const double elapsed_s = previous_ns ? (now_ns - previous_ns) / 1e9 : 0;
+
+    interfaces.clear();
+    current.clear();
+    if (auto err = dumpLinks(interfaces, elapsed_s))
+        return err;
+
+    readWireless(interfaces);
+
+    previous.swap(current);
+    previous_ns = now_ns;
+
+    return {};
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "PressureCollector.hpp"
+#include "log_utils.h"
+
+using namespace std;
+using namespace ob;
+
+static const char *const pressure_paths[num_pressure_resources] = {
+    "/proc/pressure/cpu",
+    "/proc/pressure/memory",
+    "/proc/pressure/io",
+};
+
+const char *ob::pressureResourceName(PressureResource resource)
+{
+    switch (resource)
+    {
+    case PressureResource::cpu:
+        return "cpu";
+    case PressureResource::memory:
+        return "memory";
+    case PressureResource::io:
+        return "io";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief Parses a `key=12.34` token into a double; the kernel always prints two decimals.
+ */
+static double parseAverage(string_view token)
+{
+    size_t eq = token.find('=');
+    if (eq == string_view::npos)
+        return 0;
+
+    const char *p = token.data() + eq + 1;
+    const char *end = token.data() + token.size();
+    uint64_t integer, fraction = 0;
+    p = procfs::parseU64(p, end, integer);
+    const char *fraction_start = p + 1;
+    if (p < end && *p == '.')
+        p = procfs::parseU64(fraction_start, end, fraction);
+
+    double scale = 1;
+    for (const char *q = fraction_start; q < p; q++)
+        scale *= 10;
+    return integer + fraction / scale;
+}
+
+/**
+ * @brief Parses `avg10=0.00 avg60=0.00 avg300=0.00 total=0`.
+ */
+static void parsePressureLine(procfs::Line &line, PressureLine &out)
+{
+    out.avg10 = parseAverage(line.token());
+    out.avg60 = parseAverage(line.token());
+    out.avg300 = parseAverage(line.token());
+    const auto total = line.token();
+    size_t eq = total.find('=');
+    out.total = 0;
+    if (eq != string_view::npos)
+        procfs::parseU64(total.data() + eq + 1, total.data() + total.size(), out.total);
+}
+
+PressureCollector::PressureCollector()
+{
+    for (size_t i = 0; i < num_pressure_resources; i++)
+        files[i].open(pressure_paths[i]);
+}
+
+void PressureCollector::collect(array<PressureStats, num_pressure_resources> &stats)
+{
+    for (size_t i = 0; i < num_pressure_resources; i++)
+    {
+        stats[i] = {};
+        if (!files[i].isOpen())
+            continue;
+
+        const auto text = files[i].read();
+        if (!text.has_value())
+            continue;
+
+        procfs::Scanner scanner(text.value());
+        procfs::Line line;
+        while (scanner.next(line))
+        {
+            const auto kind = line.token();
+            if (kind == "some")
+                parsePressureLine(line, stats[i].some);
+            else if (kind == "full")
+                parsePressureLine(line, stats[i].full);
+        }
+        stats[i].available = true;
+    }
+}
+
+PressureMonitor::PressureMonitor(const string &trigger)
+{
+    fds.fill(-1);
+    if (trigger.empty())
+        return;
+
+    for (size_t i = 0; i < num_pressure_resources; i++)
+    {
+        int fd = open(pressure_paths[i], O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0)
+        {
+            OD_LOG_WARNING("Cannot monitor %s pressure: %s", pressure_paths[i], strerror(errno));
+            continue;
+        }
+        // the trigger string must be written with its terminating NUL
+        if (write(fd, trigger.c_str(), trigger.size() + 1) < 0)
+        {
+            OD_LOG_WARNING("Cannot register PSI trigger '%s' on %s: %s", trigger.c_str(), pressure_paths[i], strerror(errno));
+            close(fd);
+            continue;
+        }
+        fds[i] = fd;
+    }
+}
+
+PressureMonitor::~PressureMonitor()
+{
+    for (int fd : fds)
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+optional<PressureResource> PressureMonitor::handleEvent(int fd, short revents)
+{
+    for (size_t i = 0; i < num_pressure_resources; i++)
+    {
+        if (fd < 0 || fds[i] != fd)
+            continue;
+
+        if (revents & POLLERR)
+        {
+            // the monitored resource went away; stop polling it instead of spinning
+            close(fds[i]);
+            fds[i] = -1;
+        }
+        else if (revents & POLLPRI)
+        {
+            return static_cast<PressureResource>(i);
+        }
+    }
+    return {};
+}
@@ -0,0 +1,280 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <time.h>
+#include <unistd.h>
+
+#include "ProcessCollector.hpp"
+#include "Procfs.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * @brief Returns @p clock in nanoseconds.
+ */
+static uint64_t clockNs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/**
+ * @brief Hashes a (pid, starttime) key for the open-addressing table.
+ */
+static inline size_t entryHash(int32_t pid, uint64_t starttime)
+{
+    uint64_t h = (static_cast<uint64_t>(pid) << 32 | (starttime & 0xffffffff)) * 0x9e3779b97f4a7c15ull;
+    return h >> 32;
+}
+
+ProcessCollector::ProcessCollector(size_t top_n, unsigned threads)
+    : top_n(top_n), proc_dir(opendir("/proc")),
+      page_kb(sysconf(_SC_PAGESIZE) / 1024), ticks_per_s(sysconf(_SC_CLK_TCK))
+{
+    if (!proc_dir)
+    {
+        throw runtime_error("Failed to open /proc");
+    }
+
+    if (threads == 0)
+        threads = clamp(thread::hardware_concurrency(), 1u, 4u);
+
+    for (size_t slice = 1; slice < threads; slice++)
+        workers.emplace_back(&ProcessCollector::workerLoop, this, slice);
+}
+
+ProcessCollector::~ProcessCollector()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto &worker : workers)
+        worker.join();
+
+    closedir(proc_dir);
+}
+
+/**
+ * @brief Waits for scan requests and scans the given slice of the PID list.
+ */
+void ProcessCollector::workerLoop(size_t slice)
+{
+    uint64_t seen = 0;
+    unique_lock<std::mutex> lock(mutex);
+    for (;;)
+    {
+        start_cv.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping)
+            return;
+        seen = generation;
+
+        lock.unlock();
+        scanSlice(slice);
+        lock.lock();
+
+        if (--pending == 0)
+            done_cv.notify_one();
+    }
+}
+
+/**
+ * @brief Reads the processes of one contiguous slice of the PID list.
+ */
+void ProcessCollector::scanSlice(size_t slice)
+{
+    const size_t slices = workers.size() + 1;
+    const size_t begin = pids.size() * slice / slices;
+    const size_t end = pids.size() * (slice + 1) / slices;
+    const int proc_fd = dirfd(proc_dir);
+
+    for (size_t i = begin; i < end; i++)
+        readProcess(proc_fd, pids[i], samples[i]);
+}
+
+/**
+ * @brief Reads /proc/[pid]/stat and computes the CPU usage against the previous scan.
+ *
+ * The RSS is taken from the stat line, which reports the same counter as the
+ * `resident` column of statm, so a single file is read per process.
+ */
+void ProcessCollector::readProcess(int proc_fd, int32_t pid, Sample &sample) const
+{
+    sample.pid = 0;
+
+    char path[32];
+    snprintf(path, sizeof(path), "%d/stat", pid);
+    int fd = openat(proc_fd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    char buf[2048];
+    ssize_t len = read(fd, buf, sizeof(buf));
+    close(fd);
+    if (len <= 0)
+        return;
+
+    // "pid (comm) state ..."; comm may itself contain spaces and parentheses
+    const char *end = buf + len;
+    const char *open_paren = static_cast<const char *>(memchr(buf, '(', len));
+    const char *close_paren = static_cast<const char *>(memrchr(buf, ')', len));
+    if (!open_paren || !close_paren || close_paren < open_paren)
+        return;
+
+    size_t name_len = min<size_t>(close_paren - open_paren - 1, sizeof(sample.name) - 1);
+    memcpy(sample.name, open_paren + 1, name_len);
+    sample.name[name_len] = '\0';
+
+    procfs::Line line(close_paren + 1, end);
+    line.skip(11); // state ppid pgrp session tty_nr tpgid flags minflt cminflt majflt cmajflt
+    uint64_t utime = line.u64();
+    uint64_t stime = line.u64();
+    line.skip(6); // cutime cstime priority nice num_threads itrealvalue
+    sample.starttime = line.u64();
+    line.skip(1); // vsize
+    sample.rss = line.u64() * page_kb;
+    sample.ticks = utime + stime;
+
+    const Entry *prev = findPrevious(pid, sample.starttime);
+    if (prev && scan_ns > previous_ns)
+    {
+        uint64_t delta = sample.ticks >= prev->ticks ? sample.ticks - prev->ticks : 0;
+        sample.cpu_percentage = delta * 100.0 * 1e9 / ticks_per_s / (scan_ns - previous_ns);
+    }
+    else if (boot_ticks > sample.starttime)
+    {
+        // first time this process is seen: report its average since it started, like ps(1)
+        sample.cpu_percentage = sample.ticks * 100.0 / (boot_ticks - sample.starttime);
+    }
+    else
+    {
+        sample.cpu_percentage = 0;
+    }
+
+    sample.pid = pid;
+}
+
+const ProcessCollector::Entry *ProcessCollector::findPrevious(int32_t pid, uint64_t starttime) const
+{
+    if (previous.empty())
+        return nullptr;
+
+    const size_t mask = previous.size() - 1;
+    for (size_t i = entryHash(pid, starttime) & mask;; i = (i + 1) & mask)
+    {
+        const Entry &entry = previous[i];
+        if (entry.pid == 0)
+            return nullptr;
+        if (entry.pid == pid && entry.starttime == starttime)
+            return &entry;
+    }
+}
+
+void ProcessCollector::insertCurrent(const Sample &sample)
+{
+    const size_t mask = current.size() - 1;
+    size_t i = entryHash(sample.pid, sample.starttime) & mask;
+    while (current[i].pid != 0)
+        i = (i + 1) & mask;
+    current[i] = {sample.pid, sample.starttime, sample.ticks};
+}
+
+/**
+ * @brief Offers @p sample to a bounded min-heap of at most @p n processes.
+ */
+template <typename Less>
+static void offer(vector<ProcessInfo> &heap, size_t n, const ProcessInfo &info, Less less)
+{
+    // `greater` keeps the smallest of the selected processes at the front
+    auto greater = [&](const ProcessInfo &a, const ProcessInfo &b) { return less(b, a); };
+    if (heap.size() < n)
+    {
+        heap.push_back(info);
+        push_heap(heap.begin(), heap.end(), greater);
+    }
+    else if (less(heap.front(), info))
+    {
+        pop_heap(heap.begin(), heap.end(), greater);
+        heap.back() = info;
+        push_heap(heap.begin(), heap.end(), greater);
+    }
+}
+
+optional<ProcessCollector::error> ProcessCollector::collect(ProcessStats &stats)
+{
+    pids.clear();
+    rewinddir(proc_dir);
+    while (struct dirent *ent = readdir(proc_dir))
+    {
+        uint64_t pid;
+        const char *name_end = ent->d_name + strlen(ent->d_name);
+        if (ent->d_type == DT_DIR && procfs::parseU64(ent->d_name, name_end, pid) == name_end && pid > 0)
+            pids.push_back(static_cast<int32_t>(pid));
+    }
+    if (pids.empty())
+    {
+        return error::read_failed;
+    }
+    samples.resize(pids.size());
+
+    scan_ns = clockNs(CLOCK_MONOTONIC);
+    boot_ticks = clockNs(CLOCK_BOOTTIME) / (1000000000ull / ticks_per_s);
+
+    {
+        lock_guard<std::mutex> lock(mutex);
+        generation++;
+        pending = workers.size();
+    }
+    start_cv.notify_all();
+    scanSlice(0);
+    {
+        unique_lock<std::mutex> lock(mutex);
+        done_cv.wait(lock, [&] { return pending == 0; });
+    }
+
+    current.resize(bit_ceil(max<size_t>(16, pids.size() * 2)));
+    fill(current.begin(), current.end(), Entry{});
+
+    auto by_cpu = [](const ProcessInfo &a, const ProcessInfo &b) { return a.cpu_percentage < b.cpu_percentage; };
+    auto by_rss = [](const ProcessInfo &a, const ProcessInfo &b) { return a.rss < b.rss; };
+
+    stats.total = 0;
+    stats.top_cpu.clear();
+    stats.top_rss.clear();
+    for (const auto &sample : samples)
+    {
+        if (sample.pid == 0)
+            continue;
+        stats.total++;
+        insertCurrent(sample);
+
+        ProcessInfo info;
+        info.pid = sample.pid;
+        memcpy(info.name, sample.name, sizeof(info.name));
+        info.cpu_percentage = sample.cpu_percentage;
+        info.rss = sample.rss;
+        offer(stats.top_cpu, top_n, info, by_cpu);
+        offer(stats.top_rss, top_n, info, by_rss);
+    }
+
+    auto greater_cpu = [&](const ProcessInfo &a, const ProcessInfo &b) { return by_cpu(b, a); };
+    auto greater_rss = [&](const ProcessInfo &a, const ProcessInfo &b) { return by_rss(b, a); };
+    sort_heap(stats.top_cpu.begin(), stats.top_cpu.end(), greater_cpu);
+    sort_heap(stats.top_rss.begin(), stats.top_rss.end(), greater_rss);
+
+    current.swap(previous);
+    previous_ns = scan_ns;
+
+    return {};
+}
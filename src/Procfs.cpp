@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utility>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "Procfs.hpp"
+
+using namespace std;
+using namespace ob::procfs;
+
+/* Initial read buffer; large files such as /proc/stat on big hosts grow it once. */
+static constexpr size_t initial_buffer_size = 4096;
+
+/**
+ * @brief Scans [p, end) for the first byte for which the vector predicate matches.
+ *
+ * @p match takes a vector of bytes and returns a vector with 0xff in matching lanes;
+ * @p scalar is the equivalent test for the tail.
+ */
+template <typename Match256, typename Match128, typename Scalar>
+static inline const char *scan(const char *p, const char *end, Match256 match256, Match128 match128, Scalar scalar)
+{
+#if defined(__AVX2__)
+    while (end - p >= 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        unsigned mask = _mm256_movemask_epi8(match256(v));
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 32;
+    }
+#else
+    (void)match256;
+#endif
+#if defined(__SSE2__)
+    while (end - p >= 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        unsigned mask = _mm_movemask_epi8(match128(v));
+        if (mask)
+            return p + __builtin_ctz(mask);
+        p += 16;
+    }
+#else
+    (void)match128;
+#endif
+    while (p < end && !scalar(*p))
+        p++;
+    return p;
+}
+
+#if defined(__AVX2__)
+#define MATCH256(body) [&](__m256i v) { return body; }
+#else
+#define MATCH256(body) [](int) { return 0; }
+#endif
+#if defined(__SSE2__)
+#define MATCH128(body) [&](__m128i v) { return body; }
+#else
+#define MATCH128(body) [](int) { return 0; }
+#endif
+
+const char *ob::procfs::findByte(const char *p, const char *end, char c)
+{
+    return scan(
+        p, end,
+        MATCH256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(c))),
+        MATCH128(_mm_cmpeq_epi8(v, _mm_set1_epi8(c))),
+        [c](char x) { return x == c; });
+}
+
+const char *ob::procfs::findSpace(const char *p, const char *end)
+{
+    return scan(
+        p, end,
+        MATCH256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                 _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')))),
+        MATCH128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                              _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')))),
+        [](char x) { return x == ' ' || x == '\t'; });
+}
+
+const char *ob::procfs::skipSpaces(const char *p, const char *end)
+{
+    // Tokens in procfs are usually separated by a single space; avoid the vector setup for those.
+    if (p < end && *p != ' ' && *p != '\t')
+        return p;
+    return scan(
+        p, end,
+        MATCH256(_mm256_xor_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')),
+                                                  _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t'))),
+                                  _mm256_set1_epi8(-1))),
+        MATCH128(_mm_xor_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')),
+                                            _mm_cmpeq_epi8(v, _mm_set1_epi8('\t'))),
+                               _mm_set1_epi8(-1))),
+        [](char x) { return x != ' ' && x != '\t'; });
+}
+
+File::File(const char *path)
+{
+    open(path);
+}
+
+File::File(File &&other) noexcept
+    : fd(exchange(other.fd, -1)), buf(std::move(other.buf))
+{
+}
+
+File &File::operator=(File &&other) noexcept
+{
+    if (this != &other)
+    {
+        close();
+        fd = exchange(other.fd, -1);
+        buf = std::move(other.buf);
+    }
+    return *this;
+}
+
+File::~File()
+{
+    close();
+}
+
+int File::open(const char *path, int dirfd)
+{
+    close();
+    fd = ::openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return -errno;
+    if (buf.empty())
+        buf.resize(initial_buffer_size);
+    return 0;
+}
+
+void File::close()
+{
+    if (fd >= 0)
+        ::close(fd);
+    fd = -1;
+}
+
+/**
+ * @brief Re-reads the whole file from offset 0.
+ *
+ * procfs files are generated on read, so the contents are read until EOF; if they do not
+ * fit, the buffer is doubled and the read restarted so the view is always a consistent snapshot.
+ */
+expected<string_view, int> File::read()
+{
+    if (fd < 0)
+        return unexpected(-EBADF);
+
+    for (;;)
+    {
+        size_t len = 0;
+        while (len < buf.size())
+        {
+            ssize_t n = ::pread(fd, buf.data() + len, buf.size() - len, len);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return unexpected(-errno);
+            }
+            if (n == 0)
+                return string_view(buf.data(), len);
+            len += n;
+        }
+        buf.resize(buf.size() * 2);
+    }
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <new>
+#include <time.h>
+
+#include "ReportBatch.hpp"
+#include "log_utils.h"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * @brief Reads @p clock in milliseconds.
+ */
+static uint64_t clockMs(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+ReportBatch::ReportBatch(size_t max_samples, unsigned max_age_ms, bool pretty, ReportFormat format)
+    : json(pretty), encoding(format), max_samples(max_samples > 0 ? max_samples : 1), max_age_ms(max_age_ms)
+{
+    clear();
+}
+
+void ReportBatch::setFormat(ReportFormat format)
+{
+    encoding = format;
+    clear();
+}
+
+bool ReportBatch::add(SystemInfo &sysinfo)
+{
+    if (full || finished)
+        return false;
+
+    const uint64_t now_ms = clockMs(CLOCK_MONOTONIC);
+    for (;;)
+    {
+        try
+        {
+            const auto timestamp_ms = static_cast<int64_t>(clockMs(CLOCK_REALTIME));
+            if (encoding == ReportFormat::columnar)
+            {
+                sysinfo.flatten(flat, timestamp_ms);
+                columns.add(flat.entries());
+            }
+            else if (encoding == ReportFormat::cbor)
+            {
+                sysinfo.appendCbor(cbor, timestamp_ms);
+            }
+            else
+            {
+                sysinfo.appendJson(json, timestamp_ms);
+            }
+            break;
+        }
+        catch (const bad_alloc &)
+        {
+            if (count > 0)
+            {
+                // send what fits and keep later batches at that size
+                OD_LOG_WARNING("Memory limit reached, shrinking batches to %zu samples.", count);
+                max_samples = count;
+                full = true;
+                return false;
+            }
+            if (!sysinfo.shed())
+                throw;
+        }
+    }
+
+    if (count == 0)
+        first_ms = now_ms;
+    count++;
+    return true;
+}
+
+bool ReportBatch::ready() const
+{
+    if (count == 0)
+        return false;
+    if (full || count >= max_samples)
+        return true;
+    return max_age_ms > 0 && clockMs(CLOCK_MONOTONIC) - first_ms >= max_age_ms;
+}
+
+string_view ReportBatch::finish()
+{
+    if (encoding == ReportFormat::columnar)
+    {
+        finished = true;
+        return columns.finish();
+    }
+    if (encoding == ReportFormat::cbor)
+    {
+        if (!finished)
+            cbor.endArray();
+        finished = true;
+        return cbor.view();
+    }
+    if (!finished)
+        json.endArray();
+    finished = true;
+    return json.view();
+}
+
+void ReportBatch::clear()
+{
+    json.reset();
+    cbor.reset();
+    columns.reset();
+    if (encoding == ReportFormat::cbor)
+        cbor.beginArray();
+    else if (encoding == ReportFormat::json)
+        json.beginArray();
+    count = 0;
+    full = false;
+    finished = false;
+}
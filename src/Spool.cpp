@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+#include "Spool.hpp"
+#include "log_utils.h"
+
+using namespace std;
+using namespace ob;
+
+namespace
+{
+    constexpr uint32_t segment_magic = 0x4c4f5053; // "SPOL"
+    constexpr uint32_t segment_version = 1;
+
+    /**
+     * @brief Start of every segment; records follow at header_size.
+     */
+    struct SegmentHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t sequence;
+        uint64_t committed;          ///< End of the committed records.
+        uint64_t consumed;           ///< End of the records read.
+        uint32_t committed_records;
+        uint32_t consumed_records;
+    };
+
+    struct RecordHeader
+    {
+        uint32_t length; ///< Payload bytes.
+        uint32_t crc;    ///< CRC-32 of the payload.
+    };
+
+    constexpr size_t header_size = 64;
+    static_assert(sizeof(SegmentHeader) <= header_size);
+
+    /**
+     * @brief Bytes taken by a record with a @p length byte payload.
+     */
+    constexpr size_t recordSize(size_t length)
+    {
+        return (sizeof(RecordHeader) + length + 7) & ~size_t(7);
+    }
+}
+
+static uint32_t crc32Of(string_view payload)
+{
+    return static_cast<uint32_t>(crc32(0, reinterpret_cast<const Bytef *>(payload.data()), payload.size()));
+}
+
+static SegmentHeader &headerOf(char *data)
+{
+    return *reinterpret_cast<SegmentHeader *>(data);
+}
+
+Spool::Spool(const SpoolConfig &config)
+    : config(config)
+{
+    if (mkdir(config.directory.c_str(), 0700) != 0 && errno != EEXIST)
+    {
+        throw runtime_error("Failed to create the spool directory " + config.directory);
+    }
+
+    DIR *dir = opendir(config.directory.c_str());
+    if (!dir)
+    {
+        throw runtime_error("Failed to open the spool directory " + config.directory);
+    }
+    vector<uint64_t> sequences;
+    while (struct dirent *entry = readdir(dir))
+    {
+        uint64_t sequence;
+        int length = 0;
+        if (sscanf(entry->d_name, "%16" SCNx64 ".spool%n", &sequence, &length) == 1 &&
+            entry->d_name[length] == '\0')
+            sequences.push_back(sequence);
+    }
+    closedir(dir);
+    sort(sequences.begin(), sequences.end());
+
+    // only the headers are read, so recovery takes the same time however many records are spooled
+    for (uint64_t sequence : sequences)
+    {
+        auto segment = openSegment(sequence, false);
+        if (!segment)
+        {
+            OD_LOG_WARNING("Discarding invalid spool segment %s.", segmentPath(sequence).c_str());
+            unlink(segmentPath(sequence).c_str());
+            continue;
+        }
+        const SegmentHeader &header = headerOf(segment->data);
+        records += header.committed_records - header.consumed_records;
+        segments.push_back(*segment);
+    }
+    if (records > 0)
+        OD_LOG_INFO("Recovered %zu spooled reports.", records);
+}
+
+Spool::~Spool()
+{
+    for (auto &segment : segments)
+        closeSegment(segment, false);
+}
+
+string Spool::segmentPath(uint64_t sequence) const
+{
+    char name[32];
+    snprintf(name, sizeof(name), "/%016" PRIx64 ".spool", sequence);
+    return config.directory + name;
+}
+
+/**
+ * @brief Maps the segment file of @p sequence, creating it if @p create is set.
+ * @return An empty optional if the file cannot be mapped or its header is not valid.
+ */
+optional<Spool::Segment> Spool::openSegment(uint64_t sequence, bool create)
+{
+    const string path = segmentPath(sequence);
+    int fd = open(path.c_str(), O_RDWR | O_CLOEXEC | (create ? O_CREAT | O_EXCL : 0), 0600);
+    if (fd < 0)
+        return {};
+
+    size_t size = config.segment_size;
+    if (create)
+    {
+        // sparse: the blocks are only allocated as records are written
+        if (ftruncate(fd, size) != 0)
+        {
+            close(fd);
+            unlink(path.c_str());
+            return {};
+        }
+    }
+    else
+    {
+        // segments keep the size they were created with
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < header_size)
+        {
+            close(fd);
+            return {};
+        }
+        size = st.st_size;
+    }
+
+    void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(fd);
+        if (create)
+            unlink(path.c_str());
+        return {};
+    }
+    Segment segment{sequence, fd, static_cast<char *>(data), size};
+
+    SegmentHeader &header = headerOf(segment.data);
+    if (create)
+    {
+        header = {segment_magic, segment_version, sequence, header_size, header_size, 0, 0};
+        msync(segment.data, header_size, MS_SYNC);
+
+        // make the new file's directory entry durable too
+        int dir_fd = open(config.directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir_fd >= 0)
+        {
+            fsync(dir_fd);
+            close(dir_fd);
+        }
+    }
+    else if (header.magic != segment_magic || header.version != segment_version ||
+             header.sequence != sequence || header.committed < header_size || header.committed > size ||
+             header.consumed < header_size || header.consumed > header.committed ||
+             header.consumed_records > header.committed_records)
+    {
+        closeSegment(segment, false);
+        return {};
+    }
+    return segment;
+}
+
+void Spool::closeSegment(Segment &segment, bool remove)
+{
+    munmap(segment.data, segment.size);
+    close(segment.fd);
+    if (remove)
+        unlink(segmentPath(segment.sequence).c_str());
+}
+
+optional<Spool::error> Spool::append(string_view payload)
+{
+    const size_t size = recordSize(payload.size());
+    if (header_size + size > config.segment_size || payload.size() > UINT32_MAX)
+    {
+        return error::too_large;
+    }
+
+    if (segments.empty() || headerOf(segments.back().data).committed + size > segments.back().size)
+    {
+        const uint64_t sequence = segments.empty() ? 1 : segments.back().sequence + 1;
+        auto segment = openSegment(sequence, true);
+        if (!segment)
+        {
+            return error::io_failed;
+        }
+        segments.push_back(*segment);
+
+        const size_t max_segments = max<size_t>(2, config.max_size / config.segment_size);
+        while (segments.size() > max_segments)
+        {
+            const SegmentHeader &oldest = headerOf(segments.front().data);
+            const size_t dropped = oldest.committed_records - oldest.consumed_records;
+            if (dropped > 0)
+                OD_LOG_WARNING("Spool full, dropping %zu of the oldest reports.", dropped);
+            records -= dropped;
+            closeSegment(segments.front(), true);
+            segments.pop_front();
+        }
+    }
+
+    Segment &segment = segments.back();
+    SegmentHeader &header = headerOf(segment.data);
+    char *record = segment.data + header.committed;
+
+    const RecordHeader record_header{static_cast<uint32_t>(payload.size()), crc32Of(payload)};
+    memcpy(record, &record_header, sizeof(record_header));
+    memcpy(record + sizeof(record_header), payload.data(), payload.size());
+
+    // the record must be on disk before the header points past it
+    const uintptr_t page_mask = ~static_cast<uintptr_t>(sysconf(_SC_PAGESIZE) - 1);
+    char *sync_start = reinterpret_cast<char *>(reinterpret_cast<uintptr_t>(record) & page_mask);
+    msync(sync_start, record + size - sync_start, MS_SYNC);
+
+    header.committed += size;
+    header.committed_records++;
+    msync(segment.data, header_size, MS_ASYNC);
+    records++;
+    return {};
+}
+
+optional<string_view> Spool::front()
+{
+    while (!segments.empty())
+    {
+        Segment &segment = segments.front();
+        SegmentHeader &header = headerOf(segment.data);
+
+        while (header.consumed < header.committed)
+        {
+            const char *record = segment.data + header.consumed;
+            RecordHeader record_header;
+            memcpy(&record_header, record, sizeof(record_header));
+            if (header.consumed + recordSize(record_header.length) > header.committed)
+            {
+                // the length itself is damaged, nothing after it can be trusted
+                OD_LOG_WARNING("Spool segment %s is corrupted, skipping %u reports.",
+                               segmentPath(segment.sequence).c_str(),
+                               header.committed_records - header.consumed_records);
+                records -= header.committed_records - header.consumed_records;
+                header.consumed = header.committed;
+                header.consumed_records = header.committed_records;
+                break;
+            }
+
+            const string_view payload(record + sizeof(record_header), record_header.length);
+            if (crc32Of(payload) == record_header.crc)
+                return payload;
+
+            OD_LOG_WARNING("Skipping a spooled report with a bad checksum.");
+            pop();
+        }
+
+        if (segments.size() == 1)
+        {
+            // the segment being written to stays, even when read entirely
+            break;
+        }
+        closeSegment(segment, true);
+        segments.pop_front();
+    }
+    return {};
+}
+
+void Spool::pop()
+{
+    if (segments.empty())
+        return;
+
+    Segment &segment = segments.front();
+    SegmentHeader &header = headerOf(segment.data);
+    if (header.consumed >= header.committed)
+        return;
+
+    RecordHeader record_header;
+    memcpy(&record_header, segment.data + header.consumed, sizeof(record_header));
+    header.consumed = min<uint64_t>(header.consumed + recordSize(record_header.length), header.committed);
+    header.consumed_records++;
+    msync(segment.data, header_size, MS_ASYNC);
+    records--;
+}
+
+bool Spool::empty() const
+{
+    return records == 0;
+}
@@ -4,171 +4,458 @@
  * SPDX-License-Identifier: Proprietary
  */
 #include "SystemInfo.hpp"
-#include <sys/sysinfo.h>
-#include <sys/statfs.h>
 #include <unistd.h>
-#include <json-c/json.h>
+#include <climits>
+#include <time.h>
 #include <string>
 #include <optional>
 #include <expected>
-#include "sys_utils.h"
+#include "Procfs.hpp"
+#include "log_utils.h"
 
 using namespace ob;
 using namespace std;
 
 /**
- * @brief Retrieves the system hostname.
+ * @brief Retrieves the system hostname into a caller-provided buffer.
  *
- * @return expected<string, SystemInfo::sysstats_error> containing the hostname in case of success.
+ * @return optional<SystemInfo::sysstats_error> empty in case of success.
  */
-static expected<string, SystemInfo::sysstats_error> getHostname()
+static optional<SystemInfo::sysstats_error> getHostname(char *hostname, size_t size)
 {
-    char hostname[256];
-    if (gethostname(hostname, sizeof(hostname)) != 0)
-        return unexpected(SystemInfo::sysstats_error::failed_to_get_hostname);
+    if (gethostname(hostname, size) != 0)
+        return SystemInfo::sysstats_error::failed_to_get_hostname;
+    hostname[size - 1] = '\0';
 
-    return string(hostname);
+    return {};
+}
+
+/**
+ * @brief Retrieves the system uptime.
+ *
+ * Uses CLOCK_BOOTTIME, the same clock `sysinfo()` reports uptime from.
+ *
+ * @return expected<int64_t, SystemInfo::sysstats_error> containing the uptime in seconds.
+ */
+static expected<int64_t, SystemInfo::sysstats_error> getUptime()
+{
+    struct timespec ts;
+    if (clock_gettime(CLOCK_BOOTTIME, &ts) != 0)
+        return unexpected(SystemInfo::sysstats_error::failed_to_get_uptime);
+
+    return ts.tv_sec;
 }
 
 /**
  * @brief Retrieves memory statistics.
  *
- * Shows sizes in KiB just like `free`.
+ * Shows sizes in KiB just like `free`. All the values come from a single read of /proc/meminfo.
  *
- * @param info Pointer to a valid sysinfo structure.
+ * @param meminfo_file Open /proc/meminfo handle.
  * @return expected<MemoryStats, SystemInfo::sysstats_error> containing memory statistics.
  */
-static expected<MemoryStats, SystemInfo::sysstats_error> getMemoryStats(struct sysinfo *info)
+static expected<MemoryStats, SystemInfo::sysstats_error> getMemoryStats(procfs::File &meminfo_file)
 {
+    enum
+    {
+        mem_total,
+        mem_free,
+        mem_available,
+        buffers,
+        cached,
+        shmem,
+        sreclaimable
+    };
+    static constexpr auto keys = procfs::makeKeySet(
+        "MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "Shmem", "SReclaimable");
 
-    MemoryStats memory_info;
-    memory_info.total = (info->totalram * info->mem_unit) / 1024;
-    memory_info.free = (info->freeram * info->mem_unit) / 1024;
-    memory_info.shared = info->sharedram / 1024;
-    unsigned long cached_kb, available_kb, reclaimable_kb;
-    unsigned long long cached_plus_free;
+    const auto text = meminfo_file.read();
+    if (!text.has_value())
+    {
+        return unexpected(SystemInfo::sysstats_error::failed_to_parse_meminfo);
+    }
 
-    int ret = parse_meminfo(&cached_kb, &available_kb, &reclaimable_kb);
-    if (ret)
+    uint64_t values[keys.size()] = {};
+    size_t found = 0;
+    procfs::Scanner scanner(text.value());
+    procfs::Line line;
+    while (found < keys.size() && scanner.next(line))
+    {
+        int idx = keys.find(line.key());
+        if (idx < 0)
+            continue;
+        values[idx] = line.u64();
+        found++;
+    }
+    if (found != keys.size())
     {
         return unexpected(SystemInfo::sysstats_error::failed_to_parse_meminfo);
     }
 
-    memory_info.available = ((unsigned long long)available_kb * 1024) / info->mem_unit;
-    memory_info.cached = ((unsigned long long)cached_kb * 1024) / info->mem_unit;
-    memory_info.cached += info->bufferram;
-    memory_info.cached += ((unsigned long long)reclaimable_kb * 1024) / info->mem_unit;
-    cached_plus_free = memory_info.cached + info->freeram;
-    memory_info.used = (info->totalram - cached_plus_free) / 1024;
+    MemoryStats memory_info;
+    memory_info.total = values[mem_total];
+    memory_info.free = values[mem_free];
+    memory_info.shared = values[shmem];
+    memory_info.available = values[mem_available];
+    memory_info.cached = values[cached] + values[buffers] + values[sreclaimable];
+    memory_info.used = memory_info.total - memory_info.free - memory_info.cached;
 
     return memory_info;
 }
 
-/**
- * @brief Retrieves disk statistics for the root filesystem.
- *
- * Shows sizes in KiB just like `df` and uses disk mounted at `/`.
- *
- * @return expected<DiskStats, SystemInfo::sysstats_error> containing disk statistics.
- */
-static expected<DiskStats, SystemInfo::sysstats_error> getDiskStats()
+SystemInfo::SystemInfo(const SystemInfoConfig &config)
+    : disk(), writer(config.pretty_json), meminfo_file("/proc/meminfo"), mount_collector(config.mounts, config.mount_timeout_ms, config.mountinfo_path)
 {
-    struct statfs s;
-    if (statfs("/", &s) != 0)
+    if (!meminfo_file.isOpen())
     {
-        return unexpected(SystemInfo::sysstats_error::failed_to_get_disk_stats);
+        throw runtime_error("Failed to open /proc/meminfo");
+    }
+    if (config.top_processes > 0)
+    {
+        process_collector.emplace(config.top_processes);
+    }
+    if (config.cgroup_depth > 0)
+    {
+        cgroup_collector.emplace(config.cgroup_depth);
     }
-
-    DiskStats disk;
-
-    long block_size = s.f_frsize;
-    disk.total = s.f_blocks * block_size / 1024;
-    disk.free = s.f_bfree * block_size / 1024;
-    disk.available = s.f_bavail * block_size / 1024;
-    disk.used = disk.total - disk.free;
-    disk.usage_percentage = (disk.used * 100.0) / disk.total;
-
-    return disk;
 }
 
 optional<SystemInfo::sysstats_error> SystemInfo::readSysInfo()
 {
-    struct sysinfo info;
-    if (sysinfo(&info))
+    try
     {
-        return sysstats_error::failed_to_get_sysinfo;
+        return collect();
     }
+    catch (const bad_alloc &)
+    {
+        // the remaining collectors get their memory back on the next cycle
+        if (!shed())
+            throw;
+        return sysstats_error::out_of_memory;
+    }
+}
+
+/**
+ * @brief Runs every collector; see readSysInfo().
+ */
+optional<SystemInfo::sysstats_error> SystemInfo::collect()
+{
+    const auto uptime = getUptime();
+    if (!uptime.has_value())
+        return uptime.error();
 
-    const auto hostname = getHostname();
-    if (!hostname.has_value())
-        return hostname.error();
+    char hostname[HOST_NAME_MAX + 1];
+    if (const auto error = getHostname(hostname, sizeof(hostname)); error.has_value())
+        return error;
 
-    const auto memory = getMemoryStats(&info);
+    const auto memory = getMemoryStats(meminfo_file);
     if (!memory.has_value())
         return memory.error();
 
-    const auto disk = getDiskStats();
-    if (!disk.has_value())
-        return disk.error();
+    // the root filesystem is probed with the other mounts, see MountCollector
+    DiskStats disk = this->disk;
+    const auto mount_error = mount_collector.collect(this->mounts, disk);
+    if (mount_error == MountCollector::error::root_failed)
+        return sysstats_error::failed_to_get_disk_stats;
 
-    this->hostname = hostname.value();
-    this->uptime = info.uptime;
+    // assign() reuses the string's buffer, so this only allocates if the hostname grew
+    this->hostname.assign(hostname);
+    this->uptime = uptime.value();
     this->memory = memory.value();
-    this->disk = disk.value();
+    this->disk = disk;
 
-    return {};
+    // the remaining collectors are independent, so one failing does not hold back the others
+    optional<sysstats_error> result;
+    const auto fail = [&](sysstats_error error)
+    {
+        if (!result.has_value())
+            result = error;
+    };
+
+    // the mounts of the last table read were still probed
+    if (mount_error.has_value())
+        fail(sysstats_error::failed_to_get_mount_stats);
+
+    if (cpu_collector.collect(this->cpu).has_value())
+        fail(sysstats_error::failed_to_get_cpu_stats);
+
+    try
+    {
+        if (process_collector && process_collector->collect(this->processes).has_value())
+            fail(sysstats_error::failed_to_get_process_stats);
+    }
+    catch (const bad_alloc &)
+    {
+        OD_LOG_WARNING("Memory limit reached while scanning processes, disabling the process collector.");
+        process_collector.reset();
+        this->processes = {};
+    }
+
+    if (block_device_collector.collect(this->block_devices).has_value())
+        fail(sysstats_error::failed_to_get_block_device_stats);
+
+    if (network_collector.collect(this->interfaces).has_value())
+        fail(sysstats_error::failed_to_get_network_stats);
+
+    pressure_collector.collect(this->pressure);
+
+    try
+    {
+        if (cgroup_collector && cgroup_collector->collect(this->cgroups).has_value())
+            OD_LOG_WARNING("cgroup events were lost, the cgroup tree was re-scanned.");
+    }
+    catch (const bad_alloc &)
+    {
+        // a rescan interrupted half-way leaves the tree inconsistent, so this collector goes
+        OD_LOG_WARNING("Memory limit reached while reading cgroups, disabling the cgroup collector.");
+        cgroup_collector.reset();
+        this->cgroups = {};
+    }
+
+    return result;
+}
+
+bool SystemInfo::shed()
+{
+    if (process_collector)
+    {
+        OD_LOG_WARNING("Memory limit reached, disabling the process collector.");
+        process_collector.reset();
+        this->processes = {};
+        return true;
+    }
+    if (cgroup_collector)
+    {
+        OD_LOG_WARNING("Memory limit reached, disabling the cgroup collector.");
+        cgroup_collector.reset();
+        this->cgroups = {};
+        return true;
+    }
+    return false;
+}
+
+void SystemInfo::appendJson(JsonWriter &json, optional<int64_t> timestamp_ms)
+{
+    appendReport(json, timestamp_ms);
+}
+
+void SystemInfo::appendCbor(CborWriter &cbor, optional<int64_t> timestamp_ms)
+{
+    appendReport(cbor, timestamp_ms);
+}
+
+template <typename Writer>
+void SystemInfo::appendReport(Writer &writer, optional<int64_t> timestamp_ms)
+{
+    const auto checkpoint = writer.checkpoint();
+    try
+    {
+        writeReport(writer, timestamp_ms);
+    }
+    catch (const bad_alloc &)
+    {
+        writer.rewind(checkpoint);
+        throw;
+    }
+}
+
+/**
+ * @brief Writes a list of schema-described structs as an array.
+ */
+template <typename Writer, typename S>
+static void listToJson(Writer &json, const vector<S> &list)
+{
+    json.beginArray();
+    for (const auto &item : list)
+        writeJson(json, item);
+    json.endArray();
 }
 
-expected<const string, SystemInfo::json_error> SystemInfo::toJson()
+/**
+ * @brief Writes the mounts that could be queried as an array.
+ *
+ * Mounts whose probe timed out are included with their last known values and `"stale": true`.
+ */
+template <typename Writer>
+static void mountListToJson(Writer &json, const vector<MountStats> &mounts)
 {
+    json.beginArray();
+    for (const auto &mount : mounts)
+    {
+        if (mount.status == FsProbe::status::failed)
+            continue;
+
+        json.beginObject();
+        writeJsonMembers(json, mount);
+        json.member("stale", mount.status == FsProbe::status::stale);
+        json.endObject();
+    }
+    json.endArray();
+}
 
-    json_object *sysinfo_json_obj = json_object_new_object();
-    if (!sysinfo_json_obj)
+/**
+ * @brief Writes the counters of network interfaces as an array.
+ */
+template <typename Writer>
+static void interfaceListToJson(Writer &json, const vector<InterfaceStats> &interfaces)
+{
+    json.beginArray();
+    for (const auto &interface : interfaces)
     {
-        return unexpected(json_error::json_object_creation_error);
+        json.beginObject();
+        writeJsonMembers(json, interface);
+        if (interface.wireless)
+        {
+            json.key("wireless");
+            json.beginObject();
+            json.member("link_quality", interface.link_quality);
+            json.member("signal_dbm", interface.signal_dbm);
+            json.member("noise_dbm", interface.noise_dbm);
+            json.endObject();
+        }
+        json.endObject();
     }
+    json.endArray();
+}
 
-    json_object *mem_json_obj = json_object_new_object();
-    if (!mem_json_obj)
+/**
+ * @brief Writes the pressure of every available resource as an object.
+ */
+template <typename Writer>
+static void pressureToJson(Writer &json, const array<PressureStats, num_pressure_resources> &pressure)
+{
+    json.beginObject();
+    for (size_t i = 0; i < num_pressure_resources; i++)
     {
-        json_object_put(sysinfo_json_obj);
-        return unexpected(json_error::json_object_creation_error);
+        if (!pressure[i].available)
+            continue;
+
+        json.key(pressureResourceName(static_cast<PressureResource>(i)));
+        json.beginObject();
+        json.key("some");
+        writeJson(json, pressure[i].some);
+        json.key("full");
+        writeJson(json, pressure[i].full);
+        json.endObject();
     }
+    json.endObject();
+}
+
+/**
+ * @brief Serializes the system information to JSON.
+ *
+ * The document is written into a buffer owned by this object, which is reused by the next call.
+ *
+ * @return std::string_view The JSON document, valid until the next call.
+ */
+string_view SystemInfo::toJson()
+{
+    serialize(writer);
+    return writer.view();
+}
+
+/**
+ * @brief Serializes the system information to CBOR, like toJson().
+ */
+string_view SystemInfo::toCbor()
+{
+    serialize(cbor_writer);
+    return cbor_writer.view();
+}
+
+void SystemInfo::flatten(FlatWriter &flat, optional<int64_t> timestamp_ms)
+{
+    serialize(flat, timestamp_ms);
+}
 
-    json_object *disk_json_obj = json_object_new_object();
-    if (!disk_json_obj)
+/**
+ * @brief Writes the report alone into @p writer, shedding optional collectors until it fits.
+ */
+template <typename Writer>
+void SystemInfo::serialize(Writer &writer, optional<int64_t> timestamp_ms)
+{
+    for (;;)
     {
-        json_object_put(sysinfo_json_obj);
-        json_object_put(mem_json_obj);
-        return unexpected(json_error::json_object_creation_error);
+        try
+        {
+            writer.reset();
+            writeReport(writer, timestamp_ms);
+            return;
+        }
+        catch (const bad_alloc &)
+        {
+            if (!shed())
+                throw;
+        }
     }
+}
+
+/**
+ * @brief Appends the report to @p json as an object, stamped with @p timestamp_ms if given.
+ */
+template <typename Writer>
+void SystemInfo::writeReport(Writer &json, optional<int64_t> timestamp_ms)
+{
+    json.beginObject();
+
+    if (timestamp_ms.has_value())
+        json.member("timestamp", timestamp_ms.value());
+
+    json.member("hostname", this->hostname);
+    json.member("uptime", this->uptime);
+
+    json.key("disk");
+    writeJson(json, this->disk);
 
-    json_object_object_add(sysinfo_json_obj, "hostname", json_object_new_string(this->hostname.c_str()));
-    json_object_object_add(sysinfo_json_obj, "uptime", json_object_new_int64(this->uptime));
+    json.key("mounts");
+    mountListToJson(json, this->mounts);
 
-    json_object_object_add(disk_json_obj, "total", json_object_new_int64(this->disk.total));
-    json_object_object_add(disk_json_obj, "free", json_object_new_int64(this->disk.free));
-    json_object_object_add(disk_json_obj, "used", json_object_new_int64(this->disk.used));
-    json_object_object_add(disk_json_obj, "available", json_object_new_int64(this->disk.available));
-    json_object_object_add(disk_json_obj, "usage_percentage", json_object_new_double(this->disk.usage_percentage));
+    json.key("block_devices");
+    listToJson(json, this->block_devices);
 
-    json_object_object_add(sysinfo_json_obj, "disk", disk_json_obj);
+    json.key("interfaces");
+    interfaceListToJson(json, this->interfaces);
 
-    json_object_object_add(mem_json_obj, "total", json_object_new_int64(this->memory.total));
-    json_object_object_add(mem_json_obj, "used", json_object_new_int64(this->memory.used));
-    json_object_object_add(mem_json_obj, "free", json_object_new_int64(this->memory.free));
-    json_object_object_add(mem_json_obj, "shared", json_object_new_int64(this->memory.shared));
-    json_object_object_add(mem_json_obj, "cached", json_object_new_int64(this->memory.cached));
-    json_object_object_add(mem_json_obj, "available", json_object_new_int64(this->memory.available));
+    json.key("pressure");
+    pressureToJson(json, this->pressure);
 
-    json_object_object_add(sysinfo_json_obj, "memory", mem_json_obj);
+    if (cgroup_collector)
+    {
+        json.key("cgroups");
+        listToJson(json, this->cgroups);
+    }
+
+    json.key("memory");
+    writeJson(json, this->memory);
+
+    json.key("cpu");
+    json.beginObject();
+    writeJsonMembers(json, this->cpu.total);
+    json.member("context_switches", this->cpu.context_switches);
+    json.member("procs_running", this->cpu.procs_running);
+    json.key("cores");
+    listToJson(json, this->cpu.cores);
+    json.endObject();
 
-    const char *json_str_c = json_object_to_json_string_ext(sysinfo_json_obj, JSON_C_TO_STRING_PRETTY);
-    // copy to string so we can free the json objects
-    string json_str = string(json_str_c);
+    if (process_collector)
+    {
+        json.key("processes");
+        json.beginObject();
+        json.member("total", this->processes.total);
+        json.key("top_cpu");
+        listToJson(json, this->processes.top_cpu);
+        json.key("top_rss");
+        listToJson(json, this->processes.top_rss);
+        json.endObject();
+    }
 
-    // Free only the parent object. The child objects will be freed automatically.
-    json_object_put(sysinfo_json_obj);
+#ifdef USE_ARENA
+    if (Arena *arena = Arena::get())
+    {
+        json.key("arena");
+        writeJson(json, arena->stats());
+    }
+#endif
 
-    return json_str;
+    json.endObject();
 }
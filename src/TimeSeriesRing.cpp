@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <new>
+#include <ranges>
+#include <stdexcept>
+#include <type_traits>
+#include <variant>
+
+#include "TimeSeriesRing.hpp"
+#include "log_utils.h"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * @brief Returns @p value as a double, or an empty optional for strings and empty containers.
+ */
+static optional<double> numericValue(const FlatWriter::Value &value)
+{
+    return visit([](const auto &v) -> optional<double>
+    {
+        using T = decay_t<decltype(v)>;
+        if constexpr (is_same_v<T, int64_t> || is_same_v<T, uint64_t> || is_same_v<T, double> ||
+                      is_same_v<T, bool>)
+            return static_cast<double>(v);
+        else
+            return {};
+    }, value);
+}
+
+TimeSeriesRing::TimeSeriesRing(size_t capacity, size_t max_fields)
+    : capacity_(max<size_t>(capacity, 1)), max_fields(max<size_t>(max_fields, 1))
+{
+    try
+    {
+        if (this->max_fields > values.max_size() / capacity_)
+            throw bad_alloc();
+        // every page is touched now, so the memory used is the same from the first sample on
+        values.assign(this->max_fields * capacity_, numeric_limits<double>::quiet_NaN());
+        timestamps.assign(capacity_, 0);
+        fields.reserve(this->max_fields);
+        index.reserve(this->max_fields);
+    }
+    catch (const bad_alloc &)
+    {
+        throw runtime_error("not enough memory for a history of " + to_string(capacity_) + " samples of " +
+                            to_string(this->max_fields) + " fields");
+    }
+}
+
+/**
+ * @brief Returns the column of @p path, the entry at @p position of the sample, taking one if it is new.
+ * @return An empty optional if no column is free, or the path does not fit in memory.
+ */
+optional<size_t> TimeSeriesRing::resolve(const string &path, size_t position)
+{
+    // samples usually have the same paths in the same order as the previous one
+    if (position < previous.size() && previous[position] < fields.size() && fields[previous[position]].path == path)
+        return previous[position];
+
+    size_t field;
+    if (auto it = index.find(path); it != index.end())
+    {
+        field = it->second;
+    }
+    else
+    {
+        field = fields.size();
+        if (field == max_fields)
+        {
+            // a field absent from every sample kept only holds NaN
+            auto stale = ranges::find_if(fields, [&](const Field &f) { return total - f.last_seen >= capacity_; });
+            if (stale == fields.end())
+            {
+                if (dropped++ == 0)
+                    OD_LOG_WARNING("History is full with %zu fields, leaving out '%s' and any other new field.",
+                                   max_fields, path.c_str());
+                return {};
+            }
+            field = static_cast<size_t>(stale - fields.begin());
+        }
+
+        try
+        {
+            string owned(path);
+            index.emplace(owned, field);
+            if (field < fields.size())
+            {
+                index.erase(fields[field].path);
+                fields[field].path = std::move(owned);
+            }
+            else
+            {
+                // reserved by the constructor
+                fields.push_back({std::move(owned), total});
+            }
+        }
+        catch (const bad_alloc &)
+        {
+            index.erase(path);
+            dropped++;
+            return {};
+        }
+    }
+
+    if (position < previous.size())
+        previous[position] = field;
+    return field;
+}
+
+void TimeSeriesRing::add(int64_t timestamp_ms, span<const FlatWriter::Entry> sample)
+{
+    const size_t slot = total % capacity_;
+    timestamps[slot] = total > 0 ? max(timestamp_ms, newest()) : timestamp_ms;
+
+    try
+    {
+        previous.resize(sample.size());
+    }
+    catch (const bad_alloc &)
+    {
+        // only the shortcut of resolve() is lost
+        previous.clear();
+    }
+
+    for (size_t i = 0; i < sample.size(); i++)
+    {
+        const auto value = numericValue(sample[i].value);
+        if (!value)
+            continue;
+        if (const auto field = resolve(sample[i].path, i))
+        {
+            column(*field)[slot] = *value;
+            fields[*field].last_seen = total;
+        }
+    }
+
+    // the slot still holds the values of the sample it overwrites
+    for (size_t field = 0; field < fields.size(); field++)
+    {
+        if (fields[field].last_seen != total)
+            column(field)[slot] = numeric_limits<double>::quiet_NaN();
+    }
+    total++;
+}
+
+void TimeSeriesRing::add(int64_t timestamp_ms, SystemInfo &sysinfo)
+{
+    sysinfo.flatten(flat);
+    add(timestamp_ms, flat.entries());
+}
+
+optional<RangeSummary> TimeSeriesRing::query(string_view path, int64_t from_ms, int64_t to_ms) const
+{
+    const auto it = index.find(path);
+    if (it == index.end() || from_ms > to_ms)
+        return {};
+
+    // samples are in time order, from the oldest
+    const auto samples = views::iota(size_t{0}, size());
+    const size_t begin = *ranges::partition_point(samples, [&](size_t i) { return timestamps[slotOf(i)] < from_ms; });
+    const size_t end = *ranges::partition_point(samples, [&](size_t i) { return timestamps[slotOf(i)] <= to_ms; });
+
+    RangeSummary summary{0, numeric_limits<double>::infinity(), -numeric_limits<double>::infinity(), 0.0};
+    double sum = 0.0;
+    const double *values_of = column(it->second);
+    // the range wraps around the end of the column at most once
+    size_t slot = slotOf(begin);
+    for (size_t remaining = end - begin; remaining > 0;)
+    {
+        const size_t run = min(remaining, capacity_ - slot);
+        for (const double v : span(values_of + slot, run))
+        {
+            if (isnan(v))
+                continue;
+            summary.count++;
+            summary.min = min(summary.min, v);
+            summary.max = max(summary.max, v);
+            sum += v;
+        }
+        remaining -= run;
+        slot = 0;
+    }
+
+    if (summary.count == 0)
+        return {};
+    summary.avg = sum / static_cast<double>(summary.count);
+    return summary;
+}
+
+void TimeSeriesRing::forEachField(const function<void(string_view)> &f) const
+{
+    for (const auto &field : fields)
+    {
+        // the oldest sample kept is `total - capacity_`
+        if (total - field.last_seen <= capacity_)
+            f(field.path);
+    }
+}
@@ -4,38 +4,106 @@
  * SPDX-License-Identifier: Proprietary
  */
 
+#include <algorithm>
+#include <functional>
 #include <string>
-#include <atomic>
+#include <string_view>
+#include <vector>
+#include <optional>
 #include <stdexcept>
+#include <new>
 #include <getopt.h>
 #include <signal.h>
+#include <time.h>
+#include <sys/epoll.h>
 #include "log_utils.h"
 #include "init_utils.h"
 
+#include "CborWriter.hpp"
+#include "ColumnarWriter.hpp"
+#include "DeltaEncoder.hpp"
+#include "EventLoop.hpp"
 #include "SystemInfo.hpp"
 #include "HTTPClient.hpp"
+#include "ReportBatch.hpp"
+#include "Spool.hpp"
+#include "TimeSeriesRing.hpp"
 
 using namespace std;
 
-atomic<bool> running(true);
 string server_url;
-int interval_s;
+uint64_t interval_ms;
+ob::SystemInfoConfig sysinfo_config;
+string psi_trigger = "some 150000 1000000";
+size_t arena_size = 0;
+size_t batch_size = 1;
+size_t max_in_flight = 2;
+ob::RetryConfig retry_config;
+ob::SpoolConfig spool_config;
+ob::CompressionConfig compression_config;
+ob::ReportFormat report_format = ob::ReportFormat::json;
+ob::DeltaConfig delta_config{0, {}};
+unsigned spool_drain_rate = 2;
+unsigned batch_timeout_s = 0;
+size_t history_samples = 0;
+size_t history_fields = 256;
 
 uint8_t verbosity = LOG_VERBOSITY_DEFAULT;
 
+/**
+ * @brief Splits a comma-separated command line value into its items.
+ */
+static vector<string> split_list(const char *arg)
+{
+    vector<string> items;
+    string_view list(arg);
+    while (!list.empty())
+    {
+        size_t comma = list.find(',');
+        if (comma != 0)
+            items.emplace_back(list.substr(0, comma));
+        if (comma == string_view::npos)
+            break;
+        list.remove_prefix(comma + 1);
+    }
+    return items;
+}
+
 static int parse_cmdline_arguments(int argc, char *argv[])
 {
     bool arg_server_url_set = false;
     bool arg_interval_set = false;
+    bool arg_compression_threshold_set = false;
 
     struct option long_options[] = {
         {"verbosity", required_argument, nullptr, 'v'},
         {"server-url", required_argument, nullptr, 's'},
         {"interval", required_argument, nullptr, 'i'},
+        {"top-processes", required_argument, nullptr, 'n'},
+        {"mount-exclude-fstypes", required_argument, nullptr, 'F'},
+        {"mount-exclude-paths", required_argument, nullptr, 'P'},
+        {"mount-timeout", required_argument, nullptr, 'T'},
+        {"psi-trigger", required_argument, nullptr, 'p'},
+        {"cgroup-depth", required_argument, nullptr, 'c'},
+        {"pretty-json", no_argument, nullptr, 'J'},
+        {"arena-size", required_argument, nullptr, 'A'},
+        {"batch-size", required_argument, nullptr, 'b'},
+        {"batch-timeout", required_argument, nullptr, 'B'},
+        {"max-in-flight", required_argument, nullptr, 'm'},
+        {"queue-size", required_argument, nullptr, 'q'},
+        {"spool-dir", required_argument, nullptr, 'd'},
+        {"spool-size", required_argument, nullptr, 'D'},
+        {"spool-drain-rate", required_argument, nullptr, 'r'},
+        {"format", required_argument, nullptr, 'f'},
+        {"compression", required_argument, nullptr, 'z'},
+        {"compression-threshold", required_argument, nullptr, 'Z'},
+        {"keyframe-interval", required_argument, nullptr, 'k'},
+        {"deadband", required_argument, nullptr, 'e'},
+        {"history", required_argument, nullptr, 'H'},
         {nullptr, 0, nullptr, 0}};
 
     int opt;
-    while ((opt = getopt_long(argc, argv, "v:s:i:", long_options, nullptr)) != -1)
+    while ((opt = getopt_long(argc, argv, "v:s:i:n:F:P:T:p:c:JA:b:B:m:q:d:D:r:f:z:Z:k:e:H:", long_options, nullptr)) != -1)
     {
         switch (opt)
         {
@@ -55,10 +123,26 @@ static int parse_cmdline_arguments(int argc, char *argv[])
         case 'i':
             try
             {
-                interval_s = std::stoi(optarg);
-                if (interval_s < 1)
+                // seconds, or milliseconds with an "ms" suffix
+                size_t unit_pos;
+                long interval = std::stol(optarg, &unit_pos);
+                const string_view unit(optarg + unit_pos);
+                if (unit == "ms")
+                {
+                    interval_ms = interval;
+                }
+                else if (unit.empty() || unit == "s")
+                {
+                    interval_ms = interval * 1000;
+                }
+                else
+                {
+                    OD_LOG_ERR("Invalid unit for --interval: '%s', expected 's' or 'ms'", optarg);
+                    return 1;
+                }
+                if (interval < 1)
                 {
-                    OD_LOG_ERR("interval must be >= 1 second");
+                    OD_LOG_ERR("interval must be >= 1 millisecond");
                     return 1;
                 }
             }
@@ -74,6 +158,371 @@ static int parse_cmdline_arguments(int argc, char *argv[])
             }
             arg_interval_set = true;
             break;
+        case 'n':
+            try
+            {
+                int top_processes = std::stoi(optarg);
+                if (top_processes < 0)
+                {
+                    OD_LOG_ERR("top-processes must be >= 0");
+                    return 1;
+                }
+                sysinfo_config.top_processes = top_processes;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --top-processes: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Top processes value out of range");
+                return 1;
+            }
+            break;
+        case 'F':
+            sysinfo_config.mounts.exclude_fstypes = split_list(optarg);
+            break;
+        case 'P':
+            sysinfo_config.mounts.exclude_paths = split_list(optarg);
+            break;
+        case 'T':
+            try
+            {
+                int mount_timeout_ms = std::stoi(optarg);
+                if (mount_timeout_ms < 1)
+                {
+                    OD_LOG_ERR("mount-timeout must be >= 1 millisecond");
+                    return 1;
+                }
+                sysinfo_config.mount_timeout_ms = mount_timeout_ms;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --mount-timeout: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Mount timeout value out of range");
+                return 1;
+            }
+            break;
+        case 'p':
+            psi_trigger = optarg;
+            break;
+        case 'c':
+            try
+            {
+                int cgroup_depth = std::stoi(optarg);
+                if (cgroup_depth < 0)
+                {
+                    OD_LOG_ERR("cgroup-depth must be >= 0");
+                    return 1;
+                }
+                sysinfo_config.cgroup_depth = cgroup_depth;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --cgroup-depth: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("cgroup depth value out of range");
+                return 1;
+            }
+            break;
+        case 'J':
+            sysinfo_config.pretty_json = true;
+            break;
+        case 'b':
+            try
+            {
+                int samples = std::stoi(optarg);
+                if (samples < 1)
+                {
+                    OD_LOG_ERR("batch-size must be >= 1");
+                    return 1;
+                }
+                batch_size = samples;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --batch-size: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Batch size value out of range");
+                return 1;
+            }
+            break;
+        case 'B':
+            try
+            {
+                int timeout_s = std::stoi(optarg);
+                if (timeout_s < 0)
+                {
+                    OD_LOG_ERR("batch-timeout must be >= 0 seconds");
+                    return 1;
+                }
+                batch_timeout_s = timeout_s;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --batch-timeout: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Batch timeout value out of range");
+                return 1;
+            }
+            break;
+        case 'm':
+            try
+            {
+                int requests = std::stoi(optarg);
+                if (requests < 1)
+                {
+                    OD_LOG_ERR("max-in-flight must be >= 1");
+                    return 1;
+                }
+                max_in_flight = requests;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --max-in-flight: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Max in flight value out of range");
+                return 1;
+            }
+            break;
+        case 'q':
+            try
+            {
+                int reports = std::stoi(optarg);
+                if (reports < 1)
+                {
+                    OD_LOG_ERR("queue-size must be >= 1");
+                    return 1;
+                }
+                retry_config.max_queued = reports;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --queue-size: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Queue size value out of range");
+                return 1;
+            }
+            break;
+        case 'd':
+            spool_config.directory = optarg;
+            break;
+        case 'D':
+            try
+            {
+                int kib = std::stoi(optarg);
+                if (kib < 256)
+                {
+                    OD_LOG_ERR("spool-size must be >= 256 KiB");
+                    return 1;
+                }
+                spool_config.max_size = static_cast<size_t>(kib) * 1024;
+                // at least 4 segments, so that dropping the oldest one loses a small share
+                spool_config.segment_size = min<size_t>(1024 * 1024, spool_config.max_size / 4);
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --spool-size: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Spool size value out of range");
+                return 1;
+            }
+            break;
+        case 'r':
+            try
+            {
+                int rate = std::stoi(optarg);
+                if (rate < 1 || rate > 1000)
+                {
+                    OD_LOG_ERR("spool-drain-rate must be between 1 and 1000 reports per second");
+                    return 1;
+                }
+                spool_drain_rate = rate;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --spool-drain-rate: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Spool drain rate value out of range");
+                return 1;
+            }
+            break;
+        case 'f':
+            if (auto format = ob::parseReportFormat(optarg))
+            {
+                report_format = format.value();
+            }
+            else
+            {
+                OD_LOG_ERR("Invalid value for --format: '%s', expected json, cbor or columnar", optarg);
+                return 1;
+            }
+            break;
+        case 'z':
+        {
+            // <algorithm>[:<level>]
+            const string_view value(optarg);
+            const size_t colon = value.find(':');
+            auto compression = ob::parseCompression(value.substr(0, colon));
+            if (!compression)
+            {
+                OD_LOG_ERR("Invalid value for --compression: '%s', expected none, gzip, zstd or zstd-dict", optarg);
+                return 1;
+            }
+            compression_config.algorithm = compression.value();
+            if (colon != string_view::npos)
+            {
+                try
+                {
+                    compression_config.level = std::stoi(string(value.substr(colon + 1)));
+                }
+                catch (const logic_error &)
+                {
+                    OD_LOG_ERR("Invalid compression level in --compression: '%s'", optarg);
+                    return 1;
+                }
+            }
+            break;
+        }
+        case 'Z':
+            try
+            {
+                int bytes = std::stoi(optarg);
+                if (bytes < 0)
+                {
+                    OD_LOG_ERR("compression-threshold must be >= 0 bytes");
+                    return 1;
+                }
+                compression_config.min_size = bytes;
+                arg_compression_threshold_set = true;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --compression-threshold: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Compression threshold value out of range");
+                return 1;
+            }
+            break;
+        case 'k':
+            try
+            {
+                int reports = std::stoi(optarg);
+                if (reports < 0)
+                {
+                    OD_LOG_ERR("keyframe-interval must be >= 0 reports");
+                    return 1;
+                }
+                delta_config.keyframe_interval = reports;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --keyframe-interval: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Keyframe interval value out of range");
+                return 1;
+            }
+            break;
+        case 'e':
+            if (auto deadband = ob::parseDeadband(optarg))
+            {
+                delta_config.deadbands.push_back(std::move(deadband.value()));
+            }
+            else
+            {
+                OD_LOG_ERR("Invalid value for --deadband: '%s', expected <field>=<threshold>[%%]", optarg);
+                return 1;
+            }
+            break;
+        case 'H':
+        {
+            // <samples>[:<fields>]
+            const string_view value(optarg);
+            const size_t colon = value.find(':');
+            try
+            {
+                int samples = std::stoi(string(value.substr(0, colon)));
+                int fields = colon == string_view::npos ? static_cast<int>(history_fields)
+                                                        : std::stoi(string(value.substr(colon + 1)));
+                if (samples < 0 || fields < 1)
+                {
+                    OD_LOG_ERR("history must be >= 0 samples of >= 1 fields");
+                    return 1;
+                }
+                history_samples = samples;
+                history_fields = fields;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --history: '%s', expected <samples>[:<fields>]", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("History size value out of range");
+                return 1;
+            }
+            break;
+        }
+        case 'A':
+#ifdef USE_ARENA
+            try
+            {
+                int kib = std::stoi(optarg);
+                if (kib < 64)
+                {
+                    OD_LOG_ERR("arena-size must be >= 64 KiB");
+                    return 1;
+                }
+                arena_size = static_cast<size_t>(kib) * 1024;
+            }
+            catch (const invalid_argument &)
+            {
+                OD_LOG_ERR("Invalid value for --arena-size: '%s'", optarg);
+                return 1;
+            }
+            catch (const out_of_range &)
+            {
+                OD_LOG_ERR("Arena size value out of range");
+                return 1;
+            }
+#else
+            OD_LOG_ERR("--arena-size requires a build with -DENABLE_ARENA=ON");
+            return 1;
+#endif
+            break;
         case '?':
             return 1;
         default:
@@ -81,6 +530,29 @@ static int parse_cmdline_arguments(int argc, char *argv[])
         }
     }
 
+    // with the dictionary, even the smallest reports shrink
+    if (compression_config.algorithm == ob::Compression::zstd_dictionary && !arg_compression_threshold_set)
+        compression_config.min_size = 0;
+
+    if (report_format == ob::ReportFormat::columnar && batch_size < 2)
+    {
+        OD_LOG_STDERR("%s: '-f/--format columnar' requires '-b/--batch-size' of 2 or more", argv[0]);
+        return 1;
+    }
+
+    if (!delta_config.deadbands.empty() && delta_config.keyframe_interval == 0)
+    {
+        OD_LOG_STDERR("%s: '-e/--deadband' requires '-k/--keyframe-interval'", argv[0]);
+        return 1;
+    }
+
+    // a delta only makes sense against the report sent right before it
+    if (delta_config.keyframe_interval > 0 && batch_size > 1)
+    {
+        OD_LOG_STDERR("%s: '-k/--keyframe-interval' cannot be combined with '-b/--batch-size'", argv[0]);
+        return 1;
+    }
+
     if (!arg_interval_set)
     {
         OD_LOG_STDERR("%s: argument '-i/--interval' is required", argv[0]);
@@ -96,17 +568,257 @@ static int parse_cmdline_arguments(int argc, char *argv[])
     return 0;
 }
 
-void signal_handle_cb(int signum)
+/**
+ * @brief Settles the record at the head of @p spool, sent by the drain, once the client is done with it.
+ *
+ * The record stays in the spool while it is in flight, so that a crash cannot lose it: it is
+ * popped once the server has it, or has rejected it for good. A record the client gave up on
+ * stays at the head, for the next drain tick to send again.
+ *
+ * @return true if the report was not delivered and stays in the spool.
+ */
+static bool spooled_report_completed(ob::Spool &spool, optional<ob::HTTPClient::error> post_error,
+                                     string_view payload)
+{
+    if (post_error == ob::HTTPClient::error::dropped)
+    {
+        OD_LOG_DBG("A spooled report was not delivered, it stays in the spool.");
+        return true;
+    }
+    // the oldest segment of a full spool may have been dropped meanwhile, the record with it
+    if (spool.front() == payload)
+        spool.pop();
+    return false;
+}
+
+/**
+ * @brief Logs the outcome of a report, saving it to @p spool if the client gave up on it, unless it is a delta.
+ */
+static void report_completed(optional<ob::Spool> &spool, optional<ob::HTTPClient::error> post_error,
+                             string_view payload)
+{
+    if (spool && post_error == ob::HTTPClient::error::dropped)
+    {
+        // a delta would no longer apply once the messages sent after it have been delivered
+        if (ob::DeltaEncoder::isDelta(payload))
+        {
+            OD_LOG_WARNING("Dropping an undelivered delta report, which cannot be spooled.");
+            return;
+        }
+        if (!spool->append(payload))
+        {
+            OD_LOG_DBG("Spooled a report, %zu in the spool.", spool->size());
+            return;
+        }
+        OD_LOG_ERR("Failed to spool a report!");
+    }
+
+    if (post_error.has_value())
+    {
+        switch (post_error.value())
+        {
+        case ob::HTTPClient::error::request_failed:
+            OD_LOG_ERR("HTTP request failed!");
+            break;
+        case ob::HTTPClient::error::unexpected_http_response_code:
+            OD_LOG_ERR("unexpected HTTP response code!");
+            break;
+        case ob::HTTPClient::error::dropped:
+            OD_LOG_ERR("Upload queue full or out of memory, dropping a report!");
+            break;
+        case ob::HTTPClient::error::unsupported_media_type:
+            OD_LOG_ERR("The server does not accept the report's format!");
+            break;
+        case ob::HTTPClient::error::conflict:
+            OD_LOG_WARNING("The server is missing earlier reports, sending a keyframe next.");
+            break;
+        default:
+            OD_LOG_ERR("Other HTTPClient error");
+            break;
+        }
+    }
+    else
+    {
+        OD_LOG_INFO("POST request sucessful.");
+    }
+}
+
+/**
+ * @brief Queues a POST request of @p payload; report_completed() logs its outcome.
+ *
+ * While the uploads are failing, the report goes straight to @p spool, if enabled.
+ */
+static void post_report(ob::HTTPClient &http_client, optional<ob::Spool> &spool, string_view payload)
+{
+    if (spool && http_client.backingOff())
+    {
+        report_completed(spool, ob::HTTPClient::error::dropped, payload);
+        return;
+    }
+
+    const ob::ReportFormat format = ob::detectReportFormat(payload);
+    OD_LOG_DBG("Executing POST request to '%s'.", server_url.c_str());
+    if (format == ob::ReportFormat::json)
+        OD_LOG_DBG("POST payload='%.*s'", static_cast<int>(payload.size()), payload.data());
+    else
+        OD_LOG_DBG("POST payload: %zu bytes of CBOR", payload.size());
+
+    http_client.post(payload, format);
+}
+
+/**
+ * @brief Switches to JSON after the server rejected a CBOR or columnar report, and sends @p payload again as JSON.
+ *
+ * @param transcoded Buffer for the JSON form of @p payload.
+ * @return false if @p payload is already JSON, or could not be transcoded.
+ */
+static bool fall_back_to_json(ob::HTTPClient &http_client, ob::JsonWriter &transcoded, string_view payload)
 {
-    if (signum == SIGTERM || signum == SIGINT)
+    const ob::ReportFormat format = ob::detectReportFormat(payload);
+    if (format == ob::ReportFormat::json)
+        return false;
+
+    if (report_format != ob::ReportFormat::json)
     {
-        OD_LOG_WARNING("Received termination signal. Stopping daemon...");
-        running = false;
+        OD_LOG_WARNING("The server does not accept the %s format, falling back to JSON.",
+                       report_format == ob::ReportFormat::cbor ? "CBOR" : "columnar");
+        report_format = ob::ReportFormat::json;
     }
-    else if (signum == SIGHUP)
+    const bool transcoded_ok = format == ob::ReportFormat::cbor ? ob::cborToJson(payload, transcoded)
+                                                                : ob::columnarToJson(payload, transcoded);
+    if (!transcoded_ok)
+        return false;
+
+    http_client.post(transcoded.view(), ob::ReportFormat::json);
+    return true;
+}
+
+/**
+ * @brief Reads @p clock in milliseconds.
+ */
+static uint64_t clock_ms(clockid_t clock)
+{
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Logs the minimum, average and maximum of every field kept in @p history.
+ */
+static void log_history(const ob::TimeSeriesRing &history)
+{
+    if (history.empty())
     {
-        OD_LOG_WARNING("Received SIGHUP, but no action implemented.");
+        OD_LOG_INFO("History is empty.");
+        return;
     }
+    OD_LOG_INFO("History of the last %zu samples, over %.1f s (%zu bytes):", history.size(),
+                static_cast<double>(history.newest() - history.oldest()) / 1000, history.memoryUsage());
+    history.forEachField([&](string_view path)
+    {
+        if (auto summary = history.query(path, history.oldest(), history.newest()))
+            OD_LOG_INFO("  %.*s: min %.12g, avg %.12g, max %.12g (%zu samples)", static_cast<int>(path.size()), path.data(),
+                        summary->min, summary->avg, summary->max, summary->count);
+    });
+}
+
+/**
+ * @brief Sends the samples of @p batch and empties it, disarming its age timer.
+ */
+static void send_batch(ob::HTTPClient &http_client, optional<ob::Spool> &spool, ob::ReportBatch &batch,
+                       ob::Timer &batch_timer)
+{
+    batch_timer.cancel();
+    post_report(http_client, spool, batch.finish());
+    batch.clear();
+}
+
+/**
+ * @brief Collects a sample and sends it, or adds it to @p batch and sends the batch once ready.
+ *
+ * With @p delta, a single report is sent as a keyframe or as the fields that changed. With
+ * @p history, the sample is also kept in memory. @p batch_timer is armed when a sample starts
+ * a batch, so the batch is sent once it is `--batch-timeout` old even if no sample follows.
+ */
+static void take_sample(ob::SystemInfo &systeminfo, ob::HTTPClient &http_client, optional<ob::Spool> &spool,
+                        optional<ob::ReportBatch> &batch, ob::Timer &batch_timer, optional<ob::DeltaEncoder> &delta,
+                        optional<ob::TimeSeriesRing> &history)
+{
+    auto si_error = systeminfo.readSysInfo();
+    if (si_error.has_value())
+    {
+        switch (si_error.value())
+        {
+        case (ob::SystemInfo::sysstats_error::failed_to_get_hostname):
+            OD_LOG_ERR("Failed to get hostname!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_get_uptime):
+            OD_LOG_ERR("Failed to get uptime!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_get_disk_stats):
+            OD_LOG_ERR("Failed to get disk stats!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_parse_meminfo):
+            OD_LOG_ERR("Failed to parse meminfo!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_get_cpu_stats):
+            OD_LOG_ERR("Failed to get CPU stats!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_get_process_stats):
+            OD_LOG_ERR("Failed to get process stats!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_get_mount_stats):
+            OD_LOG_ERR("Failed to get mount stats!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_get_block_device_stats):
+            OD_LOG_ERR("Failed to get block device stats!");
+            break;
+        case (ob::SystemInfo::sysstats_error::failed_to_get_network_stats):
+            OD_LOG_ERR("Failed to get network stats!");
+            break;
+        case (ob::SystemInfo::sysstats_error::out_of_memory):
+            OD_LOG_ERR("Memory limit reached while collecting stats!");
+            break;
+        default:
+            OD_LOG_ERR("Other sysstats error!");
+            break;
+        }
+    }
+
+    if (history)
+        history->add(static_cast<int64_t>(clock_ms(CLOCK_REALTIME)), systeminfo);
+
+    if (delta)
+    {
+        // a report spooled now arrives after later ones, so it has to stand on its own
+        const string_view payload = delta->encode(systeminfo, report_format, spool && http_client.backingOff());
+        post_report(http_client, spool, payload);
+    }
+    else if (!batch)
+    {
+        const string_view payload =
+            report_format == ob::ReportFormat::cbor ? systeminfo.toCbor() : systeminfo.toJson();
+        post_report(http_client, spool, payload);
+    }
+    else
+    {
+        // a batch changes format between two sends, after a fallback to JSON
+        if (batch->empty() && batch->format() != report_format)
+            batch->setFormat(report_format);
+        if (!batch->add(systeminfo))
+        {
+            // the sample did not fit in memory next to the batch, send the batch first
+            send_batch(http_client, spool, *batch, batch_timer);
+            batch->add(systeminfo);
+        }
+        if (batch->ready())
+            send_batch(http_client, spool, *batch, batch_timer);
+        else if (batch->size() == 1 && batch_timeout_s > 0)
+            batch_timer.setOnce(batch_timeout_s * 1000000000ull);
+    }
+    // kick watchdog
+    INIT_NOTIFY_WATCHDOG();
 }
 
 int main(int argc, char *argv[])
@@ -116,7 +828,16 @@ int main(int argc, char *argv[])
     ret = parse_cmdline_arguments(argc, argv);
     if (ret)
     {
-        OD_LOG_STDERR("Usage: %s [-v/--verbose] -s/--server-url <URL> -i/--interval <seconds>", argv[0]);
+        OD_LOG_STDERR("Usage: %s [-v/--verbose] -s/--server-url <URL> -i/--interval <seconds|<ms>ms> [-n/--top-processes <count>]"
+                      " [-F/--mount-exclude-fstypes <fstype,...>] [-P/--mount-exclude-paths <path,...>]"
+                      " [-T/--mount-timeout <ms>] [-p/--psi-trigger '<some|full> <stall us> <window us>'|'']"
+                      " [-c/--cgroup-depth <levels>] [-J/--pretty-json] [-A/--arena-size <KiB>]"
+                      " [-b/--batch-size <samples>] [-B/--batch-timeout <seconds>]"
+                      " [-m/--max-in-flight <requests>] [-q/--queue-size <reports>]"
+                      " [-d/--spool-dir <path>] [-D/--spool-size <KiB>] [-r/--spool-drain-rate <reports/s>]"
+                      " [-z/--compression <none|gzip|zstd|zstd-dict>[:<level>]] [-Z/--compression-threshold <bytes>]"
+                      " [-f/--format <json|cbor|columnar>] [-k/--keyframe-interval <reports>]"
+                      " [-e/--deadband <field>=<threshold>[%%]]... [-H/--history <samples>[:<fields>]]", argv[0]);
         // https://refspecs.linuxbase.org/LSB_3.1.1/LSB-Core-generic/LSB-Core-generic/iniscrptact.html
         // return 2 for invalid or excess argument(s)
         ret = 2;
@@ -124,91 +845,143 @@ int main(int argc, char *argv[])
         return ret;
     }
 
-    // setup signal handlers
-    struct sigaction sa{};
-    sa.sa_handler = signal_handle_cb;
-    sigemptyset(&sa.sa_mask);
-    sa.sa_flags = 0;
-
-    sigaction(SIGTERM, &sa, nullptr);
-    sigaction(SIGINT, &sa, nullptr);
-    sigaction(SIGHUP, &sa, nullptr);
+#ifdef USE_ARENA
+    // from here on, every C++ allocation comes from the arena
+    if (arena_size > 0 && !ob::Arena::create(arena_size))
+    {
+        OD_LOG_ERR("Failed to reserve a %zu byte arena.", arena_size);
+        ret = 1;
+        INIT_NOTIFY_FAILED_TO_STARTUP(ret);
+        return ret;
+    }
+#endif
 
-    // notify systemd that the daemon is ready
-    INIT_NOTIFY_READY();
     try
     {
-        ob::HTTPClient http_client(server_url);
-        ob::SystemInfo systeminfo;
-
-        while (running)
+        ob::EventLoop loop;
+        optional<ob::TimeSeriesRing> history;
+        // signals are blocked before any thread starts, so that they all go to the signalfd
+        loop.handleSignals({SIGTERM, SIGINT, SIGHUP}, [&loop, &history](int signum)
         {
-
-            auto si_error = systeminfo.readSysInfo();
-            if (si_error.has_value())
+            if (signum == SIGTERM || signum == SIGINT)
             {
-                switch (si_error.value())
-                {
-                case (ob::SystemInfo::sysstats_error::failed_to_get_hostname):
-                    OD_LOG_ERR("Failed to get hostname!");
-                    break;
-                case (ob::SystemInfo::sysstats_error::failed_to_get_sysinfo):
-                    OD_LOG_ERR("Failed to get sysinfo!");
-                    break;
-                case (ob::SystemInfo::sysstats_error::failed_to_get_disk_stats):
-                    OD_LOG_ERR("Failed to get disk stats!");
-                    break;
-                case (ob::SystemInfo::sysstats_error::failed_to_parse_meminfo):
-                    OD_LOG_ERR("Failed to parse meminfo!");
-                    break;
-                default:
-                    OD_LOG_ERR("Other sysstats error!");
-                    break;
-                }
+                OD_LOG_WARNING("Received termination signal. Stopping daemon...");
+                loop.stop();
             }
-
-            auto tojson_result = systeminfo.toJson();
-            if (!tojson_result.has_value())
+            else if (signum == SIGHUP)
             {
-                switch (tojson_result.error())
-                {
-                case ob::SystemInfo::json_error::json_object_creation_error:
-                    OD_LOG_ERR("Failed when creating JSON object!");
-                    break;
-                default:
-                    OD_LOG_ERR("Other json_error error!");
-                    break;
-                }
+                if (history)
+                    log_history(*history);
+                else
+                    OD_LOG_WARNING("Received SIGHUP, but no history is kept (see -H/--history).");
             }
+        });
+
+        // the whole history is allocated now, so its memory does not grow afterwards
+        if (history_samples > 0)
+            history.emplace(history_samples, history_fields);
+
+        optional<ob::Spool> spool;
+        if (!spool_config.directory.empty())
+            spool.emplace(spool_config);
+        ob::JsonWriter transcoded(sysinfo_config.pretty_json);
+        // hash of the spooled report in flight; the client sends a copy, so it is told apart by its bytes
+        optional<size_t> spooled_in_flight;
+        optional<ob::DeltaEncoder> delta;
+        if (delta_config.keyframe_interval > 0)
+            delta.emplace(delta_config, sysinfo_config.pretty_json);
+
+        ob::HTTPClient http_client(loop, server_url, max_in_flight,
+                                   [&](auto post_error, string_view payload)
+                                   {
+                                       // the server may now lack what the next delta builds on
+                                       if (post_error.has_value() && delta)
+                                           delta->requestKeyframe();
+                                       if (spooled_in_flight == hash<string_view>{}(payload))
+                                       {
+                                           spooled_in_flight.reset();
+                                           if (spooled_report_completed(*spool, post_error, payload))
+                                               return;
+                                       }
+                                       // reports already encoded in CBOR or columns are resent as JSON
+                                       if (post_error == ob::HTTPClient::error::unsupported_media_type &&
+                                           fall_back_to_json(http_client, transcoded, payload))
+                                           return;
+                                       report_completed(spool, post_error, payload);
+                                   },
+                                   retry_config, compression_config);
+        ob::SystemInfo systeminfo(sysinfo_config);
+        ob::PressureMonitor pressure_monitor(psi_trigger);
+        optional<ob::ReportBatch> batch;
+        if (batch_size > 1)
+            batch.emplace(batch_size, batch_timeout_s * 1000, sysinfo_config.pretty_json, report_format);
+
+        // a batch is sent when its oldest sample gets too old, not at the next sample after that
+        ob::Timer batch_timer(loop, CLOCK_MONOTONIC, [&]
+        {
+            if (batch && !batch->empty())
+                send_batch(http_client, spool, *batch, batch_timer);
+        });
 
-            string payload = tojson_result.value();
-            OD_LOG_DBG("Executing POST request to '%s'.", server_url.c_str());
-            OD_LOG_DBG("POST payload='%s'", payload.c_str());
+        // samples land on the wall-clock multiples of the interval, however long the uploads
+        // take; missed expirations are skipped rather than sent in a burst
+        ob::Timer sample_timer(loop, CLOCK_REALTIME, [&] { take_sample(systeminfo, http_client, spool, batch, batch_timer, delta, history); });
+        sample_timer.setAligned(interval_ms * 1000000);
 
-            auto post_error = http_client.post(payload);
-            if (post_error.has_value())
+        // spooled reports are sent back oldest-first, one at a time, only while the server keeps up
+        ob::Timer spool_drain(loop, CLOCK_MONOTONIC, [&]
+        {
+            if (spooled_in_flight || http_client.queued() > 0 || http_client.backingOff())
+                return;
+            if (auto payload = spool->front())
             {
-                switch (post_error.value())
-                {
-                case ob::HTTPClient::error::request_failed:
-                    OD_LOG_ERR("HTTP request failed!");
-                    break;
-                case ob::HTTPClient::error::unexpected_http_response_code:
-                    OD_LOG_ERR("unexpected HTTP response code!");
-                    break;
-                default:
-                    OD_LOG_ERR("Other HTTPClient error");
-                    break;
-                }
+                // set first, as post() may complete the report right away
+                spooled_in_flight = hash<string_view>{}(*payload);
+                http_client.post(*payload, ob::detectReportFormat(*payload));
             }
-            else
+        });
+        if (spool)
+            spool_drain.setAligned(1000000000ull / spool_drain_rate);
+
+        // a PSI trigger sends an out-of-band report; the regular cadence is unaffected
+        for (int fd : pressure_monitor.descriptors())
+        {
+            if (fd < 0)
+                continue;
+            loop.add(fd, EPOLLPRI, [&, fd](uint32_t events)
             {
-                OD_LOG_INFO("POST request sucessful.");
-            }
-            sleep(interval_s);
-            // kick watchdog
-            INIT_NOTIFY_WATCHDOG();
+                if (events & EPOLLERR)
+                    loop.remove(fd);
+                auto stalled = pressure_monitor.handleEvent(fd, static_cast<short>(events));
+                if (stalled.has_value())
+                {
+                    OD_LOG_INFO("PSI trigger fired on %s pressure, sending out-of-band report.",
+                                ob::pressureResourceName(stalled.value()));
+                    take_sample(systeminfo, http_client, spool, batch, batch_timer, delta, history);
+                }
+            });
         }
+
+        // notify systemd that the daemon is ready
+        INIT_NOTIFY_READY();
+
+        take_sample(systeminfo, http_client, spool, batch, batch_timer, delta, history);
+        loop.run();
+
+        // don't lose the samples collected since the last batch was sent
+        if (batch && !batch->empty())
+            post_report(http_client, spool, batch->finish());
+
+        // give the requests in flight and the queued reports a last chance to be delivered,
+        // unless the server is already known to be failing
+        const uint64_t drain_deadline_ms = clock_ms(CLOCK_MONOTONIC) + 5000;
+        while ((http_client.inFlight() > 0 || (http_client.queued() > 0 && !http_client.backingOff())) &&
+               clock_ms(CLOCK_MONOTONIC) < drain_deadline_ms)
+            loop.poll(static_cast<int>(drain_deadline_ms - clock_ms(CLOCK_MONOTONIC)));
+
+        // keep whatever could not be delivered for the next run
+        if (spool)
+            http_client.abandon();
     }
     catch (const runtime_error &e)
     {
@@ -216,6 +989,12 @@ int main(int argc, char *argv[])
         // return 1 for generic or unspecified error as specified in LSB docs
         ret = 1;
     }
+    catch (const bad_alloc &)
+    {
+        // only reachable in arena mode, once no optional collector is left to shed
+        OD_LOG_ERR("Shutting down daemon: the report does not fit in the memory limit.");
+        ret = 1;
+    }
 
     // notify daemon is stopping
     INIT_NOTIFY_STOPPING();
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "Check.hpp"
+#include "EventLoop.hpp"
+#include "SystemInfo.hpp"
+#include "alloc_utils.h"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * Runs the daemon's collect→serialize cycle against the live /proc with malloc() interposed
+ * (see alloc_utils.c): once the buffers have grown to the size of a report, a cycle must not
+ * touch the heap.
+ */
+
+namespace
+{
+    constexpr int warmup_cycles = 5;
+    constexpr int measured_cycles = 3;
+}
+
+/**
+ * @brief Checks that allocations are counted, so that a zero count means something.
+ */
+static void testInterposition()
+{
+    const uint64_t before = ALLOC_COUNT();
+    void *volatile block = malloc(64);
+    free(block);
+    CHECK(ALLOC_COUNT() == before + 1);
+
+    void *aligned = nullptr;
+    CHECK(posix_memalign(&aligned, 64, 100) == 0 && aligned != nullptr);
+    free(aligned);
+    CHECK(posix_memalign(&aligned, 24, 100) == EINVAL);
+    CHECK(posix_memalign(&aligned, sizeof(void *) / 2, 100) == EINVAL);
+    CHECK(posix_memalign(&aligned, 0, 100) == EINVAL);
+    CHECK(posix_memalign(&aligned, 64, SIZE_MAX - 4096) == ENOMEM);
+}
+
+/**
+ * @brief Dispatching an event must not copy its handler, whose captures live on the heap.
+ */
+static void testDispatch()
+{
+    EventLoop loop;
+    const int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    char padding[64] = {};
+    int calls = 0;
+    CHECK(loop.add(fd, EPOLLIN, [fd, padding, &calls](uint32_t)
+    {
+        uint64_t value;
+        if (read(fd, &value, sizeof(value)) == sizeof(value))
+            calls += 1 + padding[0];
+    }));
+
+    uint64_t one = 1;
+    for (int i = 0; i < 2; i++)
+    {
+        const uint64_t before = ALLOC_COUNT();
+        CHECK(write(fd, &one, sizeof(one)) == sizeof(one));
+        loop.poll(0);
+        if (i > 0)
+            CHECK(ALLOC_COUNT() == before);
+    }
+    CHECK(calls == 2);
+
+    loop.remove(fd);
+    close(fd);
+}
+
+static void cycle(SystemInfo &sysinfo)
+{
+    CHECK(!sysinfo.readSysInfo().has_value());
+    CHECK(!sysinfo.toJson().empty());
+    CHECK(!sysinfo.toCbor().empty());
+}
+
+int main()
+{
+    testInterposition();
+    testDispatch();
+
+    SystemInfo sysinfo;
+    for (int i = 0; i < warmup_cycles; i++)
+        cycle(sysinfo);
+
+    for (int i = 0; i < measured_cycles; i++)
+    {
+        const uint64_t before = ALLOC_COUNT();
+        cycle(sysinfo);
+        const uint64_t allocations = ALLOC_COUNT() - before;
+        if (!CHECK(allocations == 0))
+            fprintf(stderr, "  cycle %d made %" PRIu64 " heap allocations\n", warmup_cycles + i + 1, allocations);
+    }
+    return test::result();
+}
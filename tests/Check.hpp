@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * Minimal assertions for the test executables: a failed CHECK() is reported with its
+ * location and the test keeps going, then main() returns ob::test::result() so that ctest
+ * sees the failure. Each test is a single translation unit including this header once.
+ */
+
+/** Read by the logging macros of the code under test; only errors are printed. */
+uint8_t verbosity = 1;
+
+namespace ob::test
+{
+    inline int failures = 0;
+
+    inline bool check(bool ok, const char *expr, const char *file, int line)
+    {
+        if (!ok)
+        {
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+            failures++;
+        }
+        return ok;
+    }
+
+    /**
+     * @brief Exit status of the test: 0 if every check passed.
+     */
+    inline int result()
+    {
+        if (failures > 0)
+            fprintf(stderr, "%d check(s) failed\n", failures);
+        return failures > 0 ? 1 : 0;
+    }
+}
+
+#define CHECK(...) ob::test::check(static_cast<bool>(__VA_ARGS__), #__VA_ARGS__, __FILE__, __LINE__)
+
+#endif // CHECK_HPP
@@ -0,0 +1,237 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+#include "Check.hpp"
+#include "ColumnarWriter.hpp"
+#include "FlatWriter.hpp"
+#include "JsonWriter.hpp"
+#include "Random.hpp"
+
+using namespace std;
+using namespace ob;
+using test::Random;
+
+namespace
+{
+    /** Ten minutes of samples taken every second. */
+    constexpr size_t batch_samples = 600;
+}
+
+/**
+ * @brief Timestamp of sample @p i: mostly 1 s apart, with jitter, and jumps that need the
+ *        64-bit delta-of-delta escape, one of them back in time.
+ */
+static int64_t timestampOf(size_t i, int64_t previous, Random &random)
+{
+    if (i == 0)
+        return 1760000000000;
+    if (i == 300)
+        return previous + 86400000LL * 365;
+    if (i == 301)
+        return previous - 86400000LL * 400;
+    if (i % 97 == 0)
+        return previous + 1000 + static_cast<int64_t>(random.next() % 5000000);
+    return previous + 1000 + static_cast<int64_t>(random.next() % 21) - 10;
+}
+
+/**
+ * @brief Usage of sample @p i, with NaN, infinities and both zeroes among ordinary values.
+ */
+static double usageOf(size_t i, Random &random)
+{
+    switch (i % 50)
+    {
+    case 7:
+        return numeric_limits<double>::quiet_NaN();
+    case 8:
+        return -0.0;
+    case 9:
+        return 0.0;
+    case 10:
+        return numeric_limits<double>::infinity();
+    case 11:
+        return -numeric_limits<double>::infinity();
+    case 12:
+    case 13:
+        // unchanged, for the single bit of an equal value
+        return 42.5;
+    default:
+        return static_cast<double>(random.next() % 100000) / 1000.0;
+    }
+}
+
+/**
+ * @brief Writes sample @p i with the interface JsonWriter and FlatWriter share.
+ *
+ * Mounts and the `gpu` object come and go across the batch, the hostname never changes and
+ * the status takes a few values, like a report would.
+ */
+template <typename Writer>
+static void writeSample(Writer &w, size_t i, int64_t timestamp, double usage, uint64_t used)
+{
+    static const char *const statuses[] = {"ok", "ok", "ok", "degraded", "ok", "critical"};
+
+    w.beginObject();
+    w.member("timestamp", timestamp);
+    w.member("hostname", "reMarkable");
+    w.member("status", statuses[(i / 20) % 6]);
+
+    w.key("cpu");
+    w.beginObject();
+    w.member("usage_percentage", usage);
+    w.member("cores", 4u);
+    w.member("temperature", static_cast<int64_t>(45 - static_cast<int64_t>(i % 30)));
+    w.endObject();
+
+    w.key("memory");
+    w.beginObject();
+    w.member("total", uint64_t{2147483648});
+    w.member("used", used);
+    w.member("swap_enabled", i % 200 < 100);
+    w.endObject();
+
+    if (i % 3 != 0)
+    {
+        w.key("gpu");
+        w.beginObject();
+        w.member("frequency", static_cast<uint64_t>(200 + i % 7 * 100));
+        w.member("load", usage / 2);
+        w.endObject();
+    }
+
+    w.key("mounts");
+    w.beginArray();
+    w.beginObject();
+    w.member("path", "/");
+    w.member("free", static_cast<uint64_t>(1000000000 - i * 4096));
+    w.member("read_only", false);
+    w.endObject();
+    if ((i >= 100 && i < 250) || (i >= 400 && i < 450))
+    {
+        w.beginObject();
+        w.member("path", i < 250 ? "/media/usb" : "/media/sd");
+        w.member("free", static_cast<uint64_t>(8000000 + i));
+        w.member("read_only", i >= 400);
+        w.endObject();
+    }
+    w.endArray();
+
+    w.key("alerts");
+    w.beginArray();
+    if (i % 10 == 0)
+        w.value("disk");
+    w.endArray();
+
+    w.key("labels");
+    w.beginObject();
+    w.endObject();
+    w.endObject();
+}
+
+/**
+ * @brief Decodes a batch and compares it with the array JsonWriter wrote for the same samples.
+ */
+static void testRoundTrip(bool pretty)
+{
+    ColumnarWriter columnar;
+    FlatWriter flat;
+    JsonWriter expected(pretty);
+    JsonWriter decoded(pretty);
+
+    // a second batch starts over from the columns of the first
+    for (int batch = 0; batch < 2; batch++)
+    {
+        Random random;
+        random.state += batch;
+        columnar.reset();
+        expected.reset();
+        expected.beginArray();
+
+        int64_t timestamp = 0;
+        uint64_t used = 1 << 30;
+        for (size_t i = 0; i < batch_samples; i++)
+        {
+            timestamp = timestampOf(i, timestamp, random);
+            const double usage = usageOf(i, random);
+            // goes up and down, for negative deltas
+            used += random.next() % 65536;
+            used -= random.next() % 65536;
+
+            writeSample(expected, i, timestamp, usage, used);
+            flat.reset();
+            writeSample(flat, i, timestamp, usage, used);
+            columnar.add(flat.entries());
+        }
+        expected.endArray();
+        CHECK(columnar.size() == batch_samples);
+        CHECK(expected.view().find("-0.0") != string_view::npos);
+        CHECK(expected.view().find("NaN") != string_view::npos);
+
+        const string encoded(columnar.finish());
+        CHECK(encoded.size() < expected.view().size() / 4);
+        CHECK(columnarToJson(encoded, decoded));
+        CHECK(decoded.view() == expected.view());
+        if (decoded.view() != expected.view())
+        {
+            const auto [at, _] = ranges::mismatch(decoded.view(), expected.view());
+            fprintf(stderr, "differs at offset %zd\n", at - decoded.view().begin());
+        }
+
+        // a truncated batch is rejected, without reading past its end
+        for (size_t size = 0; size < encoded.size(); size += 1 + size / 64)
+            CHECK(!columnarToJson(string_view(encoded).substr(0, size), decoded));
+    }
+}
+
+/**
+ * @brief A path whose type changes mid-batch takes a column per type, in document order.
+ */
+static void testTypeChange()
+{
+    ColumnarWriter columnar;
+    FlatWriter flat;
+    JsonWriter expected, decoded;
+
+    expected.beginArray();
+    for (int i = 0; i < 4; i++)
+    {
+        flat.reset();
+        flat.beginObject();
+        expected.beginObject();
+        if (i % 2)
+        {
+            flat.member("value", 1.5 * i);
+            expected.member("value", 1.5 * i);
+        }
+        else
+        {
+            flat.member("value", int64_t{-i});
+            expected.member("value", int64_t{-i});
+        }
+        flat.endObject();
+        expected.endObject();
+        columnar.add(flat.entries());
+    }
+    expected.endArray();
+    CHECK(columnarToJson(columnar.finish(), decoded));
+    CHECK(decoded.view() == expected.view());
+
+    CHECK(!columnarToJson("", decoded));
+    CHECK(!columnarToJson("[]", decoded));
+}
+
+int main()
+{
+    testRoundTrip(false);
+    testRoundTrip(true);
+    testTypeChange();
+    return test::result();
+}
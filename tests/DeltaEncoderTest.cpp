@@ -0,0 +1,437 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <charconv>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "CborWriter.hpp"
+#include "Check.hpp"
+#include "DeltaEncoder.hpp"
+#include "FlatWriter.hpp"
+#include "JsonWriter.hpp"
+#include "SystemInfo.hpp"
+
+using namespace std;
+using namespace ob;
+
+namespace
+{
+    /**
+     * @struct Sample
+     * @brief Values of a small report, written the same way to every writer.
+     */
+    struct Sample
+    {
+        int64_t uptime = 100;
+        uint64_t used = 1000;
+        double usage = 50.0;
+        double idle[2] = {90.0, 80.0};
+        size_t mounts = 2;
+        bool alert = false;
+    };
+
+    /**
+     * @struct Message
+     * @brief A plain JSON message of the encoder, split into its parts.
+     */
+    struct Message
+    {
+        uint64_t stream = 0;
+        uint64_t sequence = 0;
+        bool keyframe = false;
+        string_view report;         ///< Whole report of a keyframe.
+        map<string, string> set;    ///< Path and JSON text of each value of a delta.
+        std::set<string> remove;
+    };
+
+    /** Paths and JSON text of the values, as a receiver applying the messages holds them. */
+    using State = map<string, string>;
+}
+
+template <typename Writer>
+static void writeReport(Writer &w, const Sample &sample)
+{
+    static const char *const paths[] = {"/", "/home", "/media/usb"};
+
+    w.beginObject();
+    w.member("hostname", "tablet");
+    w.member("uptime", sample.uptime);
+    w.key("memory");
+    w.beginObject();
+    w.member("total", uint64_t{2097152});
+    w.member("used", sample.used);
+    w.endObject();
+    w.key("cpu");
+    w.beginObject();
+    w.member("usage", sample.usage);
+    w.key("cores");
+    w.beginArray();
+    for (const double idle : sample.idle)
+    {
+        w.beginObject();
+        w.member("idle", idle);
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+    w.key("mounts");
+    w.beginArray();
+    for (size_t i = 0; i < sample.mounts; i++)
+    {
+        w.beginObject();
+        w.member("path", paths[i]);
+        w.member("free", static_cast<uint64_t>(5000 - i * 1000));
+        w.endObject();
+    }
+    w.endArray();
+    w.key("alerts");
+    w.beginArray();
+    if (sample.alert)
+        w.value("disk");
+    w.endArray();
+    w.endObject();
+}
+
+static string toJson(const Sample &sample)
+{
+    JsonWriter json;
+    writeReport(json, sample);
+    return string(json.view());
+}
+
+/**
+ * @brief The leaves of @p sample with their values as JSON text.
+ */
+static State stateOf(const Sample &sample)
+{
+    FlatWriter flat;
+    writeReport(flat, sample);
+    State state;
+    JsonWriter json;
+    for (const auto &entry : flat.entries())
+    {
+        json.reset();
+        DocumentBuilder<JsonWriter>::writeValue(json, entry.value);
+        state[entry.path] = json.view();
+    }
+    return state;
+}
+
+static bool consume(string_view &in, string_view token)
+{
+    if (!in.starts_with(token))
+        return false;
+    in.remove_prefix(token.size());
+    return true;
+}
+
+static bool readUint(string_view &in, uint64_t &value)
+{
+    const auto result = from_chars(in.data(), in.data() + in.size(), value);
+    if (result.ec != errc())
+        return false;
+    in.remove_prefix(static_cast<size_t>(result.ptr - in.data()));
+    return true;
+}
+
+/**
+ * @brief Reads a string or a scalar as its JSON text; containers can only be empty.
+ */
+static bool readValue(string_view &in, string_view &text)
+{
+    size_t end = 0;
+    if (in.starts_with('"'))
+    {
+        for (end = 1; end < in.size() && in[end] != '"'; end++)
+        {
+            if (in[end] == '\\')
+                end++;
+        }
+        end++;
+    }
+    else if (in.starts_with("{}") || in.starts_with("[]"))
+    {
+        end = 2;
+    }
+    else
+    {
+        end = in.find_first_of(",}]");
+    }
+    if (end == 0 || end > in.size())
+        return false;
+    text = in.substr(0, end);
+    in.remove_prefix(end);
+    return true;
+}
+
+/**
+ * @brief Splits a plain JSON message; paths are never escaped, as they have no special characters.
+ */
+static bool parse(string_view in, Message &message)
+{
+    message = {};
+    if (!consume(in, R"({"stream":)") || !readUint(in, message.stream) || !consume(in, R"(,"sequence":)") ||
+        !readUint(in, message.sequence))
+        return false;
+
+    if (consume(in, R"(,"keyframe":true,"report":)"))
+    {
+        message.keyframe = true;
+        if (!in.ends_with('}'))
+            return false;
+        message.report = in.substr(0, in.size() - 1);
+        return true;
+    }
+
+    if (!consume(in, R"(,"set":{)"))
+        return false;
+    while (!consume(in, "}"))
+    {
+        string_view path, text;
+        consume(in, ",");
+        if (!readValue(in, path) || !consume(in, ":") || !readValue(in, text))
+            return false;
+        message.set.emplace(path.substr(1, path.size() - 2), text);
+    }
+    if (consume(in, R"(,"remove":[)"))
+    {
+        while (!consume(in, "]"))
+        {
+            string_view path;
+            consume(in, ",");
+            if (!readValue(in, path))
+                return false;
+            message.remove.emplace(path.substr(1, path.size() - 2));
+        }
+    }
+    return in == "}";
+}
+
+/**
+ * @brief Encodes @p sample as the next message of @p encoder, in plain JSON, and splits it.
+ */
+static Message encode(DeltaEncoder &encoder, const Sample &sample, bool standalone = false)
+{
+    FlatWriter flat;
+    writeReport(flat, sample);
+    Message message;
+    CHECK(parse(encoder.encode(flat.entries(), ReportFormat::json, standalone), message));
+    return message;
+}
+
+/**
+ * @brief Keyframes come every `keyframe_interval` messages, when requested, and around a
+ *        standalone message, each with the whole report.
+ */
+static void testKeyframes()
+{
+    DeltaEncoder encoder({.keyframe_interval = 3});
+    Sample sample;
+
+    // index of each message, and whether it is a keyframe
+    const vector<bool> expected = {true, false, false, true, false, true, false, true, true, false};
+    uint64_t stream = 0;
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        sample.uptime++;
+        if (i == 5)
+            encoder.requestKeyframe();
+        const Message message = encode(encoder, sample, i == 7);
+        if (i == 0)
+            stream = message.stream;
+        CHECK(message.stream == stream);
+        CHECK(message.sequence == i);
+        CHECK(message.keyframe == expected[i]);
+        if (message.keyframe)
+            CHECK(message.report == toJson(sample));
+        else
+            CHECK((message.set == map<string, string>{{"uptime", to_string(sample.uptime)}} && message.remove.empty()));
+    }
+
+    // nothing changed
+    FlatWriter flat;
+    writeReport(flat, sample);
+    const string unchanged(encoder.encode(flat.entries(), ReportFormat::json));
+    CHECK(unchanged == R"({"stream":)" + to_string(stream) + R"(,"sequence":10,"set":{}})");
+}
+
+/**
+ * @brief A receiver applying the messages to the last keyframe holds every report, and each
+ *        delta holds only the values that changed and the paths that are gone.
+ */
+static void testRebuild()
+{
+    DeltaEncoder encoder({.keyframe_interval = 1000});
+    Sample sample;
+    State received, previous;
+
+    for (size_t i = 0; i < 40; i++)
+    {
+        sample.uptime += 1 + i % 2;
+        if (i % 4 == 1)
+            sample.used += 4096;
+        if (i % 5 == 2)
+            sample.usage = static_cast<double>(i) * 1.25;
+        sample.idle[i % 2] = 100.0 - static_cast<double>(i);
+        sample.mounts = 1 + i / 3 % 3;
+        sample.alert = i % 7 < 2;
+
+        const State expected = stateOf(sample);
+        const Message message = encode(encoder, sample);
+        CHECK(message.keyframe == (i == 0));
+        if (message.keyframe)
+        {
+            CHECK(message.report == toJson(sample));
+            received = expected;
+        }
+        else
+        {
+            map<string, string> changed;
+            for (const auto &[path, text] : expected)
+            {
+                if (auto it = previous.find(path); it == previous.end() || it->second != text)
+                    changed.emplace(path, text);
+            }
+            std::set<string> gone;
+            for (const auto &[path, text] : previous)
+            {
+                if (!expected.contains(path))
+                    gone.insert(path);
+            }
+            CHECK(message.set == changed);
+            CHECK(message.remove == gone);
+
+            for (const auto &[path, text] : message.set)
+                received[path] = text;
+            for (const auto &path : message.remove)
+                received.erase(path);
+        }
+        CHECK(received == expected);
+        previous = expected;
+    }
+}
+
+/**
+ * @brief Values covered by a deadband are only sent once they moved past it from the value
+ *        last sent, which a keyframe resets.
+ */
+static void testDeadband()
+{
+    DeltaConfig config{.keyframe_interval = 1000};
+    for (const char *spec : {"cpu.usage=5", "memory.used=10%", "cores.*.idle=2"})
+        config.deadbands.push_back(*parseDeadband(spec));
+    DeltaEncoder encoder(config);
+
+    Sample sample;
+    CHECK(encode(encoder, sample).keyframe);
+
+    // all within their deadband, but core 1
+    sample.uptime++;
+    sample.usage = 54.0;
+    sample.used = 1090;
+    sample.idle[0] = 91.5;
+    sample.idle[1] = 83.0;
+    CHECK((encode(encoder, sample).set == map<string, string>{{"uptime", "101"}, {"cpu.cores.1.idle", "83.0"}}));
+
+    // drifted past them from the values last sent, not from the previous report
+    sample.uptime++;
+    sample.usage = 55.5;
+    sample.used = 1120;
+    sample.idle[0] = 92.5;
+    CHECK((encode(encoder, sample).set == map<string, string>{{"uptime", "102"},
+                                                               {"cpu.usage", "55.5"},
+                                                               {"memory.used", "1120"},
+                                                               {"cpu.cores.0.idle", "92.5"}}));
+
+    // 10% of 1120 is 112
+    sample.uptime++;
+    sample.usage = 51.0;
+    sample.used = 1000;
+    CHECK((encode(encoder, sample).set == map<string, string>{{"uptime", "103"}, {"memory.used", "1000"}}));
+
+    // a keyframe sends every value, and the deadbands start over from them
+    encoder.requestKeyframe();
+    sample.usage = 53.0;
+    CHECK(encode(encoder, sample).keyframe);
+    sample.usage = 57.0;
+    CHECK(encode(encoder, sample).set.empty());
+    sample.usage = 58.5;
+    CHECK((encode(encoder, sample).set == map<string, string>{{"cpu.usage", "58.5"}}));
+
+    // absolute and relative thresholds, and specs that are rejected
+    CHECK(parseDeadband("memory.used=10%")->relative);
+    CHECK(!parseDeadband("cpu.usage=5")->relative);
+    CHECK(!parseDeadband("=5").has_value());
+    CHECK(!parseDeadband("cpu.usage=").has_value());
+    CHECK(!parseDeadband("cpu.usage=-1").has_value());
+    CHECK(!parseDeadband("cpu.usage=5x").has_value());
+    CHECK(!parseDeadband("cpu.usage").has_value());
+}
+
+/**
+ * @brief Tells keyframes from deltas, in every format the encoder writes.
+ */
+static void testIsDelta()
+{
+    FlatWriter flat;
+    Sample sample;
+    writeReport(flat, sample);
+
+    for (const bool pretty : {false, true})
+    {
+        for (const auto format : {ReportFormat::json, ReportFormat::cbor})
+        {
+            DeltaEncoder encoder({.keyframe_interval = 3}, pretty);
+            const string keyframe(encoder.encode(flat.entries(), format));
+            const string delta(encoder.encode(flat.entries(), format));
+            CHECK(!DeltaEncoder::isDelta(keyframe));
+            CHECK(DeltaEncoder::isDelta(delta));
+            CHECK(!DeltaEncoder::isDelta(encoder.encode(flat.entries(), format, true)));
+
+            // cut before the "set" key, the header is incomplete
+            const size_t set_key = delta.find("set");
+            CHECK(set_key != string::npos);
+            for (size_t size = 0; size < set_key; size++)
+                CHECK(!DeltaEncoder::isDelta(string_view(delta).substr(0, size)));
+        }
+    }
+
+    // plain reports and batches are not messages of a stream
+    CborWriter cbor;
+    writeReport(cbor, sample);
+    CHECK(!DeltaEncoder::isDelta(toJson(sample)));
+    CHECK(!DeltaEncoder::isDelta(cbor.view()));
+    CHECK(!DeltaEncoder::isDelta(R"({"set": {}})"));
+    CHECK(!DeltaEncoder::isDelta("[]"));
+    CHECK(!DeltaEncoder::isDelta(""));
+}
+
+/**
+ * @brief A keyframe rebuilt from the leaves of a real report is the report toJson() writes.
+ */
+static void testSystemInfoKeyframe()
+{
+    SystemInfo sysinfo;
+    CHECK(!sysinfo.readSysInfo().has_value());
+    DeltaEncoder encoder({});
+    Message message;
+    CHECK(parse(encoder.encode(sysinfo, ReportFormat::json), message));
+    CHECK(message.keyframe);
+    CHECK(message.report == sysinfo.toJson());
+}
+
+int main()
+{
+    testKeyframes();
+    testRebuild();
+    testDeadband();
+    testIsDelta();
+    testSystemInfoKeyframe();
+    return test::result();
+}
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "Check.hpp"
+#include "FsProbePool.hpp"
+
+using namespace std;
+using namespace ob;
+
+namespace
+{
+    constexpr unsigned timeout_ms = 20;
+    /** What a round may take: four timeouts, plus scheduling noise. */
+    constexpr auto round_bound = chrono::milliseconds(4 * timeout_ms + 100);
+
+    mutex hung_mutex;
+    condition_variable hung_cv;
+    bool released = false;
+}
+
+/**
+ * @brief Stands in for statfs(): "/hung*" blocks until released, "/slow*" overruns the
+ *        timeout once, "/fail*" fails and anything else returns its path length as f_blocks.
+ */
+static int fakeStatfs(const char *path, struct statfs *buf)
+{
+    const string_view p(path);
+    if (p.starts_with("/hung"))
+    {
+        unique_lock<mutex> lock(hung_mutex);
+        hung_cv.wait(lock, [] { return released; });
+    }
+    else if (p.starts_with("/slow"))
+    {
+        this_thread::sleep_for(chrono::milliseconds(3 * timeout_ms));
+    }
+    else if (p.starts_with("/fail"))
+    {
+        return -1;
+    }
+    memset(buf, 0, sizeof(*buf));
+    buf->f_blocks = p.size();
+    return 0;
+}
+
+static vector<shared_ptr<FsProbe>> makeProbes(const string &prefix, size_t count)
+{
+    vector<shared_ptr<FsProbe>> probes;
+    for (size_t i = 0; i < count; i++)
+        probes.push_back(make_shared<FsProbe>(FsProbe{.path = prefix + to_string(i)}));
+    return probes;
+}
+
+static FsProbe::status statusOf(FsProbePool &pool, const FsProbe &probe)
+{
+    struct statfs s;
+    return pool.result(probe, s);
+}
+
+/**
+ * @brief Runs one round, the way MountCollector does, and checks that it stays bounded.
+ */
+static void runRound(FsProbePool &pool, const shared_ptr<FsProbe> &root,
+                     const vector<vector<shared_ptr<FsProbe>> *> &groups)
+{
+    pool.beginRound();
+    for (const auto *group : groups)
+    {
+        for (const auto &probe : *group)
+            pool.submit(probe);
+    }
+    pool.submit(root, true);
+
+    const auto start = chrono::steady_clock::now();
+    pool.wait(timeout_ms);
+    CHECK(chrono::steady_clock::now() - start < round_bound);
+}
+
+/**
+ * @brief Hung mounts queued ahead of healthy ones only delay them until their workers are
+ *        replaced, the root never waits, and hung probes are held back once they return.
+ */
+static void testHungMounts()
+{
+    FsProbePool pool(2, 16, fakeStatfs);
+    const auto root = make_shared<FsProbe>(FsProbe{.path = "/"});
+    auto hung = makeProbes("/hung", 12);
+    auto healthy = makeProbes("/data", 4);
+
+    for (int round = 1; round <= 6; round++)
+    {
+        runRound(pool, root, {&hung, &healthy});
+        CHECK(statusOf(pool, *root) == FsProbe::status::ok);
+        for (const auto &probe : hung)
+            CHECK(statusOf(pool, *probe) == FsProbe::status::stale);
+        // the two workers are replaced as they overrun, a few per round
+        if (round >= 3)
+        {
+            for (const auto &probe : healthy)
+                CHECK(statusOf(pool, *probe) == FsProbe::status::ok);
+        }
+    }
+
+    {
+        lock_guard<mutex> lock(hung_mutex);
+        released = true;
+    }
+    hung_cv.notify_all();
+    this_thread::sleep_for(chrono::milliseconds(timeout_ms));
+
+    // in flight for several rounds, so left out for as many
+    runRound(pool, root, {&hung, &healthy});
+    for (const auto &probe : hung)
+        CHECK(statusOf(pool, *probe) == FsProbe::status::stale);
+
+    bool recovered = false;
+    for (int round = 0; round < 12 && !recovered; round++)
+    {
+        runRound(pool, root, {&hung, &healthy});
+        recovered = true;
+        for (const auto &probe : hung)
+            recovered &= statusOf(pool, *probe) == FsProbe::status::ok;
+    }
+    CHECK(recovered);
+    for (const auto &probe : healthy)
+        CHECK(statusOf(pool, *probe) == FsProbe::status::ok);
+}
+
+/**
+ * @brief With more hung mounts than threads, rounds stay bounded and the root is still probed.
+ */
+static void testThreadLimit()
+{
+    {
+        lock_guard<mutex> lock(hung_mutex);
+        released = false;
+    }
+    FsProbePool pool(2, 4, fakeStatfs);
+    const auto root = make_shared<FsProbe>(FsProbe{.path = "/"});
+    auto hung = makeProbes("/hung", 8);
+
+    for (int round = 0; round < 4; round++)
+    {
+        runRound(pool, root, {&hung});
+        CHECK(statusOf(pool, *root) == FsProbe::status::ok);
+    }
+
+    {
+        lock_guard<mutex> lock(hung_mutex);
+        released = true;
+    }
+    hung_cv.notify_all();
+}
+
+static void testSlowAndFailing()
+{
+    FsProbePool pool(2, 16, fakeStatfs);
+    const auto root = make_shared<FsProbe>(FsProbe{.path = "/"});
+    auto probes = makeProbes("/slow", 1);
+    probes.push_back(make_shared<FsProbe>(FsProbe{.path = "/fail"}));
+
+    runRound(pool, root, {&probes});
+    CHECK(statusOf(pool, *probes[0]) == FsProbe::status::stale);
+    CHECK(statusOf(pool, *probes[1]) == FsProbe::status::failed);
+
+    // the last values of a stale probe are still reported
+    this_thread::sleep_for(chrono::milliseconds(3 * timeout_ms));
+    runRound(pool, root, {&probes});
+    struct statfs s;
+    CHECK(pool.result(*probes[0], s) == FsProbe::status::stale);
+    CHECK(s.f_blocks == probes[0]->path.size());
+}
+
+int main()
+{
+    testHungMounts();
+    testThreadLimit();
+    testSlowAndFailing();
+    // let the released workers leave statfs() before the process exits
+    this_thread::sleep_for(chrono::milliseconds(timeout_ms));
+    return test::result();
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Arena.hpp"
+#include "BlockDeviceCollector.hpp"
+#include "CgroupCollector.hpp"
+#include "Check.hpp"
+#include "CpuCollector.hpp"
+#include "JsonWriter.hpp"
+#include "MetricSchema.hpp"
+#include "MountCollector.hpp"
+#include "NetworkCollector.hpp"
+#include "PressureCollector.hpp"
+#include "ProcessCollector.hpp"
+#include "SystemInfo.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * Serializes one instance of every Schema<T> as JSON, in the binary layout and as Prometheus
+ * text, and checks that the three agree on the field names, their number, order and values.
+ */
+
+/**
+ * @struct Member
+ * @brief A field as one serializer wrote it: numbers as doubles, strings as text.
+ */
+struct Member
+{
+    string name;
+    bool is_string = false;
+    string text;
+    double number = 0;
+
+    bool operator==(const Member &) const = default;
+};
+
+/**
+ * @brief Gives field @p index of @p s a value of its own, through the member it is read from.
+ */
+template <typename S, typename T, auto... Path>
+static void fill(S &s, const Field<T, Path...> &, int index)
+{
+    auto &member = const_cast<remove_cvref_t<decltype(detail::resolve<Path...>(s))> &>(detail::resolve<Path...>(s));
+    using M = remove_cvref_t<decltype(member)>;
+    if constexpr (is_array_v<M>)
+        snprintf(member, sizeof(member), "s%d", index);
+    else if constexpr (is_same_v<M, string>)
+        member = "s" + to_string(index);
+    else if constexpr (is_same_v<M, bool>)
+        member = index % 2;
+    else
+        member = static_cast<M>(index + 1);
+}
+
+/**
+ * @brief Reads the members of a plain, flat JsonWriter object.
+ */
+static vector<Member> parseJson(string_view json)
+{
+    vector<Member> members;
+    size_t pos = 1;
+    while (pos < json.size() && json[pos] == '"')
+    {
+        const size_t name_end = json.find('"', pos + 1);
+        Member m{string(json.substr(pos + 1, name_end - pos - 1))};
+        pos = name_end + 2; // past the colon
+        if (json[pos] == '"')
+        {
+            const size_t end = json.find('"', pos + 1);
+            m.is_string = true;
+            m.text = json.substr(pos + 1, end - pos - 1);
+            pos = end + 1;
+        }
+        else
+        {
+            const size_t end = json.find_first_of(",}", pos);
+            const string text(json.substr(pos, end - pos));
+            m.number = text == "true" ? 1 : text == "false" ? 0 : strtod(text.c_str(), nullptr);
+            pos = end;
+        }
+        members.push_back(std::move(m));
+        if (json[pos] == ',')
+            pos++;
+        else
+            break;
+    }
+    return members;
+}
+
+/**
+ * @brief Reads a packed binary record back with the types of the schema of @p S.
+ * @return The members, and in @p consumed the bytes read; SIZE_MAX if the record is too short.
+ */
+template <typename S>
+static vector<Member> parseBinary(string_view bin, size_t &consumed)
+{
+    vector<Member> members;
+    size_t pos = 0;
+    forEachField<S>([&](const auto &f)
+    {
+        using T = typename remove_cvref_t<decltype(f)>::type;
+        Member m{string(f.name)};
+        const size_t fixed = detail::is_string_v<T> ? sizeof(uint16_t) : sizeof(T);
+        if (pos > bin.size() || bin.size() - pos < fixed)
+        {
+            pos = SIZE_MAX;
+            return;
+        }
+        if constexpr (detail::is_string_v<T>)
+        {
+            uint16_t size;
+            memcpy(&size, bin.data() + pos, sizeof(size));
+            if (bin.size() - pos - sizeof(size) < size)
+            {
+                pos = SIZE_MAX;
+                return;
+            }
+            m.is_string = true;
+            m.text = bin.substr(pos + sizeof(size), size);
+            pos += sizeof(size) + size;
+        }
+        else
+        {
+            T value;
+            memcpy(&value, bin.data() + pos, sizeof(T));
+            m.number = static_cast<double>(value);
+            pos += sizeof(T);
+        }
+        members.push_back(std::move(m));
+    });
+    consumed = pos;
+    return members;
+}
+
+/**
+ * @brief Reads the metrics of a single-instance Prometheus exposition, and the labels of its
+ *        first sample, as numeric and string members.
+ */
+static void parsePrometheus(string_view text, string_view prefix, vector<Member> &numbers, vector<Member> &labels)
+{
+    size_t pos = 0;
+    while (pos < text.size())
+    {
+        const size_t end = text.find('\n', pos);
+        const string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (line.starts_with("#"))
+            continue;
+
+        const size_t name_end = line.find_first_of("{ ");
+        Member m{string(line.substr(prefix.size() + 1, name_end - prefix.size() - 1))};
+        m.number = strtod(string(line.substr(line.rfind(' ') + 1)).c_str(), nullptr);
+        numbers.push_back(std::move(m));
+
+        if (labels.empty() && line[name_end] == '{')
+        {
+            const string_view list = line.substr(name_end + 1, line.rfind('}') - name_end - 1);
+            for (size_t at = 0; at < list.size();)
+            {
+                const size_t eq = list.find('=', at);
+                const size_t close = list.find('"', eq + 2);
+                labels.push_back({string(list.substr(at, eq - at)), true, string(list.substr(eq + 2, close - eq - 2))});
+                at = close + 2;
+            }
+        }
+    }
+}
+
+template <typename S>
+static void checkSchema(const char *name)
+{
+    S s{};
+    int index = 0;
+    forEachField<S>([&](const auto &f) { fill(s, f, index++); });
+
+    JsonWriter json;
+    writeJson(json, s);
+    const auto from_json = parseJson(json.view());
+
+    string bin;
+    appendBinary(bin, s);
+    size_t consumed = 0;
+    const auto from_binary = parseBinary<S>(bin, consumed);
+
+    string prom;
+    appendPrometheus(prom, "t", s);
+    vector<Member> numbers, labels;
+    parsePrometheus(prom, "t", numbers, labels);
+
+    vector<Member> json_numbers, json_strings;
+    for (const auto &m : from_json)
+        (m.is_string ? json_strings : json_numbers).push_back(m);
+
+    if (!CHECK(static_cast<int>(from_json.size()) == index) || !CHECK(from_json == from_binary) ||
+        !CHECK(consumed == bin.size()) || !CHECK(numbers == json_numbers) || !CHECK(labels == json_strings))
+        fprintf(stderr, "  in Schema<%s>:\n  %.*s\n%s", name, static_cast<int>(json.view().size()), json.view().data(),
+                prom.c_str());
+
+    // names identify the fields in every format
+    for (size_t i = 0; i < from_json.size(); i++)
+    {
+        for (size_t j = i + 1; j < from_json.size(); j++)
+            CHECK(from_json[i].name != from_json[j].name);
+    }
+}
+
+int main()
+{
+    checkSchema<MemoryStats>("MemoryStats");
+    checkSchema<DiskStats>("DiskStats");
+    checkSchema<MountStats>("MountStats");
+    checkSchema<CpuUsage>("CpuUsage");
+    checkSchema<ProcessInfo>("ProcessInfo");
+    checkSchema<BlockDeviceStats>("BlockDeviceStats");
+    checkSchema<InterfaceStats>("InterfaceStats");
+    checkSchema<PressureLine>("PressureLine");
+    checkSchema<CgroupStats>("CgroupStats");
+    checkSchema<Arena::Stats>("Arena::Stats");
+    return test::result();
+}
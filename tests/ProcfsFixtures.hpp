@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef PROCFSFIXTURES_HPP
+#define PROCFSFIXTURES_HPP
+
+#include <string_view>
+
+/**
+ * Excerpts of procfs files, shared by the tokenizer test and its benchmark.
+ */
+namespace ob::fixtures
+{
+    /** Ends without a newline, as a truncated read would. */
+    inline constexpr std::string_view meminfo =
+        "MemTotal:        8029212 kB\n"
+        "MemFree:          512344 kB\n"
+        "MemAvailable:    4198732 kB\n"
+        "Buffers:          203916 kB\n"
+        "Cached:          3479344 kB\n"
+        "SwapCached:            0 kB\n"
+        "Active:          4185620 kB\n"
+        "Inactive:        2462168 kB\n"
+        "SwapTotal:       2097148 kB\n"
+        "SwapFree:        2097148 kB\n"
+        "Dirty:               228 kB\n"
+        "Shmem:            398708 kB\n"
+        "HugePages_Total:      16";
+
+    /** The intr line is longer than two AVX2 blocks. */
+    inline constexpr std::string_view stat =
+        "cpu  4705 356 584 3699176 23060 0 277 0 0 0\n"
+        "cpu0 1393280 32966 572056 13343292 6130 0 17875 0 0 0\n"
+        "cpu1 1335596 33107 549836 13420656 5741 0 14522 0 0 0\n"
+        "intr 114930548 113199788 3 0 5 263 0 4 0 1 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+        "ctxt 1990473\n"
+        "btime 1062191376\n"
+        "processes 2915\n"
+        "procs_running 1\n"
+        "procs_blocked 0\n";
+
+    inline constexpr std::string_view diskstats =
+        "   8       0 sda 102573 4135 7232662 64572 46437 74478 3512384 223988 0 75828 288560\n"
+        "   8       1 sda1 102470 4135 7226974 64520 46297 74478 3512384 223940 0 75748 288460\n"
+        " 259       0 nvme0n1 5021 0 270326 1096 16044 12213 1208770 7408 0 5740 8504 0 0 0 0 1330 1024\n";
+
+    /** Recent kernels pad the interface name, older ones glue the first counter to the colon. */
+    inline constexpr std::string_view net_dev =
+        "Inter-|   Receive                                                |  Transmit\n"
+        " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n"
+        "    lo: 2776770   11307    0    0    0     0          0         0  2776770   11307    0    0    0     0       0          0\n"
+        "  eth0:1215645    2751    0    0    0     0          0         0  1782404    4324    0    0    0   427       0          0\n";
+}
+
+#endif // PROCFSFIXTURES_HPP
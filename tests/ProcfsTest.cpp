@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "Check.hpp"
+#include "Procfs.hpp"
+#include "ProcfsFixtures.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * @brief Compares the vector scans with a plain search, with the match at every offset of
+ *        buffers spanning several AVX2 blocks.
+ */
+static void testScans()
+{
+    for (size_t size = 0; size <= 100; size++)
+    {
+        for (size_t at = 0; at <= size; at++)
+        {
+            string text(size, 'x');
+            if (at < size)
+                text[at] = '\n';
+            CHECK(procfs::findByte(text.data(), text.data() + size, '\n') == text.data() + at);
+
+            string words(size, 'x');
+            if (at < size)
+                words[at] = (at % 2) ? ' ' : '\t';
+            CHECK(procfs::findSpace(words.data(), words.data() + size) == words.data() + at);
+
+            string blanks(size, ' ');
+            if (at < size)
+                blanks[at] = 'y';
+            CHECK(procfs::skipSpaces(blanks.data(), blanks.data() + size) == blanks.data() + at);
+        }
+    }
+}
+
+static void testMeminfo()
+{
+    static constexpr auto keys = procfs::makeKeySet("MemTotal", "MemAvailable", "Cached", "HugePages_Total");
+    uint64_t values[keys.size()] = {};
+    bool straddled = false;
+    size_t lines = 0;
+
+    procfs::Scanner scanner(fixtures::meminfo);
+    procfs::Line line;
+    while (scanner.next(line))
+    {
+        const auto offset = static_cast<size_t>(line.rest().data() - fixtures::meminfo.data());
+        straddled |= offset / 32 != (offset + line.rest().size()) / 32;
+        lines++;
+
+        const auto key = line.key();
+        const int idx = keys.find(key);
+        if (idx >= 0)
+            CHECK(line.u64(values[idx]));
+        else
+            CHECK(key == "MemFree" || key == "Buffers" || key.starts_with("Swap") || key == "Active" ||
+                  key == "Inactive" || key == "Dirty" || key == "Shmem");
+    }
+
+    CHECK(straddled);
+    CHECK(lines == 13);
+    CHECK(values[0] == 8029212);
+    CHECK(values[1] == 4198732);
+    CHECK(values[2] == 3479344);
+    // the last line has no newline
+    CHECK(values[3] == 16);
+    CHECK(keys.find("MemFree") == -1);
+    CHECK(keys.find("") == -1);
+    CHECK(keys.find("MemTotal:") == -1);
+}
+
+static void testStat()
+{
+    procfs::Scanner scanner(fixtures::stat);
+    procfs::Line line;
+
+    CHECK(scanner.next(line));
+    CHECK(line.token() == "cpu");
+    vector<uint64_t> cpu;
+    for (uint64_t v; line.u64(v);)
+        cpu.push_back(v);
+    CHECK((cpu == vector<uint64_t>{4705, 356, 584, 3699176, 23060, 0, 277, 0, 0, 0}));
+    CHECK(line.empty());
+    CHECK(line.token().empty());
+
+    CHECK(scanner.next(line));
+    CHECK(line.token() == "cpu0");
+    line.skip(3);
+    CHECK(line.u64() == 13343292);
+
+    CHECK(scanner.next(line));
+    CHECK(scanner.next(line));
+    CHECK(line.rest().size() > 64);
+    CHECK(line.token() == "intr");
+    uint64_t sum = 0;
+    size_t count = 0;
+    for (uint64_t v; line.u64(v); count++)
+        sum += v;
+    CHECK(count == 35);
+    CHECK(sum == 114930548 + 113199788 + 3 + 5 + 263 + 4 + 1);
+
+    size_t rest = 0;
+    while (scanner.next(line))
+        rest++;
+    CHECK(rest == 5);
+    CHECK(!scanner.next(line));
+}
+
+static void testDiskstats()
+{
+    procfs::Scanner scanner(fixtures::diskstats);
+    procfs::Line line;
+    vector<string> names;
+    uint64_t major = 0, minor = 0;
+    while (scanner.next(line))
+    {
+        CHECK(line.u64(major) && line.u64(minor));
+        names.emplace_back(line.token());
+        if (names.back() == "sda1")
+        {
+            CHECK(line.u64() == 102470);
+            line.skip(8);
+            CHECK(line.u64() == 75748);
+        }
+    }
+    CHECK((names == vector<string>{"sda", "sda1", "nvme0n1"}));
+    CHECK(major == 259 && minor == 0);
+}
+
+static void testNetDev()
+{
+    procfs::Scanner scanner(fixtures::net_dev);
+    procfs::Line line;
+    scanner.next(line);
+    scanner.next(line);
+
+    CHECK(scanner.next(line));
+    CHECK(line.key() == "lo");
+    CHECK(line.u64() == 2776770);
+
+    CHECK(scanner.next(line));
+    CHECK(line.key() == "eth0");
+    CHECK(line.u64() == 1215645);
+    line.skip(7);
+    CHECK(line.u64() == 1782404);
+    line.skip(4);
+    CHECK(line.u64() == 427);
+
+    CHECK(!scanner.next(line));
+}
+
+static void testIntegers()
+{
+    int64_t i = 1;
+    string_view text = "-42.";
+    CHECK(procfs::Line(text.data(), text.data() + text.size()).i64(i) && i == -42);
+    text = "-";
+    CHECK(!procfs::Line(text.data(), text.data() + text.size()).i64(i));
+    uint64_t u = 1;
+    text = "kB";
+    CHECK(!procfs::Line(text.data(), text.data() + text.size()).u64(u));
+    text = "18446744073709551615";
+    CHECK(procfs::Line(text.data(), text.data() + text.size()).u64(u) && u == UINT64_MAX);
+}
+
+int main()
+{
+    testScans();
+    testMeminfo();
+    testStat();
+    testDiskstats();
+    testNetDev();
+    testIntegers();
+    return test::result();
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <cstdint>
+
+namespace ob::test
+{
+    /** Same values on every run, without depending on the standard library's distributions. */
+    struct Random
+    {
+        uint64_t state = 0x9e3779b97f4a7c15;
+
+        uint64_t next()
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+    };
+}
+
+#endif // RANDOM_HPP
@@ -0,0 +1,293 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <curl/curl.h>
+#include <fcntl.h>
+#include <map>
+#include <netinet/in.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Check.hpp"
+#include "EventLoop.hpp"
+#include "HTTPClient.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * Runs HTTPClient against utils/mock_server.py while it injects 503 responses, then lets
+ * it recover, and checks the retries against the server's log of the requests it answered:
+ * the backoff stays below the full-jitter ceiling, the circuit opens after
+ * `failure_threshold` failures and then sends one probe at a time, Retry-After is honored
+ * and every report is delivered exactly once. Skipped (77) without python3 and flask.
+ */
+
+namespace
+{
+    constexpr RetryConfig retry{.base_delay_ms = 100, .max_delay_ms = 800, .failure_threshold = 3, .max_queued = 64};
+    constexpr size_t max_in_flight = 4;
+    /** Server-side lag between the end of a request and the start of the next one. */
+    constexpr double slack_s = 0.15;
+    constexpr int outage_reports = 40;
+
+    /**
+     * @struct Request
+     * @brief One line of the server's /requests log.
+     */
+    struct Request
+    {
+        double start, end;
+        int status;
+        vector<int> uptimes;
+    };
+}
+
+static double monotonic_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double ceiling_s(unsigned failures)
+{
+    return min<double>(static_cast<double>(retry.base_delay_ms) * (1u << min(failures - 1, 16u)), retry.max_delay_ms) / 1000;
+}
+
+static int freePort()
+{
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t size = sizeof(addr);
+    bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr));
+    getsockname(fd, reinterpret_cast<struct sockaddr *>(&addr), &size);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+/**
+ * @brief Starts the mock server in a process group of its own, as its reloader forks.
+ */
+static pid_t startServer(int port)
+{
+    const string port_arg = to_string(port);
+    const pid_t pid = fork();
+    if (pid == 0)
+    {
+        setpgid(0, 0);
+        const int null_fd = open("/dev/null", O_WRONLY);
+        dup2(null_fd, STDOUT_FILENO);
+        dup2(null_fd, STDERR_FILENO);
+        execlp("python3", "python3", MOCK_SERVER, "--port", port_arg.c_str(), "--fail-rate", "1.0", "--status", "503",
+               "--delay", "0.1", static_cast<char *>(nullptr));
+        _exit(127);
+    }
+    return pid;
+}
+
+static size_t appendBody(char *data, size_t size, size_t count, void *body)
+{
+    static_cast<string *>(body)->append(data, size * count);
+    return size * count;
+}
+
+/**
+ * @brief Runs a blocking request to the server, outside the client under test.
+ * @return The status code, 0 if the server could not be reached.
+ */
+static long request(const string &url, const char *post_body, string &body)
+{
+    CURL *easy = curl_easy_init();
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, appendBody);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &body);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, 2000L);
+    struct curl_slist *headers = nullptr;
+    if (post_body)
+    {
+        headers = curl_slist_append(headers, "Content-Type: application/json");
+        curl_easy_setopt(easy, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(easy, CURLOPT_POSTFIELDS, post_body);
+    }
+    long status = 0;
+    if (curl_easy_perform(easy) == CURLE_OK)
+        curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &status);
+    curl_slist_free_all(headers);
+    curl_easy_cleanup(easy);
+    return status;
+}
+
+static void setFaults(const string &base, const char *settings)
+{
+    string body;
+    CHECK(request(base + "/fault", settings, body) == 200);
+}
+
+static vector<Request> serverLog(const string &base)
+{
+    string body;
+    CHECK(request(base + "/requests", nullptr, body) == 200);
+    vector<Request> log;
+    istringstream lines(body);
+    for (string line; getline(lines, line);)
+    {
+        istringstream fields(line);
+        Request r;
+        fields >> r.start >> r.end >> r.status;
+        for (int uptime; fields >> uptime;)
+            r.uptimes.push_back(uptime);
+        log.push_back(r);
+    }
+    // lines are written as requests end
+    ranges::stable_sort(log, {}, &Request::start);
+    return log;
+}
+
+static void runFor(EventLoop &loop, double seconds)
+{
+    const double until = monotonic_s() + seconds;
+    for (double now = monotonic_s(); now < until; now = monotonic_s())
+        loop.poll(static_cast<int>((until - now) * 1000) + 1);
+}
+
+static string report(int id)
+{
+    return R"({"hostname":"retry-test","uptime":)" + to_string(id) + R"(,"memory":{},"disk":{}})";
+}
+
+/**
+ * @brief Checks the retries of the failed requests in @p log.
+ */
+static void checkOutage(const vector<Request> &log)
+{
+    vector<const Request *> failures;
+    for (const auto &r : log)
+    {
+        if (r.status == 503)
+            failures.push_back(&r);
+    }
+    ranges::sort(failures, {}, &Request::end);
+    CHECK(failures.size() > retry.failure_threshold + 2);
+
+    // uploads resume before the backoff ceiling of the last failure, which set the pause
+    for (const auto &r : log)
+    {
+        const auto after = ranges::upper_bound(failures, r.start, {}, &Request::end);
+        if (after == failures.begin())
+            continue;
+        const size_t k = static_cast<size_t>(after - failures.begin());
+        const double gap = r.start - failures[k - 1]->end;
+        if (!CHECK(gap <= ceiling_s(k) + slack_s))
+            fprintf(stderr, "  failure %zu: next request %.3f s later, ceiling %.3f s\n", k, gap, ceiling_s(k));
+    }
+
+    // once open, the circuit lets a single probe through at a time
+    const double opened = failures[retry.failure_threshold - 1]->end;
+    const Request *previous = nullptr;
+    size_t probes = 0;
+    for (const auto &r : log)
+    {
+        if (r.start <= opened || r.status != 503)
+            continue;
+        if (previous)
+            CHECK(r.start >= previous->end);
+        previous = &r;
+        probes++;
+    }
+    CHECK(probes >= 2);
+}
+
+int main()
+{
+    if (system("python3 -c 'import flask' 2>/dev/null") != 0)
+    {
+        printf("python3 with flask is needed to run utils/mock_server.py, skipping\n");
+        return 77;
+    }
+
+    const int port = freePort();
+    const string base = "http://127.0.0.1:" + to_string(port);
+    const pid_t server = startServer(port);
+
+    string body;
+    bool up = false;
+    for (int i = 0; i < 100 && !up; i++)
+    {
+        usleep(100000);
+        body.clear();
+        up = request(base + "/requests", nullptr, body) == 200;
+    }
+    if (CHECK(up))
+    {
+        EventLoop loop;
+        map<int, int> delivered;
+        int given_up = 0;
+        HTTPClient client(loop, base + "/report", max_in_flight, [&](optional<HTTPClient::error> error, string_view payload)
+        {
+            if (error)
+                given_up++;
+            else
+                delivered[atoi(payload.data() + payload.find("\"uptime\":") + 9)]++;
+        }, retry);
+
+        // the server fails every request
+        for (int id = 0; id < outage_reports; id++)
+        {
+            client.post(report(id));
+            runFor(loop, 0.075);
+        }
+        checkOutage(serverLog(base));
+
+        // it recovers: every report goes through once
+        setFaults(base, R"({"fail_rate": 0.0})");
+        for (int i = 0; i < 100 && delivered.size() < outage_reports; i++)
+            runFor(loop, 0.1);
+
+        // one more failure, with a Retry-After that outlasts the backoff
+        setFaults(base, R"({"fail_rate": 1.0, "retry_after": 1, "delay": 0.0})");
+        const size_t before = serverLog(base).size();
+        client.post(report(outage_reports));
+        runFor(loop, 0.5);
+        setFaults(base, R"({"fail_rate": 0.0})");
+        for (int i = 0; i < 30 && !delivered.contains(outage_reports); i++)
+            runFor(loop, 0.1);
+
+        const auto log = serverLog(base);
+        if (CHECK(log.size() >= before + 2))
+        {
+            CHECK(log[before].status == 503);
+            CHECK(log[before + 1].start - log[before].end >= 1.0 - slack_s);
+        }
+
+        map<int, int> received;
+        for (const auto &r : log)
+        {
+            for (int uptime : r.uptimes)
+                received[uptime]++;
+        }
+        CHECK(given_up == 0);
+        for (int id = 0; id <= outage_reports; id++)
+        {
+            if (!CHECK(delivered[id] == 1 && received[id] == 1))
+                fprintf(stderr, "  report %d: delivered %d times, received %d times\n", id, delivered[id], received[id]);
+        }
+    }
+
+    kill(-server, SIGTERM);
+    waitpid(server, nullptr, 0);
+    return test::result();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <string_view>
+#include <variant>
+
+#include "Check.hpp"
+#include "FlatWriter.hpp"
+#include "SystemInfo.hpp"
+
+using namespace std;
+using namespace ob;
+
+/**
+ * @brief Returns the entry of @p flat at @p path, or nullptr.
+ */
+static const FlatWriter::Entry *find(const FlatWriter &flat, string_view path)
+{
+    for (const auto &entry : flat.entries())
+    {
+        if (entry.path == path)
+            return &entry;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief A mount table that cannot be read is reported, and every later collector still runs.
+ */
+static void testMountinfoFailure()
+{
+    // a directory opens, but read() fails with EISDIR
+    SystemInfoConfig config;
+    config.mountinfo_path = "/";
+    SystemInfo sysinfo(config);
+    FlatWriter flat;
+
+    for (int cycle = 0; cycle < 2; cycle++)
+    {
+        CHECK(sysinfo.readSysInfo() == SystemInfo::sysstats_error::failed_to_get_mount_stats);
+        sysinfo.flatten(flat);
+
+        const auto *mounts = find(flat, "mounts");
+        CHECK(mounts && get_if<FlatWriter::Empty>(&mounts->value));
+        // the root filesystem is still probed
+        const auto *disk_total = find(flat, "disk.total");
+        CHECK(disk_total && get<int64_t>(disk_total->value) > 0);
+
+        CHECK(find(flat, "cpu.cores.0.idle"));
+        const auto *procs_running = find(flat, "cpu.procs_running");
+        CHECK(procs_running && get<uint64_t>(procs_running->value) > 0);
+        const auto *processes = find(flat, "processes.total");
+        CHECK(processes && get<uint64_t>(processes->value) > 0);
+        CHECK(find(flat, "interfaces.0.name"));
+    }
+}
+
+int main()
+{
+    testMountinfoFailure();
+    return test::result();
+}
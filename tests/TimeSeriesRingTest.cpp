@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) 2025 Leo Soares
+ *
+ * SPDX-License-Identifier: Proprietary
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Check.hpp"
+#include "Random.hpp"
+#include "TimeSeriesRing.hpp"
+
+using namespace std;
+using namespace ob;
+using test::Random;
+
+namespace
+{
+    constexpr size_t capacity = 50;
+    constexpr size_t samples = 500;
+
+    /**
+     * @brief Samples as the ring should keep them, aggregated by a plain scan.
+     */
+    struct BruteForce
+    {
+        vector<int64_t> timestamps;
+        vector<map<string, double>> values;
+
+        optional<RangeSummary> query(const string &path, int64_t from_ms, int64_t to_ms) const
+        {
+            RangeSummary summary{0, INFINITY, -INFINITY, 0.0};
+            double sum = 0.0;
+            const size_t first = timestamps.size() > capacity ? timestamps.size() - capacity : 0;
+            for (size_t i = first; i < timestamps.size(); i++)
+            {
+                const auto it = values[i].find(path);
+                if (timestamps[i] < from_ms || timestamps[i] > to_ms || it == values[i].end())
+                    continue;
+                summary.count++;
+                summary.min = min(summary.min, it->second);
+                summary.max = max(summary.max, it->second);
+                sum += it->second;
+            }
+            if (summary.count == 0)
+                return {};
+            summary.avg = sum / static_cast<double>(summary.count);
+            return summary;
+        }
+
+        set<string> fields() const
+        {
+            set<string> paths;
+            const size_t first = timestamps.size() > capacity ? timestamps.size() - capacity : 0;
+            for (size_t i = first; i < timestamps.size(); i++)
+                for (const auto &[path, value] : values[i])
+                    paths.insert(path);
+            return paths;
+        }
+    };
+}
+
+static bool same(const optional<RangeSummary> &a, const optional<RangeSummary> &b)
+{
+    if (!a || !b)
+        return !a && !b;
+    return a->count == b->count && a->min == b->min && a->max == b->max && fabs(a->avg - b->avg) < 1e-9;
+}
+
+/**
+ * @brief Writes sample @p s, its fields coming and going in phases of 70 samples.
+ *
+ * f0 to f2 are always there; f3 to f7 take turns, so that a field absent for a whole ring
+ * gives its column to a new one. At most 7 fields are in the ring at once.
+ */
+static void writeSample(FlatWriter &flat, size_t s, Random &random, map<string, double> &kept)
+{
+    flat.reset();
+    flat.beginObject();
+    string path;
+    for (size_t f = 0; f < 8; f++)
+    {
+        if (f >= 3 && (s / 70 + f) % 3 != 0)
+            continue;
+        path.clear();
+        path.push_back('f');
+        path.append(to_string(f));
+        const double value = static_cast<double>(random.next() % 1000) / 10.0 - 50.0;
+        flat.member(path, value);
+        kept[path] = value;
+    }
+    // integers and bools are kept as doubles, strings are not kept
+    flat.member("count", static_cast<uint64_t>(s));
+    kept["count"] = static_cast<double>(s);
+    flat.member("delta", -static_cast<int64_t>(s % 13));
+    kept["delta"] = -static_cast<double>(s % 13);
+    flat.member("up", s % 4 == 0);
+    kept["up"] = s % 4 == 0 ? 1.0 : 0.0;
+    flat.member("name", "device");
+    flat.endObject();
+}
+
+/**
+ * @brief Compares random range queries with a scan of every sample kept, as fields come and
+ *        go, columns are reused and the clock steps back.
+ */
+static void testBruteForce()
+{
+    // 7 fields in phases, plus count, delta and up
+    TimeSeriesRing ring(capacity, 10);
+    BruteForce expected;
+    FlatWriter flat;
+    Random random;
+
+    int64_t clock = 1000;
+    string path;
+    for (size_t s = 0; s < samples; s++)
+    {
+        map<string, double> kept;
+        writeSample(flat, s, random, kept);
+        // the ring keeps timestamps in order, as if the clock had not stepped back
+        clock += random.next() % 3 == 0 ? -5 : 1000;
+        ring.add(clock, flat.entries());
+        expected.timestamps.push_back(expected.timestamps.empty() ? clock : max(clock, expected.timestamps.back()));
+        expected.values.push_back(std::move(kept));
+
+        for (int q = 0; q < 20; q++)
+        {
+            const size_t size = expected.timestamps.size();
+            const int64_t from = expected.timestamps[size > 60 ? size - 60 : 0] +
+                                 static_cast<int64_t>(random.next() % 60000) - 5000;
+            const int64_t to = from + static_cast<int64_t>(random.next() % 30000);
+            path.clear();
+            path.append(q == 19 ? "name" : "f");
+            if (q != 19)
+                path.append(to_string(random.next() % 8));
+            CHECK(same(ring.query(path, from, to), expected.query(path, from, to)));
+        }
+
+        const int64_t all_from = expected.timestamps.front(), all_to = expected.timestamps.back();
+        for (const string path : {"count", "delta", "up"})
+            CHECK(same(ring.query(path, all_from, all_to), expected.query(path, all_from, all_to)));
+
+        set<string> fields;
+        ring.forEachField([&](string_view path) { fields.emplace(path); });
+        CHECK(fields == expected.fields());
+    }
+
+    CHECK(ring.size() == capacity);
+    CHECK(ring.oldest() == expected.timestamps[samples - capacity]);
+    CHECK(ring.newest() == expected.timestamps.back());
+    CHECK(ring.droppedValues() == 0);
+    CHECK(!ring.query("f0", ring.newest(), ring.oldest()));
+    CHECK(!ring.query("missing", ring.oldest(), ring.newest()));
+}
+
+/**
+ * @brief Exact answers on a ring that wrapped around several times.
+ */
+static void testWrapAround()
+{
+    TimeSeriesRing ring(30, 4);
+    FlatWriter flat;
+    for (int64_t s = 0; s < 100; s++)
+    {
+        flat.reset();
+        flat.beginObject();
+        flat.member("a", s);
+        flat.endObject();
+        ring.add(s * 10, flat.entries());
+    }
+
+    auto summary = ring.query("a", 0, 10000);
+    CHECK(summary && summary->count == 30 && summary->min == 70 && summary->max == 99 && summary->avg == 84.5);
+    // bounds are inclusive, and the range crosses the end of the column
+    summary = ring.query("a", 890, 910);
+    CHECK(summary && summary->count == 3 && summary->min == 89 && summary->max == 91);
+    summary = ring.query("a", 705, 805);
+    CHECK(summary && summary->count == 10 && summary->min == 71 && summary->max == 80);
+    CHECK(!ring.query("a", 0, 690));
+    CHECK(!ring.query("a", 995, 2000));
+}
+
+/**
+ * @brief With too few columns, new fields are left out and the ones that fit stay exact.
+ */
+static void testFull()
+{
+    TimeSeriesRing ring(capacity, 3);
+    BruteForce expected;
+    FlatWriter flat;
+    Random random;
+
+    for (size_t s = 0; s < 200; s++)
+    {
+        map<string, double> kept;
+        writeSample(flat, s, random, kept);
+        ring.add(static_cast<int64_t>(s) * 1000, flat.entries());
+        expected.timestamps.push_back(static_cast<int64_t>(s) * 1000);
+        expected.values.push_back(std::move(kept));
+    }
+
+    CHECK(ring.droppedValues() > 0);
+    for (const string path : {"f0", "f1", "f2"})
+        CHECK(same(ring.query(path, 0, 200000), expected.query(path, 0, 200000)));
+    CHECK(!ring.query("count", 0, 200000));
+}
+
+int main()
+{
+    testBruteForce();
+    testWrapAround();
+    testFull();
+    return test::result();
+}
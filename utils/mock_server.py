@@ -1,39 +1,402 @@
+import argparse
+import gzip
 import json
-from flask import Flask, request, jsonify
+import os
+import random
+import struct
+import time
+from flask import Flask, g, request, jsonify
+
+try:
+    import zstandard
+except ImportError:
+    zstandard = None
+
+try:
+    import cbor2
+except ImportError:
+    cbor2 = None
 
 app = Flask(__name__)
 
+# reports are saved there when set, as training samples for train_dictionary.py
+save_dir = None
+# dictionary of --compression zstd-dict, matched against the X-Zstd-Dictionary-ID header
+zstd_dictionary = None
+# answer CBOR reports or columnar batches with 415, as a server that only knows JSON would
+reject_cbor = False
+reject_columnar = False
+
+# reports rebuilt from the messages of --keyframe-interval, by stream
+streams = {}
+
+# fault injection, to exercise the daemon's retries; set on the command line or through /fault
+faults = {
+    "fail_rate": 0.0,    # fraction of reports rejected
+    "status": 503,       # status code of the rejections
+    "retry_after": None, # Retry-After header of the rejections, in seconds
+    "delay": 0.0,        # seconds to wait before answering
+}
+
+# answered reports, for the tests to check the daemon's retries: (start, end, status, uptimes)
+request_log = []
+
+
+def validate_report(data, batched):
+    """Returns an error message if the report is invalid, None otherwise."""
+    if not isinstance(data, dict):
+        return "Report is not an object"
+
+    # Validation: Ensure required keys exist
+    required_fields = ["hostname", "uptime", "memory", "disk"]
+    if batched:
+        # every sample of a batch carries its own sampling time
+        required_fields.insert(0, "timestamp")
+    missing_fields = [field for field in required_fields if field not in data]
+
+    if missing_fields:
+        return f"Missing fields: {', '.join(missing_fields)}"
+
+    # validate field types
+    if not isinstance(data["hostname"], str) or not isinstance(data["uptime"], int):
+        return "Invalid field types"
+    if batched and not isinstance(data["timestamp"], int):
+        return "Invalid field types"
+
+    return None
+
+
+def decode_body():
+    """Returns the request body, decompressed according to its Content-Encoding."""
+    body = request.get_data()
+    encoding = request.headers.get("Content-Encoding", "identity")
+    if encoding == "gzip":
+        return gzip.decompress(body)
+    if encoding == "zstd":
+        if zstandard is None:
+            raise ValueError("zstd bodies need the zstandard module")
+        dictionary_id = request.headers.get("X-Zstd-Dictionary-ID")
+        if dictionary_id is None:
+            return zstandard.ZstdDecompressor().decompressobj().decompress(body)
+        if zstd_dictionary is None or int(dictionary_id) != zstd_dictionary.dict_id():
+            raise ValueError(f"Unknown zstd dictionary {dictionary_id}")
+        return zstandard.ZstdDecompressor(dict_data=zstd_dictionary).decompressobj().decompress(body)
+    if encoding != "identity":
+        raise ValueError(f"Unsupported Content-Encoding: {encoding}")
+    return body
+
+
+class BitReader:
+    """Reads the bit streams of a columnar batch, most significant bit first."""
+
+    def __init__(self, data):
+        self.data = data
+        self.bit = 0
+
+    def read(self, count):
+        value = 0
+        for _ in range(count):
+            byte = self.data[self.bit // 8]  # IndexError past the end
+            value = (value << 1) | ((byte >> (7 - self.bit % 8)) & 1)
+            self.bit += 1
+        return value
+
+    def read_varint(self):
+        value, shift = 0, 0
+        while True:
+            byte = self.read(8)
+            value |= (byte & 0x7F) << shift
+            if not byte & 0x80:
+                return value
+            shift += 7
+
+    def read_bytes(self, size):
+        start = self.bit // 8
+        if self.bit % 8 or start + size > len(self.data):
+            raise ValueError("Truncated columnar batch")
+        self.bit += size * 8
+        return self.data[start:start + size]
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def decode_column(reader, column_type, count):
+    """Returns the values of a column, as ColumnarWriter encodes them."""
+    values = []
+    previous, previous_delta, leading, trailing, previous_string = 0, 0, 0, 0, None
+    for i in range(count):
+        if column_type in (0, 1):  # integers, as zig-zag deltas modulo 2^64
+            previous = (previous + unzigzag(reader.read_varint())) % 2**64
+            values.append(previous - 2**64 if column_type == 0 and previous >= 2**63 else previous)
+        elif column_type == 7:  # timestamps, as delta-of-deltas
+            if i < 2:
+                delta = unzigzag(reader.read_varint())
+            else:
+                # a 0 bit ends the prefix, which picks the size of the value
+                value_bits = 64
+                for bits in (0, 7, 9, 12):
+                    if reader.read(1) == 0:
+                        value_bits = bits
+                        break
+                delta = previous_delta + unzigzag(reader.read(value_bits))
+            previous += delta
+            previous_delta = delta if i > 0 else 0
+            values.append(previous)
+        elif column_type == 2:  # doubles, XORed with the previous one
+            if i == 0:
+                previous = reader.read(64)
+            elif reader.read(1):
+                if reader.read(1):
+                    leading = reader.read(5)
+                    trailing = 64 - leading - (reader.read(6) + 1)
+                previous ^= reader.read(64 - leading - trailing) << trailing
+            values.append(struct.unpack("<d", previous.to_bytes(8, "little"))[0])
+        elif column_type == 3:
+            values.append(bool(reader.read(1)))
+        elif column_type == 4:  # strings, 0 when unchanged
+            size = reader.read_varint()
+            if size:
+                previous_string = bytes(reader.read(8) for _ in range(size - 1)).decode()
+            elif previous_string is None:
+                raise ValueError("Repeated string without a first value")
+            values.append(previous_string)
+        elif column_type in (5, 6):
+            values.append({} if column_type == 5 else [])
+        else:
+            raise ValueError(f"Unknown column type {column_type}")
+    return values
+
+
+def decode_columnar(body):
+    """Returns the samples of a batch encoded by the daemon's ColumnarWriter."""
+    if body[:4] != b"OBC\x01":
+        raise ValueError("Not a columnar batch")
+    reader = BitReader(body[4:])
+    samples = reader.read_varint()
+    leaves = [{} for _ in range(samples)]
+    for _ in range(reader.read_varint()):
+        path = reader.read_bytes(reader.read_varint()).decode()
+        column_type, has_presence = reader.read_bytes(2)
+        if has_presence:
+            bitmap = reader.read_bytes((samples + 7) // 8)
+            present = [i for i in range(samples) if bitmap[i // 8] >> (7 - i % 8) & 1]
+        else:
+            present = range(samples)
+        values = decode_column(BitReader(reader.read_bytes(reader.read_varint())), column_type, len(present))
+        for sample, value in zip(present, values):
+            leaves[sample][path] = value
+    # columns are in document order, so are the rebuilt members
+    return [unflatten(sample) for sample in leaves]
+
+
+def parse_body(body):
+    """Returns the reports in the body, parsed according to its Content-Type."""
+    content_type = request.headers.get("Content-Type", "application/json")
+    if content_type == "application/cbor":
+        if reject_cbor or cbor2 is None:
+            raise LookupError("CBOR reports are not accepted")
+        return cbor2.loads(body)
+    if content_type == "application/vnd.observabilityd.columnar":
+        if reject_columnar:
+            raise LookupError("Columnar batches are not accepted")
+        try:
+            return decode_columnar(body)
+        except (IndexError, UnicodeDecodeError) as e:
+            raise ValueError(f"Invalid columnar batch: {e}") from e
+    if content_type != "application/json":
+        raise LookupError(f"Unsupported Content-Type: {content_type}")
+    return json.loads(body)
+
+
+def flatten(value, path="", leaves=None):
+    """Returns the leaves of a report by path, as the daemon's FlatWriter records them."""
+    if leaves is None:
+        leaves = {}
+    if isinstance(value, (dict, list)) and value:
+        items = value.items() if isinstance(value, dict) else enumerate(value)
+        for key, item in items:
+            flatten(item, f"{path}.{key}" if path else str(key), leaves)
+    else:
+        leaves[path] = value
+    return leaves
+
+
+def unflatten(leaves):
+    """Rebuilds a report from its leaves; objects keyed by 0..n-1 are arrays."""
+    def to_arrays(node):
+        if not isinstance(node, dict) or not node:
+            return node
+        node = {key: to_arrays(item) for key, item in node.items()}
+        if not all(key.isdigit() for key in node):
+            return node
+        if sorted(map(int, node)) != list(range(len(node))):
+            raise ValueError(f"Array with missing elements: {sorted(node, key=int)}")
+        return [node[str(i)] for i in range(len(node))]
+
+    root = {}
+    for path, value in leaves.items():
+        node = root
+        *parents, last = path.split(".")
+        for segment in parents:
+            node = node.setdefault(segment, {})
+            if not isinstance(node, dict):
+                raise ValueError(f"Field {path} is inside a value")
+        node[last] = value
+    return to_arrays(root)
+
+
+def apply_delta(message):
+    """Returns the report a message of the delta protocol stands for, updating its stream.
+
+    Raises LookupError if the stream lacks the message before it, ValueError if it does not apply.
+    """
+    stream_id, sequence = message["stream"], message["sequence"]
+    stream = streams.get(stream_id)
+    if message.get("keyframe"):
+        report = message["report"]
+        # a keyframe older than the stream was spooled: a past report, the stream goes on
+        if stream is None or sequence >= stream["next"]:
+            streams[stream_id] = {"next": sequence + 1, "leaves": flatten(report)}
+        return report
+
+    if stream is None or sequence != stream["next"]:
+        expected = stream["next"] if stream else "a keyframe"
+        raise LookupError(f"Expected {expected} in stream {stream_id}, got {sequence}")
+    try:
+        leaves = stream["leaves"]
+        for path in message.get("remove", []):
+            del leaves[path]
+        leaves.update(message["set"])
+        stream["next"] = sequence + 1
+        return unflatten(leaves)
+    except (KeyError, ValueError) as e:
+        # the stream can only resume from a keyframe
+        del streams[stream_id]
+        raise ValueError(f"Delta {sequence} does not apply: {e}") from e
+
+
+@app.before_request
+def start_request():
+    g.start = time.monotonic()
+
+
+@app.after_request
+def log_request(response):
+    if request.path == "/report":
+        request_log.append((g.start, time.monotonic(), response.status_code, g.get("uptimes", [])))
+    return response
+
+
+@app.route("/requests", methods=["GET"])
+def requests():
+    """Lists the answered reports, one per line: start and end (CLOCK_MONOTONIC seconds), status
+    and the uptime of each accepted sample."""
+    lines = [" ".join([f"{start:.6f}", f"{end:.6f}", str(status)] + [str(u) for u in uptimes])
+             for start, end, status, uptimes in request_log]
+    return "".join(line + "\n" for line in lines), 200
+
+
+@app.route("/fault", methods=["POST"])
+def fault():
+    """Updates the fault injection settings, e.g. {"fail_rate": 1.0} to simulate an outage."""
+    settings = request.get_json(silent=True)
+    if not isinstance(settings, dict) or any(key not in faults for key in settings):
+        return jsonify({"error": f"Expected an object with keys among: {', '.join(faults)}"}), 400
+    faults.update(settings)
+    return jsonify(faults), 200
+
+
 @app.route("/report", methods=["POST"])
 def report():
+    if faults["delay"]:
+        time.sleep(faults["delay"])
+    if random.random() < faults["fail_rate"]:
+        print(f"injecting a {faults['status']} response")
+        response = jsonify({"error": "injected fault"})
+        if faults["retry_after"] is not None:
+            response.headers["Retry-After"] = str(faults["retry_after"])
+        return response, faults["status"]
+
     try:
         print("request.user_agent=" + str(request.user_agent))
-        print("request.data=" + str(request.data))
-        # Parse JSON request
-        data = request.get_json()
-        if data is None:
-            return jsonify({"error": "Invalid JSON"}), 400
-
-        # Validation: Ensure required keys exist
-        required_fields = ["hostname", "uptime", "memory", "disk"]
-        missing_fields = [field for field in required_fields if field not in data]
-
-        if missing_fields:
-            return (
-                jsonify({"error": f"Missing fields: {', '.join(missing_fields)}"}),
-                400,
-            )
-
-        # validate field types
-        if not isinstance(data["hostname"], str) or not isinstance(data["uptime"], int):
-            return jsonify({"error": "Invalid field types"}), 400
+        try:
+            body = decode_body()
+        except (OSError, ValueError) as e:
+            return jsonify({"error": str(e)}), 415
+        print(f"request.data={body} ({len(request.get_data())} bytes on the wire)")
+        try:
+            data = parse_body(body)
+        except LookupError as e:
+            return jsonify({"error": str(e)}), 415
+        except ValueError:
+            return jsonify({"error": "Invalid report"}), 400
+
+        # keyframes and deltas are checked by rebuilding the report they stand for
+        if isinstance(data, dict) and "stream" in data:
+            try:
+                data = apply_delta(data)
+            except LookupError as e:
+                return jsonify({"error": str(e)}), 409
+
+        # a batch is an array of reports, a single report is an object
+        batched = isinstance(data, list)
+        samples = data if batched else [data]
+        if batched and not samples:
+            return jsonify({"error": "Empty batch"}), 400
+
+        for sample in samples:
+            error = validate_report(sample, batched)
+            if error:
+                return jsonify({"error": error}), 400
 
         print("jsonifyed_data=\n" + json.dumps(data, indent=4, sort_keys=True))
+        g.uptimes = [sample["uptime"] for sample in samples]
 
-        return jsonify({"message": "Report received"}), 201
+        if save_dir:
+            extension = {"application/cbor": "cbor",
+                         "application/vnd.observabilityd.columnar": "obc"}.get(request.headers.get("Content-Type"), "json")
+            with open(os.path.join(save_dir, f"{time.time_ns()}.{extension}"), "wb") as f:
+                f.write(body)
+
+        return jsonify({"message": f"{len(samples)} report(s) received"}), 201
 
     except Exception as e:
         return jsonify({"error": str(e)}), 400
 
 
 if __name__ == "__main__":
-    app.run(host="0.0.0.0", port=8090, debug=True)
+    parser = argparse.ArgumentParser(description="Test server for observabilityd reports.")
+    parser.add_argument("--port", type=int, default=8090)
+    parser.add_argument("--fail-rate", type=float, default=0.0,
+                        help="fraction of reports rejected, between 0 and 1")
+    parser.add_argument("--status", type=int, default=503,
+                        help="status code of the rejected reports")
+    parser.add_argument("--retry-after", type=int,
+                        help="Retry-After header sent with the rejections, in seconds")
+    parser.add_argument("--delay", type=float, default=0.0,
+                        help="seconds to wait before answering")
+    parser.add_argument("--save-dir",
+                        help="directory where the reports are saved, e.g. to train the zstd dictionary")
+    parser.add_argument("--zstd-dictionary",
+                        default=os.path.join(os.path.dirname(os.path.abspath(__file__)), "report_dictionary.zdict"),
+                        help="dictionary of --compression zstd-dict (default: the one embedded in the daemon)")
+    parser.add_argument("--reject-cbor", action="store_true",
+                        help="answer CBOR reports with 415, to test the fallback to JSON")
+    parser.add_argument("--reject-columnar", action="store_true",
+                        help="answer columnar batches with 415, to test the fallback to JSON")
+    args = parser.parse_args()
+
+    save_dir = args.save_dir
+    reject_cbor = args.reject_cbor
+    reject_columnar = args.reject_columnar
+    if save_dir:
+        os.makedirs(save_dir, exist_ok=True)
+    if zstandard is not None and os.path.exists(args.zstd_dictionary):
+        with open(args.zstd_dictionary, "rb") as f:
+            zstd_dictionary = zstandard.ZstdCompressionDict(f.read())
+    faults.update(fail_rate=args.fail_rate, status=args.status,
+                  retry_after=args.retry_after, delay=args.delay)
+
+    app.run(host="0.0.0.0", port=args.port, debug=True)
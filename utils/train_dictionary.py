@@ -0,0 +1,70 @@
+"""Trains the zstd dictionary embedded in observabilityd for --compression zstd-dict.
+
+Samples are reports as sent by the daemon, one per file, as saved by
+`mock_server.py --save-dir`; batches are split into their reports. Train on reports
+from devices representative of the fleet, then rebuild the daemon:
+
+    python3 utils/train_dictionary.py samples/ -o utils/report_dictionary.zdict
+
+Needs the zstd command line tool. The server must decode with the same dictionary, so
+deploy the new one to both.
+"""
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+
+def split_samples(paths):
+    """Yields the reports of the sample files, as bytes."""
+    for path in paths:
+        with open(path, "rb") as f:
+            data = f.read()
+        try:
+            document = json.loads(data)
+        except ValueError:
+            print(f"skipping {path}: not JSON", file=sys.stderr)
+            continue
+        if isinstance(document, list):
+            # batches are re-serialized compactly, as the daemon sends single reports
+            for report in document:
+                report.pop("timestamp", None)
+                yield json.dumps(report, separators=(",", ":")).encode()
+        else:
+            yield data
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("samples", nargs="+", help="sample files, or directories of them")
+    parser.add_argument("-o", "--output", required=True, help="dictionary file to write")
+    parser.add_argument("--size", type=int, default=16384,
+                        help="dictionary size in bytes, embedded in the daemon (default: 16384)")
+    args = parser.parse_args()
+
+    paths = []
+    for sample in args.samples:
+        if os.path.isdir(sample):
+            paths.extend(os.path.join(sample, name) for name in sorted(os.listdir(sample)))
+        else:
+            paths.append(sample)
+
+    with tempfile.TemporaryDirectory() as directory:
+        count = 0
+        for report in split_samples(paths):
+            with open(os.path.join(directory, f"{count:06}.json"), "wb") as f:
+                f.write(report)
+            count += 1
+        if count < 100:
+            print(f"warning: only {count} samples, the dictionary will be poor", file=sys.stderr)
+
+        subprocess.run(["zstd", "--train", "-q", "-f", f"--maxdict={args.size}", "-o", args.output,
+                        *[os.path.join(directory, name) for name in sorted(os.listdir(directory))]],
+                       check=True)
+    print(f"trained {args.output} on {count} reports")
+
+
+if __name__ == "__main__":
+    main()